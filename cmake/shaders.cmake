@@ -18,7 +18,12 @@ endif()
 message(NOTICE "slangc found in ${SLANGC_EXECUTABLE}")
 
 
+# The optional arguments are the defines of the shader permutation
 function(add_shader EXTENSION PROFILE CAPABILITY ENTRY_POINT SHADER_SOURCE SHADER_BINARIES SHADER_INCLUDE_DIR SHADER_DEPS)
+    set(SHADER_DEFINES)
+    foreach(DEFINE IN LISTS ARGN)
+        list(APPEND SHADER_DEFINES -D "${DEFINE}")
+    endforeach()
     set(LOCAL_PRODUCTS)
     if (DIRECTX_BACKEND)
         set(OUTPUT_DXIL "${SHADER_BINARIES}/${SHADER_NAME}.${EXTENSION}.dxil")
@@ -28,11 +33,14 @@ function(add_shader EXTENSION PROFILE CAPABILITY ENTRY_POINT SHADER_SOURCE SHADE
                     -profile  "${PROFILE}"
                     -entry    "${ENTRY_POINT}"
                     -I        "${SHADER_INCLUDE_DIR}"
+                    ${SHADER_DEFINES}
                     -o        "${OUTPUT_DXIL}"
                     "${SHADER_SOURCE}"
             DEPENDS "${SHADER_SOURCE}" ${SHADER_DEPS}
         )
         list(APPEND LOCAL_PRODUCTS "${OUTPUT_DXIL}")
+        set(GLOBAL_DXIL_PRODUCTS "${DXIL_PRODUCTS}")
+        set(DXIL_PRODUCTS "${GLOBAL_DXIL_PRODUCTS};${OUTPUT_DXIL}" PARENT_SCOPE)
     endif ()
     set(OUTPUT_SPV "${SHADER_BINARIES}/${SHADER_NAME}.${EXTENSION}.spv")
     add_custom_command(
@@ -43,12 +51,15 @@ function(add_shader EXTENSION PROFILE CAPABILITY ENTRY_POINT SHADER_SOURCE SHADE
                 -entry          "${ENTRY_POINT}"
                 -D              __SPIRV__
                 -I              "${SHADER_INCLUDE_DIR}"
+                ${SHADER_DEFINES}
                 -fvk-use-dx-layout
                 -o              "${OUTPUT_SPV}"
                 "${SHADER_SOURCE}"
         DEPENDS "${SHADER_SOURCE}" ${SHADER_DEPS}
     )
     list(APPEND LOCAL_PRODUCTS "${OUTPUT_SPV}")
+    set(GLOBAL_SPV_PRODUCTS "${SPV_PRODUCTS}")
+    set(SPV_PRODUCTS "${GLOBAL_SPV_PRODUCTS};${OUTPUT_SPV}" PARENT_SCOPE)
 
     set(GLOBAL_SHADER_PRODUCTS "${SHADER_PRODUCTS}")
     set(SHADER_PRODUCTS "${GLOBAL_SHADER_PRODUCTS};${LOCAL_PRODUCTS}" PARENT_SCOPE)
@@ -58,6 +69,8 @@ function(add_shaders TARGET_NAME BUILD_DIR SHADER_INCLUDE_DIR)
     set(SHADER_SOURCE_FILES ${ARGN})
     set(SHADER_BINARIES ${BUILD_DIR})
     set(SHADER_PRODUCTS)
+    set(SPV_PRODUCTS)
+    set(DXIL_PRODUCTS)
 
     list(LENGTH SHADER_SOURCE_FILES FILE_COUNT)
     if(FILE_COUNT EQUAL 0)
@@ -71,25 +84,78 @@ function(add_shaders TARGET_NAME BUILD_DIR SHADER_INCLUDE_DIR)
     set(SPIRV_CAPABILITY "SPIRV_1_5")
     foreach(SHADER_SOURCE IN LISTS SHADER_SOURCE_FILES)
         cmake_path(ABSOLUTE_PATH SHADER_SOURCE NORMALIZE)
-        cmake_path(GET SHADER_SOURCE STEM SHADER_NAME)
-        if(SHADER_SOURCE MATCHES ".comp.slang$")
-            add_shader("comp" "cs_6_6" "${SPIRV_CAPABILITY}" "main" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}")
-        elseif (SHADER_SOURCE MATCHES ".hull.slang$")
-            add_shader("hull" "hs_6_6" "${SPIRV_CAPABILITY}" "main" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}")
-        elseif (SHADER_SOURCE MATCHES ".domain.slang$")
-            add_shader("domain" "ds_6_6" "${SPIRV_CAPABILITY}" "main" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}")
-        elseif (SHADER_SOURCE MATCHES ".geom.slang$")
-            add_shader("geom" "gs_6_6" "${SPIRV_CAPABILITY}" "main" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}")
-        elseif (SHADER_SOURCE MATCHES ".vert.slang$")
-            add_shader("vert" "vs_6_6" "${SPIRV_CAPABILITY}" "vertexMain" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}")
-        elseif (SHADER_SOURCE MATCHES ".frag.slang$")
-            add_shader("frag" "ps_6_6" "${SPIRV_CAPABILITY}" "fragmentMain" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}")
-        elseif (NOT SHADER_SOURCE MATCHES ".inc.slang$")
-            add_shader("vert" "vs_6_6" "${SPIRV_CAPABILITY}" "vertexMain" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}")
-            add_shader("frag" "ps_6_6" "${SPIRV_CAPABILITY}" "fragmentMain" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}")
-        endif ()
+        cmake_path(GET SHADER_SOURCE STEM SHADER_BASE_NAME)
+        # A "// FEATURES: A B" line declares the feature bits of the source, in the order of their
+        # bits in the features key : one permutation named "name_<key>" is compiled for each key
+        # of SHADER_PERMUTATION_KEYS, the keys used by the materials
+        file(STRINGS "${SHADER_SOURCE}" SHADER_FEATURES REGEX "^// FEATURES:" LIMIT_COUNT 1)
+        string(REGEX REPLACE "^// FEATURES:" "" SHADER_FEATURES "${SHADER_FEATURES}")
+        separate_arguments(SHADER_FEATURES UNIX_COMMAND "${SHADER_FEATURES}")
+        list(LENGTH SHADER_FEATURES FEATURE_COUNT)
+        set(PERMUTATION_KEYS NONE)
+        if(FEATURE_COUNT GREATER 0)
+            if(NOT SHADER_PERMUTATION_KEYS)
+                message(FATAL_ERROR "${SHADER_SOURCE} has features but SHADER_PERMUTATION_KEYS is empty")
+            endif()
+            math(EXPR LAST_KEY "(1 << ${FEATURE_COUNT}) - 1")
+            foreach(KEY IN LISTS SHADER_PERMUTATION_KEYS)
+                if(KEY GREATER LAST_KEY)
+                    message(FATAL_ERROR "Permutation key ${KEY} has more bits than the features of ${SHADER_SOURCE}")
+                endif()
+            endforeach()
+            set(PERMUTATION_KEYS ${SHADER_PERMUTATION_KEYS})
+        endif()
+        foreach(KEY IN LISTS PERMUTATION_KEYS)
+            set(SHADER_NAME ${SHADER_BASE_NAME})
+            set(PERMUTATION_DEFINES)
+            if(NOT KEY STREQUAL "NONE")
+                set(SHADER_NAME ${SHADER_BASE_NAME}_${KEY})
+                set(BIT 0)
+                foreach(FEATURE IN LISTS SHADER_FEATURES)
+                    math(EXPR HAS_FEATURE "(${KEY} >> ${BIT}) & 1")
+                    if(HAS_FEATURE)
+                        list(APPEND PERMUTATION_DEFINES ${FEATURE})
+                    endif()
+                    math(EXPR BIT "${BIT} + 1")
+                endforeach()
+            endif()
+            if(SHADER_SOURCE MATCHES ".comp.slang$")
+                add_shader("comp" "cs_6_6" "${SPIRV_CAPABILITY}" "main" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}" ${PERMUTATION_DEFINES})
+            elseif (SHADER_SOURCE MATCHES ".hull.slang$")
+                add_shader("hull" "hs_6_6" "${SPIRV_CAPABILITY}" "main" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}" ${PERMUTATION_DEFINES})
+            elseif (SHADER_SOURCE MATCHES ".domain.slang$")
+                add_shader("domain" "ds_6_6" "${SPIRV_CAPABILITY}" "main" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}" ${PERMUTATION_DEFINES})
+            elseif (SHADER_SOURCE MATCHES ".geom.slang$")
+                add_shader("geom" "gs_6_6" "${SPIRV_CAPABILITY}" "main" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}" ${PERMUTATION_DEFINES})
+            elseif (SHADER_SOURCE MATCHES ".vert.slang$")
+                add_shader("vert" "vs_6_6" "${SPIRV_CAPABILITY}" "vertexMain" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}" ${PERMUTATION_DEFINES})
+            elseif (SHADER_SOURCE MATCHES ".frag.slang$")
+                add_shader("frag" "ps_6_6" "${SPIRV_CAPABILITY}" "fragmentMain" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}" ${PERMUTATION_DEFINES})
+            elseif (NOT SHADER_SOURCE MATCHES ".inc.slang$")
+                add_shader("vert" "vs_6_6" "${SPIRV_CAPABILITY}" "vertexMain" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}" ${PERMUTATION_DEFINES})
+                add_shader("frag" "ps_6_6" "${SPIRV_CAPABILITY}" "fragmentMain" ${SHADER_SOURCE} ${SHADER_BINARIES} ${SHADER_INCLUDE_DIR} "${SHADER_DEPS}" ${PERMUTATION_DEFINES})
+            endif ()
+        endforeach()
     endforeach()
 
+    # One archive per backend, read with a single memory mapping at runtime
+    set(OUTPUT_SPV_ARCHIVE "${SHADER_BINARIES}/spirv.pack")
+    add_custom_command(
+        OUTPUT  "${OUTPUT_SPV_ARCHIVE}"
+        COMMAND shader_packer "${OUTPUT_SPV_ARCHIVE}" ${SPV_PRODUCTS}
+        DEPENDS shader_packer ${SPV_PRODUCTS}
+    )
+    list(APPEND SHADER_PRODUCTS "${OUTPUT_SPV_ARCHIVE}")
+    if (DIRECTX_BACKEND)
+        set(OUTPUT_DXIL_ARCHIVE "${SHADER_BINARIES}/dxil.pack")
+        add_custom_command(
+            OUTPUT  "${OUTPUT_DXIL_ARCHIVE}"
+            COMMAND shader_packer "${OUTPUT_DXIL_ARCHIVE}" ${DXIL_PRODUCTS}
+            DEPENDS shader_packer ${DXIL_PRODUCTS}
+        )
+        list(APPEND SHADER_PRODUCTS "${OUTPUT_DXIL_ARCHIVE}")
+    endif ()
+
     add_custom_target(${TARGET_NAME} ALL
             DEPENDS ${SHADER_PRODUCTS}
             COMMENT "Compiling Shaders [${TARGET_NAME}]"
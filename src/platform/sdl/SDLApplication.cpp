@@ -56,6 +56,7 @@ namespace samples {
         app->init(config, windowHandle);
         try {
             app->onInit();
+            app->start();
             SDL_ShowWindow(windowHandle);
             // app->onResize();
             auto quit{false};
@@ -69,7 +70,7 @@ namespace samples {
                         break;
                     case SDL_EVENT_WINDOW_RESIZED:
                     case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
-                        app->onResize();
+                        app->resize();
                         break;
                     case SDL_EVENT_KEY_DOWN:
                         app->onKeyDown(static_cast<uint32_t>(event.key.scancode));
@@ -81,12 +82,18 @@ namespace samples {
                         break;
                     }
                 }
-                app->onUpdate();
-                app->onRender();
+                app->frame();
             }
+            app->stop();
             app->onDestroy();
             SDL_DestroyWindow(windowHandle);
         } catch (vireo::Exception& e) {
+            app->stop();
+            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, e.what(), "Fatal error", nullptr);
+            return 1;
+        } catch (std::exception& e) {
+            // Errors of the samples code, rethrown from the render thread by frame()
+            app->stop();
             SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, e.what(), "Fatal error", nullptr);
             return 1;
         }
@@ -12,6 +12,7 @@ namespace samples {
 
     HWND Win32Application::hwnd = nullptr;
     std::shared_ptr<Application> Win32Application::app{};
+    std::exception_ptr Win32Application::frameError{};
 
     struct MonitorEnumData {
         int  enumIndex{0};
@@ -123,17 +124,28 @@ namespace samples {
 
         try {
             app->onInit();
+            app->start();
             ShowWindow(hwnd, nCmdShow);
             auto msg = MSG{};
             while (msg.message != WM_QUIT) {
                 if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
                     TranslateMessage(&msg);
                     DispatchMessage(&msg);
+                    if (frameError) {
+                        std::rethrow_exception(frameError);
+                    }
                 }
             }
+            app->stop();
             app->onDestroy();
             return static_cast<char>(msg.wParam);
         } catch (vireo::Exception& e) {
+            app->stop();
+            MessageBoxA(nullptr, e.what(), "Fatal error", MB_OK);
+            return 1;
+        } catch (std::exception& e) {
+            // Errors of the samples code, rethrown from the render thread by frame()
+            app->stop();
             MessageBoxA(nullptr, e.what(), "Fatal error", MB_OK);
             return 1;
         }
@@ -158,14 +170,18 @@ namespace samples {
                 }
                 return 0;
             case WM_PAINT:
-                if (app) {
-                    app->onUpdate();
-                    app->onRender();
+                if (app && !frameError) {
+                    // An exception must not cross DispatchMessage(), it is rethrown by the messages loop
+                    try {
+                        app->frame();
+                    } catch (...) {
+                        frameError = std::current_exception();
+                    }
                 }
                 return 0;
             case WM_SIZE:
                 if (app) {
-                    app->onResize();
+                    app->resize();
                 }
                 return 0;
             case WM_CLOSE:
@@ -32,6 +32,8 @@ export namespace samples {
 
         static HWND hwnd;
         static std::shared_ptr<Application> app;
+        // Exception thrown by a frame, rethrown outside of the window procedure
+        static std::exception_ptr frameError;
 
         static bool dirExists(const std::string& dirName_in);
         static LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
@@ -17,6 +17,7 @@ export namespace samples {
 
         void init(const vireo::BackendConfiguration config, const vireo::PlatformWindowHandle& windowHandle) {
             this->windowHandle = windowHandle;
+            backend = config.backend;
             vireo = vireo::Vireo::create(config);
         }
 
@@ -34,8 +35,94 @@ export namespace samples {
 
         virtual void onKeyUp(std::uint32_t key) {}
 
+        // Starts the render thread if enabled, called by the platforms after onInit()
+        void start() {
+            if (renderThreadEnabled) {
+                renderThread = std::thread{&Application::renderLoop, this};
+            }
+        }
+
+        // Called by the platforms once per frame, after the input events
+        void frame() {
+            if (!renderThread.joinable()) {
+                onUpdate();
+                onRender();
+                return;
+            }
+            onUpdate();
+            const auto updated = updatedFrames.fetch_add(1, std::memory_order_release) + 1;
+            updatedFrames.notify_one();
+            // The next update runs while this one is rendered : the simulation is one frame ahead at most
+            auto rendering = renderingFrames.load(std::memory_order_acquire);
+            while (rendering != RENDER_FAILED && rendering < updated) {
+                renderingFrames.wait(rendering, std::memory_order_acquire);
+                rendering = renderingFrames.load(std::memory_order_acquire);
+            }
+            if (rendering == RENDER_FAILED) {
+                stop();
+                std::rethrow_exception(renderError);
+            }
+        }
+
+        // Called by the platforms when the window is resized, onResize() is deferred to the render thread
+        void resize() {
+            if (renderThread.joinable()) {
+                resizeRequested.store(true);
+            } else {
+                onResize();
+            }
+        }
+
+        // Waits for the end of the render thread, called by the platforms before onDestroy()
+        void stop() {
+            if (!renderThread.joinable()) { return; }
+            stopRequested.store(true);
+            updatedFrames.fetch_add(1, std::memory_order_release);
+            updatedFrames.notify_one();
+            renderThread.join();
+        }
+
     protected:
         vireo::PlatformWindowHandle windowHandle;
+        vireo::Backend backend{vireo::Backend::UNDEFINED};
         std::shared_ptr<vireo::Vireo> vireo;
+        // Set by the applications in onInit() : onRender() and onResize() are then called by a render thread
+        // while the input events and onUpdate() run on the platform thread, the state shared by both sides
+        // must be exchanged by the applications, with a TripleBuffer for example
+        bool renderThreadEnabled{false};
+
+    private:
+        static constexpr auto RENDER_FAILED = std::numeric_limits<std::uint64_t>::max();
+
+        std::thread                renderThread;
+        std::atomic<std::uint64_t> updatedFrames{0};
+        // Last update taken by the render thread
+        std::atomic<std::uint64_t> renderingFrames{0};
+        std::atomic<bool>          resizeRequested{false};
+        std::atomic<bool>          stopRequested{false};
+        // Written by the render thread before renderingFrames is set to RENDER_FAILED
+        std::exception_ptr         renderError;
+
+        void renderLoop() {
+            try {
+                auto rendering = std::uint64_t{0};
+                while (true) {
+                    // Waits for the next onUpdate()
+                    updatedFrames.wait(rendering, std::memory_order_acquire);
+                    if (stopRequested.load()) { return; }
+                    rendering = updatedFrames.load(std::memory_order_acquire);
+                    renderingFrames.store(rendering, std::memory_order_release);
+                    renderingFrames.notify_one();
+                    if (resizeRequested.exchange(false)) {
+                        onResize();
+                    }
+                    onRender();
+                }
+            } catch (...) {
+                renderError = std::current_exception();
+                renderingFrames.store(RENDER_FAILED, std::memory_order_release);
+                renderingFrames.notify_one();
+            }
+        }
     };
 }
\ No newline at end of file
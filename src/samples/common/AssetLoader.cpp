@@ -0,0 +1,140 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.assetloader;
+
+namespace samples {
+
+    void AssetLoader::onInit(
+        const std::shared_ptr<vireo::Vireo>& vireo,
+        WorkerPool& workerPool,
+        const std::shared_ptr<vireo::SubmitQueue>& graphicQueue,
+        const std::uint32_t framesInFlight) {
+        this->vireo = vireo;
+        workers = &workerPool;
+        this->graphicQueue = graphicQueue;
+        this->framesInFlight = framesInFlight;
+        transferQueue = vireo->createSubmitQueue(vireo::CommandType::TRANSFER, "Assets");
+    }
+
+    void AssetLoader::start(Task<> task) {
+        {
+            auto lock = std::lock_guard{mutex};
+            runningTasks += 1;
+        }
+        run(std::move(task));
+    }
+
+    AssetLoader::Detached AssetLoader::run(Task<> task) {
+        auto error = std::exception_ptr{};
+        try {
+            co_await task;
+        } catch (...) {
+            error = std::current_exception();
+        }
+        auto lock = std::lock_guard{mutex};
+        if (error) {
+            errors.push_back(error);
+        }
+        runningTasks -= 1;
+        resumed.notify_all();
+    }
+
+    void AssetLoader::onUpdate() {
+        frameCount += 1;
+        resumeFrameTasks(frameCount);
+        resumeRenderThreadTasks();
+        auto lock = std::lock_guard{mutex};
+        if (!errors.empty()) {
+            const auto error = errors.front();
+            errors.erase(errors.begin());
+            std::rethrow_exception(error);
+        }
+    }
+
+    void AssetLoader::onDestroy() {
+        while (true) {
+            if (!frameTasks.empty()) {
+                // No more frames, the queues are waited for instead
+                transferQueue->waitIdle();
+                graphicQueue->waitIdle();
+                resumeFrameTasks(std::numeric_limits<std::uint64_t>::max());
+                continue;
+            }
+            {
+                auto lock = std::unique_lock{mutex};
+                resumed.wait(lock, [this] { return runningTasks == 0 || !renderThreadTasks.empty(); });
+                if (runningTasks == 0 && renderThreadTasks.empty()) { break; }
+            }
+            resumeRenderThreadTasks();
+        }
+        workers->wait(jobs);
+        // Shutting down, the errors are ignored
+        errors.clear();
+    }
+
+    Task<> AssetLoader::submit(
+        const std::function<void(const std::shared_ptr<vireo::CommandList>&)> record,
+        const std::function<void(const std::shared_ptr<vireo::CommandList>&)> acquire) {
+        co_await onRenderThread();
+        const auto commandAllocator = vireo->createCommandAllocator(vireo::CommandType::TRANSFER);
+        const auto commandList = commandAllocator->createCommandList();
+        commandList->begin();
+        record(commandList);
+        commandList->end();
+        const auto semaphore = vireo->createSemaphore(vireo::SemaphoreType::TIMELINE, "Assets timeline");
+        transferQueue->submit(vireo::WaitStage::TRANSFER, semaphore, {commandList});
+
+        // Resumed by onUpdate(), before the frame submits its command lists : the barriers, and all the next
+        // commands of the graphic queue, run after the copies
+        const auto acquireCommandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
+        const auto acquireCommandList = acquireCommandAllocator->createCommandList();
+        acquireCommandList->begin();
+        acquire(acquireCommandList);
+        acquireCommandList->end();
+        graphicQueue->submit(
+            semaphore,
+            vireo::WaitStage::TRANSFER,
+            vireo::WaitStage::TRANSFER,
+            semaphore,
+            {acquireCommandList});
+
+        // The command lists and the staging buffers of the caller live until the fences of the frames in flight
+        // were waited for, as the uploads of the first frame
+        co_await afterFrames(framesInFlight + 1);
+    }
+
+    void AssetLoader::resumeRenderThreadTasks() {
+        auto tasks = std::vector<std::coroutine_handle<>>{};
+        {
+            auto lock = std::lock_guard{mutex};
+            tasks.swap(renderThreadTasks);
+        }
+        for (const auto task : tasks) {
+            task.resume();
+        }
+    }
+
+    void AssetLoader::resumeFrameTasks(const std::uint64_t frame) {
+        auto tasks = std::vector<std::coroutine_handle<>>{};
+        std::erase_if(frameTasks, [&](const FrameTask& task) {
+            if (task.frame > frame) { return false; }
+            tasks.push_back(task.handle);
+            return true;
+        });
+        // A resumed task can wait again
+        for (const auto task : tasks) {
+            task.resume();
+        }
+    }
+
+    void AssetLoader::resumeOnRenderThread(const std::coroutine_handle<> handle) {
+        auto lock = std::lock_guard{mutex};
+        renderThreadTasks.push_back(handle);
+        resumed.notify_all();
+    }
+
+}
@@ -0,0 +1,198 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.assetloader;
+
+import std;
+import vireo;
+import samples.common.workerpool;
+
+export namespace samples {
+
+    struct TaskPromiseBase {
+        std::coroutine_handle<> caller;
+        std::exception_ptr      exception;
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        // Resumes the awaiting coroutine, if any
+        auto final_suspend() noexcept {
+            struct Resume {
+                std::coroutine_handle<> caller;
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<>) noexcept {
+                    return caller ? caller : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            return Resume{caller};
+        }
+
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase {
+        std::optional<T> value;
+        void return_value(T result) { value = std::move(result); }
+    };
+
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase {
+        void return_void() {}
+    };
+
+    // Coroutine started when awaited, returning its result or rethrowing its exception to the awaiting coroutine
+    template <typename T = void>
+    class Task {
+    public:
+        struct promise_type : TaskPromise<T> {
+            Task get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        };
+
+        Task(Task&& other) noexcept : handle{std::exchange(other.handle, nullptr)} {}
+        Task& operator=(Task&&) = delete;
+        ~Task() {
+            if (handle) { handle.destroy(); }
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(const std::coroutine_handle<> caller) noexcept {
+            handle.promise().caller = caller;
+            return handle;
+        }
+
+        T await_resume() {
+            auto& promise = handle.promise();
+            if (promise.exception) {
+                std::rethrow_exception(promise.exception);
+            }
+            if constexpr (!std::is_void_v<T>) {
+                return std::move(*promise.value);
+            }
+        }
+
+    private:
+        explicit Task(const std::coroutine_handle<promise_type> handle) : handle{handle} {}
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    // Asynchronous assets loading with coroutines. A loading task awaits onWorker() to read and decode its
+    // files on a worker thread, then submit() to record its copies on the render thread : the copies run on
+    // a transfer queue, waited for by the graphic queue on the GPU, and the task is resumed on the render thread
+    // once the frames in flight are done. No thread blocks on the GPU. The renderer draws placeholders meanwhile.
+    class AssetLoader {
+    public:
+        // The copied resources are acquired by graphicQueue. The tasks are resumed by the threads of workerPool,
+        // which must have at least one worker : nothing waits for the jobs of the loader until onDestroy().
+        void onInit(
+            const std::shared_ptr<vireo::Vireo>& vireo,
+            WorkerPool& workerPool,
+            const std::shared_ptr<vireo::SubmitQueue>& graphicQueue,
+            std::uint32_t framesInFlight);
+
+        // Starts a task on the calling thread, until its first suspension
+        void start(Task<> task);
+
+        // Resumes the tasks waiting for the render thread or for the end of the frames in flight, and rethrows the
+        // errors of the finished tasks, called once per frame by the render thread before submitting the frame
+        void onUpdate();
+
+        // Runs the tasks until they are all done, called when the render thread is stopped
+        void onDestroy();
+
+        // Resumes the awaiting task on a worker thread
+        auto onWorker() {
+            struct Awaiter {
+                AssetLoader& loader;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(const std::coroutine_handle<> handle) const {
+                    loader.workers->submit([handle] { handle.resume(); }, &loader.jobs);
+                }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{*this};
+        }
+
+        // Resumes the awaiting task during the next onUpdate()
+        auto onRenderThread() {
+            struct Awaiter {
+                AssetLoader& loader;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(const std::coroutine_handle<> handle) const { loader.resumeOnRenderThread(handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{*this};
+        }
+
+        // Resumes the awaiting task, from the render thread, during the onUpdate() of the frame
+        // that comes the given number of frames later. The commands submitted before are then done.
+        auto afterFrames(const std::uint32_t frames) {
+            struct Awaiter {
+                AssetLoader&  loader;
+                std::uint64_t frame;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(const std::coroutine_handle<> handle) const { loader.frameTasks.push_back({frame, handle}); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{*this, frameCount + frames};
+        }
+
+        // Records the copies on the render thread and submits them to the transfer queue of the loader, signaling a
+        // timeline semaphore. Records the acquisition of the copied resources (their transitions from COPY_DST) and
+        // submits it to the graphic queue, waiting for the semaphore on the GPU, before the command lists of the frame.
+        // Completes once the frames in flight are done, the resources recorded by the copies can then be released.
+        Task<> submit(
+            std::function<void(const std::shared_ptr<vireo::CommandList>&)> record,
+            std::function<void(const std::shared_ptr<vireo::CommandList>&)> acquire);
+
+    private:
+        // Started and destroyed with its task
+        struct Detached {
+            struct promise_type {
+                Detached get_return_object() noexcept { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+        };
+
+        struct FrameTask {
+            std::uint64_t           frame;
+            std::coroutine_handle<> handle;
+        };
+
+        std::shared_ptr<vireo::Vireo>        vireo;
+        std::shared_ptr<vireo::SubmitQueue>  graphicQueue;
+        std::shared_ptr<vireo::SubmitQueue>  transferQueue;
+        // Tasks waiting for the end of the frames in flight, only used by the render thread
+        std::vector<FrameTask>               frameTasks;
+        std::uint32_t                        framesInFlight{0};
+        std::uint64_t                        frameCount{0};
+        std::mutex                           mutex;
+        std::condition_variable              resumed;
+        std::vector<std::coroutine_handle<>> renderThreadTasks;
+        std::vector<std::exception_ptr>      errors;
+        std::uint32_t                        runningTasks{0};
+        WorkerPool*                          workers{nullptr};
+        // Jobs of the loader in the shared pool, waited for by onDestroy() : a job can still use the loader
+        // after the end of the last task
+        WorkerPool::Counter                  jobs;
+
+        void resumeOnRenderThread(std::coroutine_handle<> handle);
+
+        void resumeRenderThreadTasks();
+
+        // Resumes the tasks waiting for frame, or all of them
+        void resumeFrameTasks(std::uint64_t frame);
+
+        Detached run(Task<> task);
+    };
+
+}
@@ -0,0 +1,289 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module;
+#if defined(__SSE__) || defined(_M_X64)
+#define BVH_SSE
+#include <xmmintrin.h>
+#endif
+module samples.common.bvh;
+
+namespace samples {
+
+    void BVH::build(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax) {
+        const auto count = static_cast<std::uint32_t>(boundsMin.size());
+        nodes.clear();
+        primitives.resize(count);
+        std::iota(primitives.begin(), primitives.end(), 0);
+        primitiveNodes.resize(count);
+        centroids.resize(count);
+        for (auto i = 0u; i < count; i++) {
+            centroids[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+        }
+        if (count > 0) {
+            nodes.reserve(2 * count / MAX_LEAF_SIZE + 1);
+            buildNode(0, count, INVALID);
+        }
+        centroids.clear();
+        dirtyNodes.assign(nodes.size(), 0);
+        nodeAreas.resize(nodes.size());
+
+        builtArea = 0.0f;
+        // Children are always after their parent, so the bounds are propagated bottom-up in reverse order
+        for (auto i = nodes.size(); i-- > 0;) {
+            nodeAreas[i] = updateNode(nodes[i], boundsMin, boundsMax);
+            builtArea += nodeAreas[i];
+        }
+        area = builtArea;
+    }
+
+    std::uint32_t BVH::buildNode(const std::uint32_t begin, const std::uint32_t end, const std::uint32_t parent) {
+        const auto index = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back({});
+        nodes[index].parent = parent;
+
+        // Up to four groups with two levels of median splits
+        std::pair<std::uint32_t, std::uint32_t> groups[4];
+        auto groupCount = 0;
+        if (end - begin <= MAX_LEAF_SIZE) {
+            groups[groupCount++] = {begin, end};
+        } else {
+            const auto middle = split(begin, end);
+            for (const auto& [first, last] : {std::pair{begin, middle}, std::pair{middle, end}}) {
+                if (last - first <= MAX_LEAF_SIZE) {
+                    groups[groupCount++] = {first, last};
+                } else {
+                    const auto quarter = split(first, last);
+                    groups[groupCount++] = {first, quarter};
+                    groups[groupCount++] = {quarter, last};
+                }
+            }
+        }
+
+        for (auto i = 0; i < 4; i++) {
+            nodes[index].child[i] = INVALID;
+            nodes[index].count[i] = 0;
+        }
+        for (auto i = 0; i < groupCount; i++) {
+            const auto [first, last] = groups[i];
+            if (last - first <= MAX_LEAF_SIZE) {
+                nodes[index].child[i] = first;
+                nodes[index].count[i] = last - first;
+                for (auto p = first; p < last; p++) {
+                    primitiveNodes[primitives[p]] = index;
+                }
+            } else {
+                // buildNode() grows nodes, don't keep a reference across the call
+                const auto child = buildNode(first, last, index);
+                nodes[index].child[i] = child;
+            }
+        }
+        return index;
+    }
+
+    std::uint32_t BVH::split(const std::uint32_t begin, const std::uint32_t end) {
+        // Median of the centroids along the largest axis
+        auto min = glm::vec3{std::numeric_limits<float>::max()};
+        auto max = glm::vec3{std::numeric_limits<float>::lowest()};
+        for (auto i = begin; i < end; i++) {
+            min = glm::min(min, centroids[primitives[i]]);
+            max = glm::max(max, centroids[primitives[i]]);
+        }
+        const auto extent = max - min;
+        const auto axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        const auto middle = begin + (end - begin) / 2;
+        std::nth_element(
+            primitives.begin() + begin,
+            primitives.begin() + middle,
+            primitives.begin() + end,
+            [&](const auto a, const auto b) { return centroids[a][axis] < centroids[b][axis]; });
+        return middle;
+    }
+
+    float BVH::updateNode(
+        Node& node,
+        const std::vector<glm::vec3>& boundsMin,
+        const std::vector<glm::vec3>& boundsMax) const {
+        auto area = 0.0f;
+        for (auto i = 0; i < 4; i++) {
+            auto min = glm::vec3{std::numeric_limits<float>::max()};
+            auto max = glm::vec3{std::numeric_limits<float>::lowest()};
+            if (node.count[i] > 0) {
+                for (auto p = node.child[i]; p < node.child[i] + node.count[i]; p++) {
+                    min = glm::min(min, boundsMin[primitives[p]]);
+                    max = glm::max(max, boundsMax[primitives[p]]);
+                }
+            } else if (node.child[i] != INVALID) {
+                const auto& child = nodes[node.child[i]];
+                for (auto j = 0; j < 4; j++) {
+                    min = glm::min(min, glm::vec3{child.minX[j], child.minY[j], child.minZ[j]});
+                    max = glm::max(max, glm::vec3{child.maxX[j], child.maxY[j], child.maxZ[j]});
+                }
+            }
+            // Empty slots keep an inverted box, never visible
+            node.minX[i] = min.x; node.minY[i] = min.y; node.minZ[i] = min.z;
+            node.maxX[i] = max.x; node.maxY[i] = max.y; node.maxZ[i] = max.z;
+            if (min.x <= max.x) {
+                const auto size = max - min;
+                area += size.x * size.y + size.y * size.z + size.z * size.x;
+            }
+        }
+        return area;
+    }
+
+    void BVH::refit(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax) {
+        if (boundsMin.size() != primitives.size()) {
+            build(boundsMin, boundsMax);
+            return;
+        }
+        area = 0.0f;
+        for (auto i = nodes.size(); i-- > 0;) {
+            nodeAreas[i] = updateNode(nodes[i], boundsMin, boundsMax);
+            area += nodeAreas[i];
+        }
+        if (area > builtArea * REBUILD_AREA_RATIO) {
+            build(boundsMin, boundsMax);
+        }
+    }
+
+    void BVH::refit(
+        const std::vector<glm::vec3>& boundsMin,
+        const std::vector<glm::vec3>& boundsMax,
+        const std::vector<std::uint32_t>& changed) {
+        if (boundsMin.size() != primitives.size()) {
+            build(boundsMin, boundsMax);
+            return;
+        }
+        // Nearly all the nodes would be marked, the linear pass is faster
+        if (changed.size() * 2 > primitives.size()) {
+            refit(boundsMin, boundsMax);
+            return;
+        }
+        // Mark the paths to the root, stopping at the already marked ones
+        auto first = static_cast<std::uint32_t>(nodes.size());
+        for (const auto primitive : changed) {
+            auto node = primitiveNodes[primitive];
+            while (node != INVALID && !dirtyNodes[node]) {
+                dirtyNodes[node] = 1;
+                first = std::min(first, node);
+                node = nodes[node].parent;
+            }
+        }
+        for (auto i = nodes.size(); i-- > first;) {
+            if (dirtyNodes[i]) {
+                const auto nodeArea = updateNode(nodes[i], boundsMin, boundsMax);
+                area += nodeArea - nodeAreas[i];
+                nodeAreas[i] = nodeArea;
+                dirtyNodes[i] = 0;
+            }
+        }
+        if (area > builtArea * REBUILD_AREA_RATIO) {
+            build(boundsMin, boundsMax);
+        }
+    }
+
+    void BVH::cull(const glm::mat4& viewProjection, std::vector<std::uint32_t>& visible) const {
+        visible.clear();
+        if (nodes.empty()) { return; }
+
+        // Gribb & Hartmann, the near plane is the one of a [-w, w] depth range : conservative for [0, w]
+        const auto row = [&](const int i) {
+            return glm::vec4{viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]};
+        };
+        const glm::vec4 planes[6] {
+            row(3) + row(0), row(3) - row(0),
+            row(3) + row(1), row(3) - row(1),
+            row(3) + row(2), row(3) - row(2),
+        };
+
+        // Node index and whether it is entirely inside the frustum
+        auto stack = std::vector<std::pair<std::uint32_t, bool>>{};
+        stack.reserve(64);
+        stack.push_back({0, false});
+        while (!stack.empty()) {
+            const auto [index, inside] = stack.back();
+            stack.pop_back();
+            const auto& node = nodes[index];
+
+            // Bit i set when the child i is outside, or crosses, at least one plane
+            auto outsideMask = 0;
+            auto crossingMask = 0;
+            if (!inside) {
+#ifdef BVH_SSE
+                auto outside = _mm_setzero_ps();
+                auto crossing = _mm_setzero_ps();
+                const auto zero = _mm_setzero_ps();
+                for (const auto& plane : planes) {
+                    // Farthest corner along the plane normal decides if the box is outside, the nearest one if it crosses
+                    const auto farX = _mm_load_ps(plane.x >= 0.0f ? node.maxX : node.minX);
+                    const auto farY = _mm_load_ps(plane.y >= 0.0f ? node.maxY : node.minY);
+                    const auto farZ = _mm_load_ps(plane.z >= 0.0f ? node.maxZ : node.minZ);
+                    const auto nearX = _mm_load_ps(plane.x >= 0.0f ? node.minX : node.maxX);
+                    const auto nearY = _mm_load_ps(plane.y >= 0.0f ? node.minY : node.maxY);
+                    const auto nearZ = _mm_load_ps(plane.z >= 0.0f ? node.minZ : node.maxZ);
+                    const auto a = _mm_set1_ps(plane.x);
+                    const auto b = _mm_set1_ps(plane.y);
+                    const auto c = _mm_set1_ps(plane.z);
+                    const auto d = _mm_set1_ps(plane.w);
+                    const auto farDistance = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(a, farX), _mm_mul_ps(b, farY)),
+                        _mm_add_ps(_mm_mul_ps(c, farZ), d));
+                    const auto nearDistance = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(a, nearX), _mm_mul_ps(b, nearY)),
+                        _mm_add_ps(_mm_mul_ps(c, nearZ), d));
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(farDistance, zero));
+                    crossing = _mm_or_ps(crossing, _mm_cmplt_ps(nearDistance, zero));
+                }
+                outsideMask = _mm_movemask_ps(outside);
+                crossingMask = _mm_movemask_ps(crossing);
+#else
+                for (const auto& plane : planes) {
+                    for (auto i = 0; i < 4; i++) {
+                        const auto farDistance =
+                            plane.x * (plane.x >= 0.0f ? node.maxX[i] : node.minX[i]) +
+                            plane.y * (plane.y >= 0.0f ? node.maxY[i] : node.minY[i]) +
+                            plane.z * (plane.z >= 0.0f ? node.maxZ[i] : node.minZ[i]) + plane.w;
+                        const auto nearDistance =
+                            plane.x * (plane.x >= 0.0f ? node.minX[i] : node.maxX[i]) +
+                            plane.y * (plane.y >= 0.0f ? node.minY[i] : node.maxY[i]) +
+                            plane.z * (plane.z >= 0.0f ? node.minZ[i] : node.maxZ[i]) + plane.w;
+                        outsideMask |= (farDistance < 0.0f ? 1 : 0) << i;
+                        crossingMask |= (nearDistance < 0.0f ? 1 : 0) << i;
+                    }
+                }
+#endif
+            }
+
+            for (auto i = 0; i < 4; i++) {
+                if (node.child[i] == INVALID || (outsideMask & (1 << i))) { continue; }
+                const auto childInside = inside || !(crossingMask & (1 << i));
+                if (node.count[i] > 0) {
+                    visible.insert(visible.end(),
+                        primitives.begin() + node.child[i],
+                        primitives.begin() + node.child[i] + node.count[i]);
+                } else if (childInside) {
+                    addAll(nodes[node.child[i]], visible);
+                } else {
+                    stack.push_back({node.child[i], false});
+                }
+            }
+        }
+    }
+
+    void BVH::addAll(const Node& node, std::vector<std::uint32_t>& visible) const {
+        for (auto i = 0; i < 4; i++) {
+            if (node.child[i] == INVALID) { continue; }
+            if (node.count[i] > 0) {
+                visible.insert(visible.end(),
+                    primitives.begin() + node.child[i],
+                    primitives.begin() + node.child[i] + node.count[i]);
+            } else {
+                addAll(nodes[node.child[i]], visible);
+            }
+        }
+    }
+
+}
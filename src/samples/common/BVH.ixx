@@ -0,0 +1,74 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.bvh;
+
+import std;
+import glm;
+
+export namespace samples {
+
+    // 4-wide bounding volume hierarchy over axis-aligned boxes.
+    // The bounds of the four children of a node are stored together so they are tested at once with SIMD.
+    class BVH {
+    public:
+        static constexpr std::uint32_t MAX_LEAF_SIZE{4};
+        // Rebuild when the refitted tree is that much larger than the built one
+        static constexpr float REBUILD_AREA_RATIO{2.0f};
+
+        void build(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax);
+
+        // Updates the bounds of all the nodes without changing the tree, rebuilds it if its quality degraded too much
+        void refit(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax);
+
+        // Updates the bounds of the ancestors of the changed boxes only, rebuilds the tree as the full refit.
+        // Falls back to the full refit when most of the boxes changed.
+        void refit(
+            const std::vector<glm::vec3>& boundsMin,
+            const std::vector<glm::vec3>& boundsMax,
+            const std::vector<std::uint32_t>& changed);
+
+        // Fills visible with the indices of the boxes intersecting the view frustum
+        void cull(const glm::mat4& viewProjection, std::vector<std::uint32_t>& visible) const;
+
+        auto size() const { return primitives.size(); }
+
+        auto getNodeCount() const { return nodes.size(); }
+
+    private:
+        static constexpr auto INVALID{std::numeric_limits<std::uint32_t>::max()};
+
+        struct alignas(16) Node {
+            float         minX[4], minY[4], minZ[4];
+            float         maxX[4], maxY[4], maxZ[4];
+            std::uint32_t child[4]; // node index for inner children, first index in primitives for the leaves
+            std::uint32_t count[4]; // 0 for inner children, boxes count for the leaves
+            std::uint32_t parent;
+        };
+
+        std::vector<Node>          nodes;
+        std::vector<std::uint32_t> primitives;     // boxes indices, each leaf is a range of this array
+        std::vector<std::uint32_t> primitiveNodes; // node containing each box, for the incremental refit
+        std::vector<std::uint8_t>  dirtyNodes;
+        std::vector<float>         nodeAreas;      // for the incremental refit
+        std::vector<glm::vec3>     centroids;      // build only
+        float                      builtArea{0.0f};
+        float                      area{0.0f};
+
+        std::uint32_t buildNode(std::uint32_t begin, std::uint32_t end, std::uint32_t parent);
+
+        std::uint32_t split(std::uint32_t begin, std::uint32_t end);
+
+        // Recomputes the children bounds of a node and returns its total surface area
+        float updateNode(
+            Node& node,
+            const std::vector<glm::vec3>& boundsMin,
+            const std::vector<glm::vec3>& boundsMax) const;
+
+        void addAll(const Node& node, std::vector<std::uint32_t>& visible) const;
+    };
+
+}
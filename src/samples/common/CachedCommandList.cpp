@@ -0,0 +1,42 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.cachedcommandlist;
+
+namespace samples {
+
+    CachedCommandList::Stats CachedCommandList::currentStats{};
+    CachedCommandList::Stats CachedCommandList::frameStats{};
+
+    void CachedCommandList::onInit(const std::shared_ptr<vireo::Vireo>& vireo, const vireo::CommandType type) {
+        commandAllocator = vireo->createCommandAllocator(type);
+        commandList = commandAllocator->createCommandList();
+        recorded = false;
+    }
+
+    const std::shared_ptr<vireo::CommandList>& CachedCommandList::update(
+        const std::uint64_t key,
+        const std::function<void(const std::shared_ptr<vireo::CommandList>&)>& record) {
+        if (recorded && key == this->key) {
+            currentStats.replayed += 1;
+            return commandList;
+        }
+        commandAllocator->reset();
+        commandList->begin();
+        record(commandList);
+        commandList->end();
+        this->key = key;
+        recorded = true;
+        currentStats.recorded += 1;
+        return commandList;
+    }
+
+    void CachedCommandList::endFrame() {
+        frameStats = currentStats;
+        currentStats = Stats{};
+    }
+
+}
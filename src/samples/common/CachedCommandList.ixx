@@ -0,0 +1,66 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.cachedcommandlist;
+
+import std;
+import vireo;
+
+export namespace samples {
+
+    // Command list recorded once and submitted again each frame while the state used by its commands is
+    // unchanged. This state is summarized by a key : extent, options, generation counters... Recreating a
+    // resource used by the commands, or writing the descriptor sets they bind, requires calling invalidate().
+    // Use one instance per frame in flight : the list is only recorded again after the fence of its frame.
+    class CachedCommandList {
+    public:
+        struct Stats {
+            std::uint32_t recorded{0};
+            std::uint32_t replayed{0};
+        };
+
+        void onInit(const std::shared_ptr<vireo::Vireo>& vireo, vireo::CommandType type = vireo::CommandType::GRAPHIC);
+
+        // Returns the command list, recorded again by record() between begin() and end() if needed
+        const std::shared_ptr<vireo::CommandList>& update(
+            std::uint64_t key,
+            const std::function<void(const std::shared_ptr<vireo::CommandList>&)>& record);
+
+        // The next update() records the commands again
+        void invalidate() { recorded = false; }
+
+        // Hash of the bytes of the values, which must not contain pointers : a recreated resource can reuse
+        // the address of the destroyed one
+        template <typename... Values>
+        static std::uint64_t makeKey(const Values&... values) {
+            auto key = std::uint64_t{0xcbf29ce484222325};
+            const auto hash = [&key](const void* data, const std::size_t size) {
+                const auto* bytes = static_cast<const std::uint8_t*>(data);
+                for (auto i = 0uz; i < size; i++) {
+                    key = (key ^ bytes[i]) * 0x100000001b3;
+                }
+            };
+            (hash(&values, sizeof(values)), ...);
+            return key;
+        }
+
+        // Counters of all the cached command lists during the last frame
+        static const auto& getFrameStats() { return frameStats; }
+
+        // Closes the counters of the current frame, called once per frame by the applications
+        static void endFrame();
+
+    private:
+        std::shared_ptr<vireo::CommandAllocator> commandAllocator;
+        std::shared_ptr<vireo::CommandList>      commandList;
+        std::uint64_t                            key{0};
+        bool                                     recorded{false};
+
+        static Stats currentStats;
+        static Stats frameStats;
+    };
+
+}
@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.commandstate;
+
+namespace samples {
+
+    CommandState::Stats CommandState::currentStats{};
+    CommandState::Stats CommandState::frameStats{};
+
+    void CommandState::begin(const std::shared_ptr<vireo::CommandList>& commandList) {
+        this->commandList = commandList;
+        pipeline = nullptr;
+        sets.clear();
+        vertexBuffer = nullptr;
+        indexBuffer = nullptr;
+    }
+
+    bool CommandState::bindPipeline(const std::shared_ptr<vireo::Pipeline>& pipeline) {
+        if (!bind(this->pipeline, pipeline.get())) {
+            return false;
+        }
+        sets.clear();
+        commandList->bindPipeline(pipeline);
+        return true;
+    }
+
+    void CommandState::bindDescriptors(const std::vector<std::shared_ptr<const vireo::DescriptorSet>>& sets) {
+        auto changed = false;
+        for (auto index = 0u; index < sets.size(); index++) {
+            changed |= bind(sets[index].get(), index, std::nullopt);
+        }
+        if (changed) {
+            commandList->bindDescriptors(sets);
+        }
+    }
+
+    void CommandState::bindDescriptor(const std::shared_ptr<vireo::DescriptorSet>& set, const std::uint32_t index) {
+        if (bind(set.get(), index, std::nullopt)) {
+            commandList->bindDescriptor(set, index);
+        }
+    }
+
+    void CommandState::bindDescriptor(
+        const std::shared_ptr<vireo::DescriptorSet>& set,
+        const std::uint32_t index,
+        const std::uint32_t offset) {
+        if (bind(set.get(), index, offset)) {
+            commandList->bindDescriptor(set, index, offset);
+        }
+    }
+
+    void CommandState::bindVertexBuffer(const std::shared_ptr<vireo::Buffer>& buffer) {
+        if (bind(vertexBuffer, buffer.get())) {
+            commandList->bindVertexBuffer(buffer);
+        }
+    }
+
+    void CommandState::bindIndexBuffer(const std::shared_ptr<vireo::Buffer>& buffer) {
+        if (bind(indexBuffer, buffer.get())) {
+            commandList->bindIndexBuffer(buffer);
+        }
+    }
+
+    void CommandState::endFrame() {
+        frameStats = currentStats;
+        currentStats = Stats{};
+    }
+
+    bool CommandState::bind(
+        const vireo::DescriptorSet* set,
+        const std::uint32_t index,
+        const std::optional<std::uint32_t> offset) {
+        if (sets.size() <= index) {
+            sets.resize(index + 1);
+        }
+        auto& bound = sets[index];
+        if (bound.set == set && bound.offset == offset) {
+            currentStats.skipped += 1;
+            return false;
+        }
+        bound = {set, offset};
+        currentStats.binds += 1;
+        return true;
+    }
+
+}
@@ -0,0 +1,80 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.commandstate;
+
+import std;
+import vireo;
+
+export namespace samples {
+
+    // Records the binds of a command list and skips the pipeline, descriptor sets, vertex and index
+    // buffers already bound. Binding another pipeline forgets the descriptor sets, the DirectX backend
+    // resets them with the root signature. The bound objects are kept alive by the command list.
+    class CommandState {
+    public:
+        struct Stats {
+            std::uint32_t binds{0};
+            std::uint32_t skipped{0};
+        };
+
+        // Starts the recording of the binds, and forgets them after a compute dispatch in the command list
+        void begin(const std::shared_ptr<vireo::CommandList>& commandList);
+
+        const auto& getCommandList() const { return commandList; }
+
+        // Returns false if the pipeline was already bound
+        bool bindPipeline(const std::shared_ptr<vireo::Pipeline>& pipeline);
+
+        // Binds the sets starting at the set 0
+        void bindDescriptors(const std::vector<std::shared_ptr<const vireo::DescriptorSet>>& sets);
+
+        void bindDescriptor(const std::shared_ptr<vireo::DescriptorSet>& set, std::uint32_t index);
+
+        // Set with a dynamic uniform buffer offset
+        void bindDescriptor(const std::shared_ptr<vireo::DescriptorSet>& set, std::uint32_t index, std::uint32_t offset);
+
+        void bindVertexBuffer(const std::shared_ptr<vireo::Buffer>& buffer);
+
+        void bindIndexBuffer(const std::shared_ptr<vireo::Buffer>& buffer);
+
+        // Counters of all the command lists during the last frame
+        static const auto& getFrameStats() { return frameStats; }
+
+        // Closes the counters of the current frame, called once per frame by the applications
+        static void endFrame();
+
+    private:
+        struct BoundSet {
+            const vireo::DescriptorSet*  set{nullptr};
+            std::optional<std::uint32_t> offset;
+        };
+
+        std::shared_ptr<vireo::CommandList> commandList;
+        const vireo::Pipeline*              pipeline{nullptr};
+        std::vector<BoundSet>               sets;
+        const vireo::Buffer*                vertexBuffer{nullptr};
+        const vireo::Buffer*                indexBuffer{nullptr};
+
+        static Stats currentStats;
+        static Stats frameStats;
+
+        // Records the set as bound, returns false if it already was
+        bool bind(const vireo::DescriptorSet* set, std::uint32_t index, std::optional<std::uint32_t> offset);
+
+        template <typename T>
+        static bool bind(const T*& bound, const T* object) {
+            if (bound == object) {
+                currentStats.skipped += 1;
+                return false;
+            }
+            bound = object;
+            currentStats.binds += 1;
+            return true;
+        }
+    };
+
+}
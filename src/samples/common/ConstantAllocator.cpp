@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.constantallocator;
+
+namespace samples {
+
+    void ConstantAllocator::onInit(
+        const std::shared_ptr<vireo::Vireo>& vireo,
+        const std::size_t blockSize,
+        const std::uint32_t blockCount,
+        const std::uint32_t framesInFlight,
+        const std::string& name) {
+        this->blockCount = blockCount;
+        framesData.resize(framesInFlight);
+        for (auto& frame : framesData) {
+            frame.buffer = vireo->createBuffer(vireo::BufferType::UNIFORM, blockSize, blockCount, name);
+            frame.buffer->map();
+        }
+    }
+
+    std::uint32_t ConstantAllocator::reserve() {
+        if (staticCount == blockCount) {
+            throw std::runtime_error("Constant allocator is full");
+        }
+        for (auto& frame : framesData) {
+            frame.dirty.push_back(true);
+            frame.head = staticCount + 1;
+        }
+        return staticCount++;
+    }
+
+    void ConstantAllocator::invalidate(const std::uint32_t block) {
+        for (auto& frame : framesData) {
+            frame.dirty[block] = true;
+        }
+    }
+
+    std::size_t ConstantAllocator::writeStatic(
+        const std::uint32_t frameIndex,
+        const std::uint32_t block,
+        const void* data,
+        const std::size_t size) {
+        auto& frame = framesData[frameIndex];
+        const auto offset = frame.buffer->getInstanceSizeAligned() * block;
+        if (frame.dirty[block]) {
+            frame.buffer->write(data, size, offset);
+            frame.dirty[block] = false;
+        }
+        return offset;
+    }
+
+    void ConstantAllocator::reset(const std::uint32_t frameIndex) {
+        framesData[frameIndex].head = staticCount;
+    }
+
+    std::size_t ConstantAllocator::allocate(
+        const std::uint32_t frameIndex,
+        const void* data,
+        const std::size_t size) {
+        auto& frame = framesData[frameIndex];
+        if (frame.head == blockCount) {
+            throw std::runtime_error("Constant allocator is full");
+        }
+        const auto offset = frame.buffer->getInstanceSizeAligned() * frame.head++;
+        frame.buffer->write(data, size, offset);
+        return offset;
+    }
+
+}
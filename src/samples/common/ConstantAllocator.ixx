@@ -0,0 +1,56 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.constantallocator;
+
+import std;
+import vireo;
+
+export namespace samples {
+
+    // Per-frame linear allocator for the constants bound with dynamic uniform descriptors : one persistently
+    // mapped uniform buffer per frame, split into blocks aligned for the dynamic offsets.
+    // The static blocks are reserved first and only copied in the frames where they are dirty,
+    // the other blocks are handed out in order and recycled when the frame is reused.
+    class ConstantAllocator {
+    public:
+        void onInit(
+            const std::shared_ptr<vireo::Vireo>& vireo,
+            std::size_t blockSize,
+            std::uint32_t blockCount,
+            std::uint32_t framesInFlight,
+            const std::string& name);
+
+        // Reserves a block kept between the frames, returns its index
+        std::uint32_t reserve();
+
+        // Marks a static block as dirty in all the frames
+        void invalidate(std::uint32_t block);
+
+        // Copies the data of a static block if it is dirty in the frame, returns the dynamic offset of the block
+        std::size_t writeStatic(std::uint32_t frameIndex, std::uint32_t block, const void* data, std::size_t size);
+
+        // Releases the transient blocks of the frame, the GPU must be done with its previous use
+        void reset(std::uint32_t frameIndex);
+
+        // Copies the data in the next transient block of the frame, returns the dynamic offset of the block
+        std::size_t allocate(std::uint32_t frameIndex, const void* data, std::size_t size);
+
+        const auto& getBuffer(const std::uint32_t frameIndex) const { return framesData[frameIndex].buffer; }
+
+    private:
+        struct FrameData {
+            std::shared_ptr<vireo::Buffer> buffer;
+            std::uint32_t                  head{0};
+            std::vector<bool>              dirty; // static blocks
+        };
+
+        std::uint32_t          blockCount{0};
+        std::uint32_t          staticCount{0};
+        std::vector<FrameData> framesData;
+    };
+
+}
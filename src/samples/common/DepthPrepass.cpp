@@ -11,6 +11,7 @@ namespace samples {
 
     void DepthPrepass::onInit(
         const std::shared_ptr<vireo::Vireo>& vireo,
+        PipelineCache& pipelineCache,
         const Scene& scene,
         const bool withStencil,
         const std::uint32_t framesInFlight) {
@@ -18,10 +19,12 @@ namespace samples {
 
         descriptorLayout = vireo->createDescriptorLayout();
         descriptorLayout->add(BINDING_GLOBAL, vireo::DescriptorType::UNIFORM);
+        descriptorLayout->add(BINDING_MODELS, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_INSTANCES, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_DRAWS, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_VERTICES, vireo::DescriptorType::STORAGE);
         descriptorLayout->build();
 
-        modelDescriptorLayout = vireo->createDynamicUniformDescriptorLayout();
-
         if (withStencil) {
             this->withStencil = true;
             renderingConfig.stencilTestEnable = true;
@@ -30,23 +33,23 @@ namespace samples {
             pipelineConfig.backStencilOpState = pipelineConfig.frontStencilOpState;
         }
         pipelineConfig.resources = vireo->createPipelineResources(
-            { descriptorLayout, modelDescriptorLayout }
-        );
-        pipelineConfig.vertexInputLayout = vireo->createVertexLayout(sizeof(Vertex), vertexAttributes);
-        pipelineConfig.vertexShader = vireo->createShaderModule("shaders/depth_prepass.vert");
-        pipeline = vireo->createGraphicPipeline(pipelineConfig);
+            { descriptorLayout },
+            pushConstantsDesc);
+        if (scene.usePackedVertices) {
+            pipelineCache.declareGraphicPipeline(pipeline, pipelineConfig, "shaders/depth_prepass_packed.vert");
+            pipelineCache.declareGraphicPipeline(culledPipeline, pipelineConfig, "shaders/depth_prepass_culled_packed.vert");
+        } else {
+            pipelineCache.declareGraphicPipeline(pipeline, pipelineConfig, "shaders/depth_prepass.vert");
+            pipelineCache.declareGraphicPipeline(culledPipeline, pipelineConfig, "shaders/depth_prepass_culled.vert");
+        }
+        occlusionCulling.onInit(vireo, pipelineCache, framesInFlight);
 
         framesData.resize(framesInFlight);
-        for (auto& frame : framesData) {
-            frame.globalUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Global));
-            frame.globalUniform->map();
+        for (auto i = 0u; i < framesInFlight; i++) {
+            auto& frame = framesData[i];
             frame.descriptorSet = vireo->createDescriptorSet(descriptorLayout);
-            frame.descriptorSet->update(BINDING_GLOBAL, frame.globalUniform);
-
-            frame.modelUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Model), scene.getModels().size());
-            frame.modelUniform->map();
-            frame.modelDescriptorSet = vireo->createDescriptorSet(modelDescriptorLayout);
-            frame.modelDescriptorSet->update(frame.modelUniform);
+            frame.descriptorSet->update(BINDING_GLOBAL, scene.getGlobalBuffer(i));
+            frame.descriptorSet->update(BINDING_VERTICES, scene.getGeometry().getVertexBuffer());
 
             frame.commandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
             frame.commandList = frame.commandAllocator->createCommandList();
@@ -61,24 +64,40 @@ namespace samples {
         const std::shared_ptr<vireo::SubmitQueue>& graphicQueue) {
         auto& frame = framesData[frameIndex];
 
-        frame.globalUniform->write(&scene.getGlobal());
-        frame.modelUniform->write(scene.getModels().data());
+        if (frame.modelsBuffer != scene.getModelsBuffer(frameIndex)) {
+            frame.modelsBuffer = scene.getModelsBuffer(frameIndex);
+            frame.descriptorSet->update(BINDING_MODELS, frame.modelsBuffer);
+        }
+        if (frame.drawsBuffer != scene.getDrawsBuffer(frameIndex)) {
+            frame.drawsBuffer = scene.getDrawsBuffer(frameIndex);
+            frame.descriptorSet->update(BINDING_DRAWS, frame.drawsBuffer);
+        }
 
         renderingConfig.depthStencilRenderTarget = frame.depthBuffer;
+        const auto depthTargetState = withStencil
+            ? vireo::ResourceState::RENDER_TARGET_DEPTH_STENCIL
+            : vireo::ResourceState::RENDER_TARGET_DEPTH;
 
         frame.commandAllocator->reset();
         const auto cmdList = frame.commandList;
         cmdList->begin();
         if (!frame.depthInitialized) {
-            const auto depthTargetState = withStencil
-                ? vireo::ResourceState::RENDER_TARGET_DEPTH_STENCIL
-                : vireo::ResourceState::RENDER_TARGET_DEPTH;
             cmdList->barrier(
                 renderingConfig.depthStencilRenderTarget,
                 vireo::ResourceState::UNDEFINED,
                 depthTargetState);
             frame.depthInitialized = true;
         }
+
+        const auto occlusion = scene.getInstanceCount() > 0 && !scene.isSoftwareOcclusionEnabled();
+        if (occlusion) {
+            occlusionCulling.earlyPass(frameIndex, scene, cmdList);
+            if (frame.instancesBuffer != occlusionCulling.getListsBuffer(frameIndex)) {
+                frame.instancesBuffer = occlusionCulling.getListsBuffer(frameIndex);
+                frame.descriptorSet->update(BINDING_INSTANCES, frame.instancesBuffer);
+            }
+        }
+
         cmdList->beginRendering(renderingConfig);
         cmdList->setViewport(vireo::Viewport{
             static_cast<float>(extent.width),
@@ -86,14 +105,36 @@ namespace samples {
         cmdList->setScissors(vireo::Rect{
             extent.width,
             extent.height});
-        cmdList->bindPipeline(pipeline);
+        commandState.begin(cmdList);
+        commandState.bindPipeline(pipeline);
         if (withStencil) {
             cmdList->setStencilReference(1);
         }
-        cmdList->bindDescriptor(frame.descriptorSet, SET_GLOBAL);
-        cmdList->bindDescriptor(frame.modelDescriptorSet, SET_MODELS,
-            frame.modelUniform->getInstanceSizeAligned() * Scene::MODEL_OPAQUE);
-        scene.drawCube(cmdList);
+        commandState.bindDescriptor(frame.descriptorSet, SET_GLOBAL);
+        // The stress mode instances are drawn with the opaque model, unless they are occlusion culled on the GPU
+        const auto range = scene.getDrawRange(
+            Scene::BUCKET_OPAQUE,
+            occlusion ? Scene::BUCKET_OPAQUE : Scene::BUCKET_INSTANCES);
+        pushConstants.firstDraw = range.first;
+        pushConstants.instanceListOffset = 0;
+        pushConstants.quantization = scene.getVertexQuantization();
+        cmdList->pushConstants(pipelineConfig.resources, pushConstantsDesc, &pushConstants);
+        scene.drawCubes(commandState, range);
+        if (occlusion) {
+            // Early phase : the instances visible in the last frame
+            pushConstants.firstDraw = scene.getDrawRange(Scene::BUCKET_INSTANCES, Scene::BUCKET_INSTANCES).first;
+            drawInstancesList(frameIndex, scene, OcclusionCulling::LIST_EARLY);
+            cmdList->endRendering();
+
+            // Late phase : the instances not occluded by the early depth and not already drawn
+            occlusionCulling.latePass(frameIndex, frame.depthBuffer, depthTargetState, cmdList);
+            // The late pass binds its compute pipelines
+            commandState.begin(cmdList);
+            renderingConfig.clearDepthStencil = false;
+            cmdList->beginRendering(renderingConfig);
+            renderingConfig.clearDepthStencil = true;
+            drawInstancesList(frameIndex, scene, OcclusionCulling::LIST_LATE);
+        }
         cmdList->endRendering();
         cmdList->end();
 
@@ -103,7 +144,26 @@ namespace samples {
             {cmdList});
     }
 
+    void DepthPrepass::drawInstancesList(
+        const std::uint32_t frameIndex,
+        const Scene& scene,
+        const std::uint32_t list) {
+        const auto& cmdList = commandState.getCommandList();
+        commandState.bindPipeline(culledPipeline);
+        if (withStencil) {
+            cmdList->setStencilReference(1);
+        }
+        commandState.bindDescriptor(framesData[frameIndex].descriptorSet, SET_GLOBAL);
+        pushConstants.instanceListOffset = occlusionCulling.getListOffset(list, frameIndex);
+        cmdList->pushConstants(pipelineConfig.resources, pushConstantsDesc, &pushConstants);
+        scene.drawInstancesIndirect(
+            commandState,
+            occlusionCulling.getCommandsBuffer(frameIndex),
+            OcclusionCulling::getCommandOffset(list));
+    }
+
     void DepthPrepass::onResize(const vireo::Extent& extent) {
+        occlusionCulling.onResize(extent);
         for (auto& frame : framesData) {
             frame.depthBuffer = vireo->createRenderTarget(
                 pipelineConfig.depthStencilImageFormat,
@@ -4,13 +4,14 @@
 * This software is released under the MIT License.
 * https://opensource.org/licenses/MIT
 */
-module;
-#include <cstddef>
 export module samples.common.depthprepass;
 
 import std;
 import vireo;
+import samples.common.commandstate;
 import samples.common.global;
+import samples.common.occlusionculling;
+import samples.common.pipelinecache;
 import samples.common.scene;
 
 export namespace samples {
@@ -19,6 +20,7 @@ export namespace samples {
     public:
         void onInit(
             const std::shared_ptr<vireo::Vireo>& vireo,
+            PipelineCache& pipelineCache,
             const Scene& scene,
             bool withStencil,
             std::uint32_t framesInFlight);
@@ -33,24 +35,42 @@ export namespace samples {
         auto getDepthBuffer(const std::uint32_t frameIndex) const { return framesData[frameIndex].depthBuffer; }
         auto getFormat() const { return pipelineConfig.depthStencilImageFormat; }
         auto isWithStencil() const { return withStencil; }
+        const auto& getOcclusionCulling() const { return occlusionCulling; }
 
     private:
         struct FrameData : FrameDataCommand {
-            std::shared_ptr<vireo::Buffer>        globalUniform;
-            std::shared_ptr<vireo::Buffer>        modelUniform;
+            std::shared_ptr<vireo::Buffer>        modelsBuffer;
+            std::shared_ptr<vireo::Buffer>        instancesBuffer;
+            std::shared_ptr<vireo::Buffer>        drawsBuffer;
             std::shared_ptr<vireo::RenderTarget>  depthBuffer;
             std::shared_ptr<vireo::DescriptorSet> descriptorSet;
-            std::shared_ptr<vireo::DescriptorSet> modelDescriptorSet;
             bool                                  depthInitialized{false};
         };
 
+        struct PushConstants {
+            std::uint32_t                   firstDraw;
+            std::uint32_t                   instanceListOffset;
+            alignas(16) VertexQuantization  quantization;
+        };
+
         static constexpr vireo::DescriptorIndex SET_GLOBAL{0};
         static constexpr vireo::DescriptorIndex BINDING_GLOBAL{0};
-        static constexpr vireo::DescriptorIndex SET_MODELS{1};
+        static constexpr vireo::DescriptorIndex BINDING_MODELS{1};
+        static constexpr vireo::DescriptorIndex BINDING_INSTANCES{2};
+        static constexpr vireo::DescriptorIndex BINDING_DRAWS{3};
+        static constexpr vireo::DescriptorIndex BINDING_VERTICES{4};
+
+        // Draws the stress mode instances of an occlusion culling list
+        void drawInstancesList(
+            std::uint32_t frameIndex,
+            const Scene& scene,
+            std::uint32_t list);
 
-        const std::vector<vireo::VertexAttributeDesc> vertexAttributes{
-            {"POSITION", vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, position) },
+        static constexpr auto pushConstantsDesc = vireo::PushConstantsDesc {
+            .stage = vireo::ShaderStage::VERTEX,
+            .size = sizeof(PushConstants),
         };
+
         vireo::GraphicPipelineConfiguration pipelineConfig {
             .cullMode            = vireo::CullMode::BACK,
             .depthTestEnable     = true,
@@ -70,11 +90,14 @@ export namespace samples {
         };
 
         bool                                     withStencil{false};
+        PushConstants                            pushConstants{};
         std::vector<FrameData>                   framesData;
         std::shared_ptr<vireo::Vireo>            vireo;
         std::shared_ptr<vireo::Pipeline>         pipeline;
+        std::shared_ptr<vireo::Pipeline>         culledPipeline;
         std::shared_ptr<vireo::DescriptorLayout> descriptorLayout;
-        std::shared_ptr<vireo::DescriptorLayout> modelDescriptorLayout;
+        OcclusionCulling                         occlusionCulling;
+        CommandState                             commandState;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.descriptorcache;
+
+namespace samples {
+
+    DescriptorCache::Stats DescriptorCache::currentStats{};
+    DescriptorCache::Stats DescriptorCache::frameStats{};
+
+    void DescriptorCache::update(
+        const std::shared_ptr<vireo::DescriptorSet>& set,
+        const vireo::DescriptorIndex binding,
+        const std::shared_ptr<vireo::Image>& image) {
+        if (bind(set, binding, image)) {
+            set->update(binding, image);
+        }
+    }
+
+    void DescriptorCache::update(
+        const std::shared_ptr<vireo::DescriptorSet>& set,
+        const vireo::DescriptorIndex binding,
+        const std::shared_ptr<vireo::Buffer>& buffer) {
+        if (bind(set, binding, buffer)) {
+            set->update(binding, buffer);
+        }
+    }
+
+    void DescriptorCache::endFrame() {
+        frameStats = currentStats;
+        currentStats = Stats{};
+    }
+
+    bool DescriptorCache::bind(
+        const std::shared_ptr<vireo::DescriptorSet>& set,
+        const vireo::DescriptorIndex binding,
+        const std::shared_ptr<const void>& resource) {
+        auto& bound = bindings[{set.get(), binding}];
+        if (bound.set.lock() == set && bound.resource.lock() == resource) {
+            currentStats.skipped += 1;
+            return false;
+        }
+        bound.set = set;
+        bound.resource = resource;
+        currentStats.writes += 1;
+        return true;
+    }
+
+}
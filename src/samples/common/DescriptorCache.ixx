@@ -0,0 +1,58 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.descriptorcache;
+
+import std;
+import vireo;
+
+export namespace samples {
+
+    // Remembers the last resource written in each binding of the descriptor sets and skips the writes
+    // of the same resource. The sets and resources are weakly referenced, so a destroyed resource
+    // never matches a new one allocated at the same address.
+    class DescriptorCache {
+    public:
+        struct Stats {
+            std::uint32_t writes{0};
+            std::uint32_t skipped{0};
+        };
+
+        void update(
+            const std::shared_ptr<vireo::DescriptorSet>& set,
+            vireo::DescriptorIndex binding,
+            const std::shared_ptr<vireo::Image>& image);
+
+        void update(
+            const std::shared_ptr<vireo::DescriptorSet>& set,
+            vireo::DescriptorIndex binding,
+            const std::shared_ptr<vireo::Buffer>& buffer);
+
+        // Counters of all the caches during the last frame
+        static const auto& getFrameStats() { return frameStats; }
+
+        // Closes the counters of the current frame, called once per frame by the applications
+        static void endFrame();
+
+    private:
+        struct Binding {
+            std::weak_ptr<vireo::DescriptorSet> set;
+            std::weak_ptr<const void>           resource;
+        };
+
+        std::map<std::pair<const vireo::DescriptorSet*, vireo::DescriptorIndex>, Binding> bindings;
+
+        static Stats currentStats;
+        static Stats frameStats;
+
+        // Records the resource as written in the binding, returns false if it already was
+        bool bind(
+            const std::shared_ptr<vireo::DescriptorSet>& set,
+            vireo::DescriptorIndex binding,
+            const std::shared_ptr<const void>& resource);
+    };
+
+}
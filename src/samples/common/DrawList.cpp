@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.drawlist;
+
+namespace samples {
+
+    std::uint64_t DrawList::makeKey(
+        const std::uint32_t pass,
+        const std::uint32_t pipeline,
+        const std::uint32_t material,
+        const std::uint32_t mesh,
+        const float depth,
+        const bool backToFront) {
+        static constexpr auto mask = [](const int bits) { return (std::uint64_t{1} << bits) - 1; };
+        // The bits of a positive float are ordered like its value
+        auto quantizedDepth = std::bit_cast<std::uint32_t>(std::max(depth, 0.0f)) >> (32 - 1 - DEPTH_BITS);
+        if (backToFront) {
+            quantizedDepth = static_cast<std::uint32_t>(mask(DEPTH_BITS)) - quantizedDepth;
+        }
+        return (std::uint64_t{pass} << PASS_SHIFT) |
+               ((pipeline & mask(PIPELINE_BITS)) << PIPELINE_SHIFT) |
+               ((material & mask(MATERIAL_BITS)) << MATERIAL_SHIFT) |
+               ((mesh & mask(MESH_BITS)) << MESH_SHIFT) |
+               (quantizedDepth & mask(DEPTH_BITS));
+    }
+
+    void DrawList::sort(WorkerPool& workerPool) {
+        const auto count = draws.size();
+        if (count < 2) { return; }
+        const auto chunkCount = std::clamp<std::size_t>(count / MIN_CHUNK_SIZE, 1, workerPool.getThreadCount());
+        const auto chunkSize = (count + chunkCount - 1) / chunkCount;
+        const auto forEachChunk = [&](const auto& function) {
+            workerPool.parallelFor(chunkCount, 1, [&](const std::size_t begin, const std::size_t end) {
+                for (auto chunk = begin; chunk < end; chunk++) {
+                    function(chunk, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+                }
+            });
+        };
+        sorted.resize(count);
+        histograms.resize(chunkCount);
+        differentBits.resize(chunkCount);
+
+        // The bytes equal in all the keys do not change the order
+        const auto firstKey = draws.front().key;
+        forEachChunk([&](const std::size_t chunk, const std::size_t begin, const std::size_t end) {
+            auto bits = std::uint64_t{0};
+            for (auto i = begin; i < end; i++) {
+                bits |= draws[i].key ^ firstKey;
+            }
+            differentBits[chunk] = bits;
+        });
+        const auto sortedBits = std::accumulate(differentBits.begin(), differentBits.end(), std::uint64_t{0}, std::bit_or{});
+
+        for (auto shift = 0; shift < 64; shift += 8) {
+            if (((sortedBits >> shift) & 0xff) == 0) { continue; }
+            forEachChunk([&](const std::size_t chunk, const std::size_t begin, const std::size_t end) {
+                auto& histogram = histograms[chunk];
+                histogram.fill(0);
+                for (auto i = begin; i < end; i++) {
+                    histogram[(draws[i].key >> shift) & 0xff] += 1;
+                }
+            });
+            // Destination of the first draw of each digit of each chunk, the chunks of a digit are
+            // consecutive to keep the sort stable
+            auto offset = std::uint32_t{0};
+            for (auto digit = 0; digit < 256; digit++) {
+                for (auto& histogram : histograms) {
+                    const auto digitCount = histogram[digit];
+                    histogram[digit] = offset;
+                    offset += digitCount;
+                }
+            }
+            forEachChunk([&](const std::size_t chunk, const std::size_t begin, const std::size_t end) {
+                auto& histogram = histograms[chunk];
+                for (auto i = begin; i < end; i++) {
+                    sorted[histogram[(draws[i].key >> shift) & 0xff]++] = draws[i];
+                }
+            });
+            std::swap(draws, sorted);
+        }
+    }
+
+}
@@ -0,0 +1,62 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.drawlist;
+
+import std;
+import samples.common.workerpool;
+
+export namespace samples {
+
+    // Draws of a frame ordered by 64 bits sort keys so that the draws sharing their state are consecutive.
+    // Key layout, from the most significant bits : pass (4), pipeline (12), material (12), mesh (12), depth (24).
+    // Sorted each frame with a parallel LSD radix sort skipping the bytes common to all the keys.
+    class DrawList {
+    public:
+        struct Draw {
+            std::uint64_t key;
+            std::uint32_t index; // user value, the draw instance
+        };
+
+        // The depth is the view space distance, the transparent draws are sorted back to front
+        static std::uint64_t makeKey(
+            std::uint32_t pass,
+            std::uint32_t pipeline,
+            std::uint32_t material,
+            std::uint32_t mesh,
+            float depth,
+            bool backToFront = false);
+
+        static auto getPass(const std::uint64_t key) { return static_cast<std::uint32_t>(key >> PASS_SHIFT); }
+
+        void clear() { draws.clear(); }
+
+        void add(const std::uint64_t key, const std::uint32_t index) { draws.push_back({key, index}); }
+
+        // Stable sort by key
+        void sort(WorkerPool& workerPool);
+
+        const auto& getDraws() const { return draws; }
+
+    private:
+        static constexpr auto DEPTH_BITS{24};
+        static constexpr auto MESH_BITS{12};
+        static constexpr auto MATERIAL_BITS{12};
+        static constexpr auto PIPELINE_BITS{12};
+        static constexpr auto MESH_SHIFT{DEPTH_BITS};
+        static constexpr auto MATERIAL_SHIFT{MESH_SHIFT + MESH_BITS};
+        static constexpr auto PIPELINE_SHIFT{MATERIAL_SHIFT + MATERIAL_BITS};
+        static constexpr auto PASS_SHIFT{PIPELINE_SHIFT + PIPELINE_BITS};
+        // Below this count of draws per thread the sort is not worth splitting
+        static constexpr std::size_t MIN_CHUNK_SIZE{4096};
+
+        std::vector<Draw>                         draws;
+        std::vector<Draw>                         sorted;
+        std::vector<std::array<std::uint32_t, 256>> histograms; // per chunk
+        std::vector<std::uint64_t>                differentBits; // per chunk
+    };
+
+}
@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.geometryarena;
+
+namespace samples {
+
+    void GeometryArena::onInit(
+        const std::shared_ptr<vireo::Vireo>& vireo,
+        const std::uint32_t vertexWordsCapacity,
+        const std::uint32_t indexCapacity) {
+        vertexBuffer = vireo->createBuffer(vireo::BufferType::STORAGE, sizeof(std::uint32_t), vertexWordsCapacity, "Vertices");
+        indexBuffer = vireo->createBuffer(vireo::BufferType::INDEX, sizeof(std::uint32_t), indexCapacity, "Indices");
+        vertexWords.resize(vertexWordsCapacity);
+        indices.resize(indexCapacity);
+        vertexAllocator.reset(vertexWordsCapacity);
+        indexAllocator.reset(indexCapacity);
+    }
+
+    GeometryArena::MeshRange GeometryArena::add(
+        const void* vertices,
+        const std::size_t vertexSize,
+        const std::uint32_t vertexCount,
+        const std::vector<std::uint32_t>& indices) {
+        if (vertexSize == 0 || vertexSize % sizeof(std::uint32_t) != 0) {
+            throw std::runtime_error("Vertex size must be a multiple of 4");
+        }
+        const auto vertexWordsCount = static_cast<std::uint32_t>(vertexSize / sizeof(std::uint32_t));
+        auto mesh = MeshRange{};
+        mesh.vertexCount = vertexCount;
+        mesh.indexCount = static_cast<std::uint32_t>(indices.size());
+        // Allocated with one more vertex to start on a multiple of the vertex size
+        mesh.vertices = vertexAllocator.allocate((vertexCount + 1) * vertexWordsCount - 1);
+        mesh.indices = indexAllocator.allocate(mesh.indexCount);
+        if (!mesh.vertices.isValid() || !mesh.indices.isValid()) {
+            vertexAllocator.free(mesh.vertices);
+            indexAllocator.free(mesh.indices);
+            throw std::runtime_error("Geometry arena is full");
+        }
+        mesh.firstVertex = (mesh.vertices.offset + vertexWordsCount - 1) / vertexWordsCount;
+        mesh.firstIndex = mesh.indices.offset;
+
+        std::memcpy(&vertexWords[mesh.firstVertex * vertexWordsCount], vertices, vertexCount * vertexSize);
+        std::ranges::transform(indices, this->indices.begin() + mesh.firstIndex, [&](const std::uint32_t index) {
+            return index + mesh.firstVertex;
+        });
+        modified = true;
+        return mesh;
+    }
+
+    void GeometryArena::remove(const MeshRange& mesh) {
+        vertexAllocator.free(mesh.vertices);
+        indexAllocator.free(mesh.indices);
+    }
+
+    void GeometryArena::flush(const std::shared_ptr<vireo::CommandList>& cmdList) {
+        if (!modified) { return; }
+        // The RHI uploads whole buffers
+        cmdList->upload(vertexBuffer, vertexWords.data());
+        cmdList->upload(indexBuffer, indices.data());
+        modified = false;
+    }
+
+}
@@ -0,0 +1,68 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.geometryarena;
+
+import std;
+import vireo;
+import samples.common.tlsf;
+
+export namespace samples {
+
+    // Vertices and indices of all the meshes, sub-allocated with TLSF allocators in two buffers bound once per pass.
+    // The vertex shaders read the vertices by index from the storage buffer of 32-bit words (vertex pulling) :
+    // the vertices of a mesh start on a multiple of their size and its indices are stored with the index of its
+    // first vertex added, the vertex index of the shaders is then the index of the vertex in the buffer with
+    // the two backends.
+    class GeometryArena {
+    public:
+        struct MeshRange {
+            std::uint32_t    firstVertex{0}; // in vertices of the mesh
+            std::uint32_t    vertexCount{0};
+            std::uint32_t    firstIndex{0};
+            std::uint32_t    indexCount{0};
+            TLSF::Allocation vertices;
+            TLSF::Allocation indices;
+        };
+
+        void onInit(
+            const std::shared_ptr<vireo::Vireo>& vireo,
+            std::uint32_t vertexWordsCapacity = 1024 * 1024,
+            std::uint32_t indexCapacity = 1024 * 1024);
+
+        // Copies a mesh in the arena, uploaded by the next flush(). The size of a vertex must be a multiple of 4.
+        MeshRange add(
+            const void* vertices,
+            std::size_t vertexSize,
+            std::uint32_t vertexCount,
+            const std::vector<std::uint32_t>& indices);
+
+        template <typename VertexType>
+        MeshRange add(const std::vector<VertexType>& vertices, const std::vector<std::uint32_t>& indices) {
+            return add(vertices.data(), sizeof(VertexType), static_cast<std::uint32_t>(vertices.size()), indices);
+        }
+
+        // Releases the ranges of a mesh, the mesh must not be in use by the GPU
+        void remove(const MeshRange& mesh);
+
+        // Uploads the buffers if meshes were added since the last call, the buffers must not be in use by the GPU
+        void flush(const std::shared_ptr<vireo::CommandList>& cmdList);
+
+        const auto& getVertexBuffer() const { return vertexBuffer; }
+        const auto& getIndexBuffer() const { return indexBuffer; }
+
+    private:
+        std::shared_ptr<vireo::Buffer> vertexBuffer;
+        std::shared_ptr<vireo::Buffer> indexBuffer;
+        // CPU copies of the buffers
+        std::vector<std::uint32_t>     vertexWords;
+        std::vector<std::uint32_t>     indices;
+        TLSF                           vertexAllocator;
+        TLSF                           indexAllocator;
+        bool                           modified{false};
+    };
+
+}
@@ -35,6 +35,8 @@ export namespace samples {
         S       = 31,
         D       = 32,
         T       = 20,
+        I       = 23,
+        O       = 24,
         SPACE   = 57,
     };
 #elifdef USE_SDL3
@@ -54,6 +56,8 @@ export namespace samples {
         S       = SDL_SCANCODE_S,
         D       = SDL_SCANCODE_D,
         T       = SDL_SCANCODE_T,
+        I       = SDL_SCANCODE_I,
+        O       = SDL_SCANCODE_O,
 
         SPACE   = SDL_SCANCODE_SPACE,
     };
@@ -66,6 +70,20 @@ export namespace samples {
         glm::vec3 tangent;
     };
 
+    // 20 bytes version of Vertex, decoded by scene_input.inc.slang
+    struct PackedVertex {
+        std::uint32_t position[2]; // unorm16 xyz in the mesh bounds, see VertexQuantization
+        std::uint32_t normal;      // octahedral snorm16 xy
+        std::uint32_t uv;          // half xy
+        std::uint32_t tangent;     // snorm10 xyz + snorm2 bitangent sign
+    };
+
+    // Per-mesh dequantization of the packed positions : position = unorm * scale + offset
+    struct VertexQuantization {
+        glm::vec4 positionOffset{0.0f};
+        glm::vec4 positionScale{1.0f};
+    };
+
     struct Global {
         glm::vec3 cameraPosition{0.0f, 0.0f, 1.75f};
         alignas(16) glm::mat4 projection;
@@ -82,6 +100,12 @@ export namespace samples {
         glm::mat4 transform{1.0f};
     };
 
+    // Model and material of one instance of an instanced draw
+    struct DrawInstance {
+        std::uint32_t modelIndex;
+        std::uint32_t materialIndex;
+    };
+
     struct Light {
         alignas(16) glm::vec3 direction{1.0f, -.25f, -.5f};
         alignas(16) glm::vec4 color{1.0f, 1.0f, 1.0f, 1.0f}; // RGB + strength
@@ -94,6 +118,19 @@ export namespace samples {
         alignas(4) std::int32_t aoTextureIndex{-1};
     };
 
+    // Optional textures of a material, the key of the shader permutations sampling it.
+    // The bits are in the order of the "// FEATURES:" line of the shaders, see material.inc.slang.
+    // Only the keys of SHADER_PERMUTATION_KEYS in CMakeLists.txt are compiled.
+    enum MaterialFeature : std::uint32_t {
+        MATERIAL_NORMAL_MAP = 1 << 0,
+        MATERIAL_AO_MAP     = 1 << 1,
+    };
+
+    constexpr std::uint32_t getMaterialFeatures(const Material& material) {
+        return (material.normalTextureIndex != -1 ? MATERIAL_NORMAL_MAP : 0u) |
+               (material.aoTextureIndex != -1 ? MATERIAL_AO_MAP : 0u);
+    }
+
     struct FrameDataCommand {
         std::shared_ptr<vireo::CommandAllocator> commandAllocator;
         std::shared_ptr<vireo::CommandList>      commandList;
@@ -0,0 +1,369 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module;
+#include <glm/gtc/constants.hpp>
+#if defined(__SSE__) || defined(_M_X64)
+#define INSTANCES_SSE
+#include <xmmintrin.h>
+#endif
+module samples.common.instances;
+
+namespace samples {
+
+    std::uint32_t InstanceStore::add(
+        const glm::vec3& position,
+        const glm::vec4& rotation,
+        const glm::vec3& scale,
+        const glm::vec3& angularVelocity,
+        const std::uint32_t parent,
+        const glm::vec3& boundsCenter,
+        const glm::vec3& boundsExtent) {
+        const auto index = static_cast<std::uint32_t>(parents.size());
+        if (parent != NO_PARENT && parent >= index) {
+            throw std::invalid_argument("Instance parent must be added before its children");
+        }
+        positionX.push_back(position.x);
+        positionY.push_back(position.y);
+        positionZ.push_back(position.z);
+        rotationX.push_back(rotation.x);
+        rotationY.push_back(rotation.y);
+        rotationZ.push_back(rotation.z);
+        rotationW.push_back(rotation.w);
+        scaleX.push_back(scale.x);
+        scaleY.push_back(scale.y);
+        scaleZ.push_back(scale.z);
+        angularVelocityX.push_back(angularVelocity.x);
+        angularVelocityY.push_back(angularVelocity.y);
+        angularVelocityZ.push_back(angularVelocity.z);
+        boundsCenterX.push_back(boundsCenter.x);
+        boundsCenterY.push_back(boundsCenter.y);
+        boundsCenterZ.push_back(boundsCenter.z);
+        boundsExtentX.push_back(boundsExtent.x);
+        boundsExtentY.push_back(boundsExtent.y);
+        boundsExtentZ.push_back(boundsExtent.z);
+        parents.push_back(parent);
+
+        const auto depth = parent == NO_PARENT ? 0u : depths[parent] + 1;
+        depths.push_back(depth);
+        if (depth > 0) {
+            if (levels.size() < depth) {
+                levels.resize(depth);
+            }
+            levels[depth - 1].push_back(index);
+        }
+
+        worldMatrices.emplace_back(1.0f);
+        worldBoundsMin.emplace_back(0.0f);
+        worldBoundsMax.emplace_back(0.0f);
+        moved.push_back(1);
+        return index;
+    }
+
+    void InstanceStore::addClusters(
+        const std::uint32_t clusterCount,
+        const glm::vec3& boundsCenter,
+        const glm::vec3& boundsExtent) {
+        static constexpr auto CHILDREN{3};
+        static constexpr auto spacing{1.0f};
+        const auto side = static_cast<std::uint32_t>(std::ceil(std::cbrt(static_cast<float>(clusterCount))));
+        const auto origin = glm::vec3{-0.5f * side * spacing, -0.5f * side * spacing, -2.0f - side * spacing};
+
+        auto random = std::mt19937{42};
+        auto velocity = std::uniform_real_distribution{-glm::pi<float>(), glm::pi<float>()};
+        reserve(size() + clusterCount * (CHILDREN + 1));
+        for (auto cluster = 0u; cluster < clusterCount; cluster++) {
+            const auto position = origin + spacing * glm::vec3{
+                static_cast<float>(cluster % side),
+                static_cast<float>((cluster / side) % side),
+                static_cast<float>(cluster / (side * side))};
+            const auto root = add(
+                position,
+                glm::vec4{0.0f, 0.0f, 0.0f, 1.0f},
+                glm::vec3{0.3f},
+                glm::vec3{velocity(random), velocity(random), velocity(random)},
+                NO_PARENT,
+                boundsCenter,
+                boundsExtent);
+            for (auto child = 0; child < CHILDREN; child++) {
+                const auto angle = glm::two_pi<float>() * child / CHILDREN;
+                add(
+                    glm::vec3{std::cos(angle), 0.0f, std::sin(angle)} * 1.2f,
+                    glm::vec4{0.0f, 0.0f, 0.0f, 1.0f},
+                    glm::vec3{0.35f},
+                    glm::vec3{0.0f, velocity(random), 0.0f},
+                    root,
+                    boundsCenter,
+                    boundsExtent);
+            }
+        }
+    }
+
+    void InstanceStore::reserve(const std::size_t count) {
+        for (auto* component : getComponents()) {
+            component->reserve(count);
+        }
+        parents.reserve(count);
+        depths.reserve(count);
+        worldMatrices.reserve(count);
+        worldBoundsMin.reserve(count);
+        worldBoundsMax.reserve(count);
+        moved.reserve(count);
+        changed.reserve(count);
+    }
+
+    void InstanceStore::clear() {
+        for (auto* component : getComponents()) {
+            component->clear();
+        }
+        parents.clear();
+        depths.clear();
+        levels.clear();
+        worldMatrices.clear();
+        worldBoundsMin.clear();
+        worldBoundsMax.clear();
+        moved.clear();
+        changed.clear();
+    }
+
+    void InstanceStore::truncate(const std::size_t count) {
+        if (count >= size()) { return; }
+        for (auto* component : getComponents()) {
+            component->resize(count);
+        }
+        parents.resize(count);
+        depths.resize(count);
+        for (auto& level : levels) {
+            std::erase_if(level, [count](const auto index) { return index >= count; });
+        }
+        while (!levels.empty() && levels.back().empty()) {
+            levels.pop_back();
+        }
+        worldMatrices.resize(count);
+        worldBoundsMin.resize(count);
+        worldBoundsMax.resize(count);
+        moved.resize(count);
+        std::erase_if(changed, [count](const auto index) { return index >= count; });
+    }
+
+    std::array<std::vector<float>*, 19> InstanceStore::getComponents() {
+        return {
+            &positionX, &positionY, &positionZ,
+            &rotationX, &rotationY, &rotationZ, &rotationW,
+            &scaleX, &scaleY, &scaleZ,
+            &angularVelocityX, &angularVelocityY, &angularVelocityZ,
+            &boundsCenterX, &boundsCenterY, &boundsCenterZ,
+            &boundsExtentX, &boundsExtentY, &boundsExtentZ};
+    }
+
+    void InstanceStore::setPosition(const std::uint32_t index, const glm::vec3& position) {
+        positionX[index] = position.x;
+        positionY[index] = position.y;
+        positionZ[index] = position.z;
+        moved[index] = 1;
+    }
+
+    void InstanceStore::update(const float deltaTime, WorkerPool& workerPool) {
+        // Local matrices for all the instances, no dependencies between them
+        workerPool.parallelFor(size(), BATCH_SIZE, [&](const std::size_t begin, const std::size_t end) {
+            updateLocal(begin, end, deltaTime);
+        });
+        // Then one level of the hierarchy at a time, parents being already in world space
+        for (const auto& level : levels) {
+            workerPool.parallelFor(level.size(), BATCH_SIZE, [&](const std::size_t begin, const std::size_t end) {
+                for (auto i = begin; i < end; i++) {
+                    const auto index = level[i];
+                    worldMatrices[index] = worldMatrices[parents[index]] * worldMatrices[index];
+                }
+            });
+        }
+        workerPool.parallelFor(size(), BATCH_SIZE, [&](const std::size_t begin, const std::size_t end) {
+            updateBounds(begin, end);
+        });
+        updateChanged(deltaTime);
+    }
+
+    void InstanceStore::updateChanged(const float deltaTime) {
+        // Parents are before their children : one pass propagates the changes down the hierarchy
+        changed.clear();
+        for (auto i = 0uz; i < size(); i++) {
+            const auto rotating = deltaTime > 0.0f &&
+                (angularVelocityX[i] != 0.0f || angularVelocityY[i] != 0.0f || angularVelocityZ[i] != 0.0f);
+            if (rotating || moved[i] || (parents[i] != NO_PARENT && moved[parents[i]])) {
+                moved[i] = 1;
+                changed.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+        std::ranges::fill(moved, 0);
+    }
+
+    void InstanceStore::updateLocal(const std::size_t begin, const std::size_t end, const float deltaTime) {
+        const auto halfDelta = 0.5f * deltaTime;
+        auto* qx = rotationX.data();
+        auto* qy = rotationY.data();
+        auto* qz = rotationZ.data();
+        auto* qw = rotationW.data();
+        const auto* wx = angularVelocityX.data();
+        const auto* wy = angularVelocityY.data();
+        const auto* wz = angularVelocityZ.data();
+        const auto* px = positionX.data();
+        const auto* py = positionY.data();
+        const auto* pz = positionZ.data();
+        const auto* sx = scaleX.data();
+        const auto* sy = scaleY.data();
+        const auto* sz = scaleZ.data();
+        auto* out = &worldMatrices[0][0][0];
+        auto first = begin;
+#ifdef INSTANCES_SSE
+        // Four instances at a time, same operations in the same order as the scalar loops below
+        const auto half = _mm_set1_ps(halfDelta);
+        const auto one = _mm_set1_ps(1.0f);
+        const auto two = _mm_set1_ps(2.0f);
+        for (; first + 4 <= end; first += 4) {
+            const auto i = first;
+            const auto x0 = _mm_loadu_ps(qx + i), y0 = _mm_loadu_ps(qy + i);
+            const auto z0 = _mm_loadu_ps(qz + i), w0 = _mm_loadu_ps(qw + i);
+            const auto vx = _mm_loadu_ps(wx + i), vy = _mm_loadu_ps(wy + i), vz = _mm_loadu_ps(wz + i);
+            // q += 0.5 * dt * (w, 0) * q, then normalize
+            auto x = _mm_add_ps(x0, _mm_mul_ps(half, _mm_sub_ps(
+                _mm_add_ps(_mm_mul_ps(vx, w0), _mm_mul_ps(vy, z0)), _mm_mul_ps(vz, y0))));
+            auto y = _mm_add_ps(y0, _mm_mul_ps(half, _mm_sub_ps(
+                _mm_add_ps(_mm_mul_ps(vy, w0), _mm_mul_ps(vz, x0)), _mm_mul_ps(vx, z0))));
+            auto z = _mm_add_ps(z0, _mm_mul_ps(half, _mm_sub_ps(
+                _mm_add_ps(_mm_mul_ps(vz, w0), _mm_mul_ps(vx, y0)), _mm_mul_ps(vy, x0))));
+            auto w = _mm_add_ps(w0, _mm_mul_ps(half, _mm_sub_ps(_mm_sub_ps(
+                _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(vx, x0)), _mm_mul_ps(vy, y0)), _mm_mul_ps(vz, z0))));
+            const auto lengthSquared = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+            const auto invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+            x = _mm_mul_ps(x, invLength);
+            y = _mm_mul_ps(y, invLength);
+            z = _mm_mul_ps(z, invLength);
+            w = _mm_mul_ps(w, invLength);
+            _mm_storeu_ps(qx + i, x);
+            _mm_storeu_ps(qy + i, y);
+            _mm_storeu_ps(qz + i, z);
+            _mm_storeu_ps(qw + i, w);
+
+            const auto xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            const auto xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            const auto wx_ = _mm_mul_ps(w, x), wy_ = _mm_mul_ps(w, y), wz_ = _mm_mul_ps(w, z);
+            const auto scaleX_ = _mm_loadu_ps(sx + i), scaleY_ = _mm_loadu_ps(sy + i), scaleZ_ = _mm_loadu_ps(sz + i);
+            // One register per matrix element for the four instances, transposed to one column per instance
+            auto m0 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX_);
+            auto m1 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz_)), scaleX_);
+            auto m2 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy_)), scaleX_);
+            auto m3 = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+            _mm_storeu_ps(out + (i + 0) * 16, m0);
+            _mm_storeu_ps(out + (i + 1) * 16, m1);
+            _mm_storeu_ps(out + (i + 2) * 16, m2);
+            _mm_storeu_ps(out + (i + 3) * 16, m3);
+            auto m4 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz_)), scaleY_);
+            auto m5 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY_);
+            auto m6 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx_)), scaleY_);
+            auto m7 = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(m4, m5, m6, m7);
+            _mm_storeu_ps(out + (i + 0) * 16 + 4, m4);
+            _mm_storeu_ps(out + (i + 1) * 16 + 4, m5);
+            _mm_storeu_ps(out + (i + 2) * 16 + 4, m6);
+            _mm_storeu_ps(out + (i + 3) * 16 + 4, m7);
+            auto m8 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy_)), scaleZ_);
+            auto m9 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx_)), scaleZ_);
+            auto m10 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ_);
+            auto m11 = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(m8, m9, m10, m11);
+            _mm_storeu_ps(out + (i + 0) * 16 + 8, m8);
+            _mm_storeu_ps(out + (i + 1) * 16 + 8, m9);
+            _mm_storeu_ps(out + (i + 2) * 16 + 8, m10);
+            _mm_storeu_ps(out + (i + 3) * 16 + 8, m11);
+            auto m12 = _mm_loadu_ps(px + i), m13 = _mm_loadu_ps(py + i), m14 = _mm_loadu_ps(pz + i);
+            auto m15 = one;
+            _MM_TRANSPOSE4_PS(m12, m13, m14, m15);
+            _mm_storeu_ps(out + (i + 0) * 16 + 12, m12);
+            _mm_storeu_ps(out + (i + 1) * 16 + 12, m13);
+            _mm_storeu_ps(out + (i + 2) * 16 + 12, m14);
+            _mm_storeu_ps(out + (i + 3) * 16 + 12, m15);
+        }
+#endif
+        // q += 0.5 * dt * (w, 0) * q, then normalize
+        for (auto i = first; i < end; i++) {
+            const auto x = qx[i] + halfDelta * ( wx[i] * qw[i] + wy[i] * qz[i] - wz[i] * qy[i]);
+            const auto y = qy[i] + halfDelta * ( wy[i] * qw[i] + wz[i] * qx[i] - wx[i] * qz[i]);
+            const auto z = qz[i] + halfDelta * ( wz[i] * qw[i] + wx[i] * qy[i] - wy[i] * qx[i]);
+            const auto w = qw[i] + halfDelta * (-wx[i] * qx[i] - wy[i] * qy[i] - wz[i] * qz[i]);
+            const auto invLength = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+            qx[i] = x * invLength;
+            qy[i] = y * invLength;
+            qz[i] = z * invLength;
+            qw[i] = w * invLength;
+        }
+        for (auto i = first; i < end; i++) {
+            const auto xx = qx[i] * qx[i], yy = qy[i] * qy[i], zz = qz[i] * qz[i];
+            const auto xy = qx[i] * qy[i], xz = qx[i] * qz[i], yz = qy[i] * qz[i];
+            const auto wx_ = qw[i] * qx[i], wy_ = qw[i] * qy[i], wz_ = qw[i] * qz[i];
+            auto* m = out + i * 16;
+            m[0]  = (1.0f - 2.0f * (yy + zz)) * sx[i];
+            m[1]  = 2.0f * (xy + wz_) * sx[i];
+            m[2]  = 2.0f * (xz - wy_) * sx[i];
+            m[3]  = 0.0f;
+            m[4]  = 2.0f * (xy - wz_) * sy[i];
+            m[5]  = (1.0f - 2.0f * (xx + zz)) * sy[i];
+            m[6]  = 2.0f * (yz + wx_) * sy[i];
+            m[7]  = 0.0f;
+            m[8]  = 2.0f * (xz + wy_) * sz[i];
+            m[9]  = 2.0f * (yz - wx_) * sz[i];
+            m[10] = (1.0f - 2.0f * (xx + yy)) * sz[i];
+            m[11] = 0.0f;
+            m[12] = px[i];
+            m[13] = py[i];
+            m[14] = pz[i];
+            m[15] = 1.0f;
+        }
+    }
+
+    void InstanceStore::updateBounds(const std::size_t begin, const std::size_t end) {
+        // Transformed AABB : center moved by the matrix, extent projected on the absolute axes
+        const auto* matrices = &worldMatrices[0][0][0];
+#ifdef INSTANCES_SSE
+        // One instance at a time on the matrix columns, the fourth lane is ignored
+        const auto signBit = _mm_set1_ps(-0.0f);
+        for (auto i = begin; i < end; i++) {
+            const auto* m = matrices + i * 16;
+            const auto column0 = _mm_loadu_ps(m), column1 = _mm_loadu_ps(m + 4), column2 = _mm_loadu_ps(m + 8);
+            const auto center = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(column0, _mm_set1_ps(boundsCenterX[i])),
+                _mm_mul_ps(column1, _mm_set1_ps(boundsCenterY[i]))),
+                _mm_mul_ps(column2, _mm_set1_ps(boundsCenterZ[i]))),
+                _mm_loadu_ps(m + 12));
+            const auto extent = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_andnot_ps(signBit, column0), _mm_set1_ps(boundsExtentX[i])),
+                _mm_mul_ps(_mm_andnot_ps(signBit, column1), _mm_set1_ps(boundsExtentY[i]))),
+                _mm_mul_ps(_mm_andnot_ps(signBit, column2), _mm_set1_ps(boundsExtentZ[i])));
+            alignas(16) float boundsMin[4], boundsMax[4];
+            _mm_store_ps(boundsMin, _mm_sub_ps(center, extent));
+            _mm_store_ps(boundsMax, _mm_add_ps(center, extent));
+            worldBoundsMin[i] = {boundsMin[0], boundsMin[1], boundsMin[2]};
+            worldBoundsMax[i] = {boundsMax[0], boundsMax[1], boundsMax[2]};
+        }
+#else
+        for (auto i = begin; i < end; i++) {
+            const auto* m = matrices + i * 16;
+            const auto cx = boundsCenterX[i], cy = boundsCenterY[i], cz = boundsCenterZ[i];
+            const auto ex = boundsExtentX[i], ey = boundsExtentY[i], ez = boundsExtentZ[i];
+            const auto centerX = m[0] * cx + m[4] * cy + m[8]  * cz + m[12];
+            const auto centerY = m[1] * cx + m[5] * cy + m[9]  * cz + m[13];
+            const auto centerZ = m[2] * cx + m[6] * cy + m[10] * cz + m[14];
+            const auto extentX = std::abs(m[0]) * ex + std::abs(m[4]) * ey + std::abs(m[8])  * ez;
+            const auto extentY = std::abs(m[1]) * ex + std::abs(m[5]) * ey + std::abs(m[9])  * ez;
+            const auto extentZ = std::abs(m[2]) * ex + std::abs(m[6]) * ey + std::abs(m[10]) * ez;
+            worldBoundsMin[i] = {centerX - extentX, centerY - extentY, centerZ - extentZ};
+            worldBoundsMax[i] = {centerX + extentX, centerY + extentY, centerZ + extentZ};
+        }
+#endif
+    }
+
+}
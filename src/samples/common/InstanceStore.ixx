@@ -0,0 +1,95 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.instances;
+
+import std;
+import glm;
+import samples.common.workerpool;
+
+export namespace samples {
+
+    // Data-oriented storage for large numbers of instances : each component lives in its own
+    // contiguous array so the transform updates run four instances at a time with SSE, in batches
+    // split across the worker pool.
+    class InstanceStore {
+    public:
+        static constexpr auto          NO_PARENT{std::numeric_limits<std::uint32_t>::max()};
+        static constexpr std::size_t   BATCH_SIZE{4096};
+
+        // Parents must be added before their children.
+        // The rotation is a quaternion (x, y, z, w), the angular velocity is in radians per second.
+        std::uint32_t add(
+            const glm::vec3& position,
+            const glm::vec4& rotation,
+            const glm::vec3& scale,
+            const glm::vec3& angularVelocity = glm::vec3{0.0f},
+            std::uint32_t    parent = NO_PARENT,
+            const glm::vec3& boundsCenter = glm::vec3{0.0f},
+            const glm::vec3& boundsExtent = glm::vec3{0.5f});
+
+        // Adds the stress mode instances : clusters of a spinning root with three orbiting children,
+        // on a lattice in front of a camera looking down -Z from the origin. Always the same random velocities.
+        void addClusters(
+            std::uint32_t    clusterCount,
+            const glm::vec3& boundsCenter = glm::vec3{0.0f},
+            const glm::vec3& boundsExtent = glm::vec3{0.5f});
+
+        void reserve(std::size_t count);
+
+        void clear();
+
+        // Removes the last instances, keeping the first count ones
+        void truncate(std::size_t count);
+
+        // Integrates the angular velocities then updates the world matrices and bounds
+        void update(float deltaTime, WorkerPool& workerPool);
+
+        // Instances whose world bounds changed during the last update(), in increasing order : the rotating
+        // ones, the moved ones and their descendants
+        const auto& getChangedInstances() const { return changed; }
+
+        auto size() const { return parents.size(); }
+
+        auto empty() const { return parents.empty(); }
+
+        const auto& getWorldMatrices() const { return worldMatrices; }
+        const auto& getWorldBoundsMin() const { return worldBoundsMin; }
+        const auto& getWorldBoundsMax() const { return worldBoundsMax; }
+
+        void setPosition(std::uint32_t index, const glm::vec3& position);
+
+    private:
+        // Local transforms
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+        std::vector<float> scaleX, scaleY, scaleZ;
+        std::vector<float> angularVelocityX, angularVelocityY, angularVelocityZ;
+        // Local axis-aligned bounds
+        std::vector<float> boundsCenterX, boundsCenterY, boundsCenterZ;
+        std::vector<float> boundsExtentX, boundsExtentY, boundsExtentZ;
+        // Hierarchy
+        std::vector<std::uint32_t>              parents;
+        std::vector<std::uint32_t>              depths;
+        std::vector<std::vector<std::uint32_t>> levels; // children indices, by depth, starting at depth 1
+        // Results
+        std::vector<glm::mat4> worldMatrices;
+        std::vector<glm::vec3> worldBoundsMin;
+        std::vector<glm::vec3> worldBoundsMax;
+        // Set by add() and setPosition() until the next update()
+        std::vector<std::uint8_t>  moved;
+        std::vector<std::uint32_t> changed;
+
+        std::array<std::vector<float>*, 19> getComponents();
+
+        void updateLocal(std::size_t begin, std::size_t end, float deltaTime);
+
+        void updateBounds(std::size_t begin, std::size_t end);
+
+        void updateChanged(float deltaTime);
+    };
+
+}
@@ -0,0 +1,548 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.meshimporter;
+
+namespace samples {
+
+    Mesh MeshImporter::load(const std::string& filename, const std::string& cacheDirectory) {
+        const auto sourcePath = std::filesystem::path{"res"} / filename;
+        const auto cachePath = std::filesystem::path{cacheDirectory} / (filename + ".mesh");
+        const auto sourceTime = std::filesystem::last_write_time(sourcePath).time_since_epoch().count();
+
+        auto mesh = Mesh{};
+        if (readCache(cachePath, sourceTime, mesh)) {
+            computeBounds(mesh);
+            return mesh;
+        }
+        mesh = importObj(sourcePath);
+        optimizeVertexCache(mesh.indices, mesh.vertices.size());
+        optimizeVertexFetch(mesh);
+        buildMeshlets(mesh);
+        writeCache(cachePath, sourceTime, mesh);
+        computeBounds(mesh);
+        return mesh;
+    }
+
+    Mesh MeshImporter::importObj(const std::filesystem::path& path) {
+        auto file = std::ifstream{path, std::ios::binary};
+        if (!file) {
+            throw std::runtime_error("Failed to load mesh: " + path.string());
+        }
+        const auto content = std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+        auto positions = std::vector<glm::vec3>{};
+        auto uvs = std::vector<glm::vec2>{};
+        auto normals = std::vector<glm::vec3>{};
+        auto mesh = Mesh{};
+        // OBJ index triplet (position, uv, normal) -> vertex index, the three indices are packed in the key
+        static constexpr auto KEY_INDEX_BITS{21};
+        auto vertexIndices = std::unordered_map<std::uint64_t, std::uint32_t>{};
+        auto face = std::vector<std::uint32_t>{};
+        auto missingNormals = false;
+
+        const auto skipSpaces = [](std::string_view& text) {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) { text.remove_prefix(1); }
+        };
+        const auto parseFloat = [&](std::string_view& text) {
+            skipSpaces(text);
+            auto value = 0.0f;
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error != std::errc{}) {
+                throw std::runtime_error("Invalid number in mesh: " + path.string());
+            }
+            text.remove_prefix(end - text.data());
+            return value;
+        };
+        // 1-based or negative (relative) index, 0 if missing
+        const auto parseIndex = [&](std::string_view& text, const std::size_t count) -> std::uint32_t {
+            auto value = 0l;
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error != std::errc{}) { return 0; }
+            text.remove_prefix(end - text.data());
+            return static_cast<std::uint32_t>(value < 0 ? static_cast<long>(count) + value + 1 : value);
+        };
+
+        auto lines = std::string_view{content};
+        while (!lines.empty()) {
+            const auto lineEnd = lines.find('\n');
+            auto line = lines.substr(0, lineEnd);
+            lines.remove_prefix(lineEnd == std::string_view::npos ? lines.size() : lineEnd + 1);
+            if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); }
+            skipSpaces(line);
+
+            if (line.starts_with("v ")) {
+                line.remove_prefix(2);
+                const auto x = parseFloat(line);
+                const auto y = parseFloat(line);
+                const auto z = parseFloat(line);
+                positions.emplace_back(x, y, z);
+            } else if (line.starts_with("vt ")) {
+                line.remove_prefix(3);
+                const auto u = parseFloat(line);
+                const auto v = parseFloat(line);
+                uvs.emplace_back(u, v);
+            } else if (line.starts_with("vn ")) {
+                line.remove_prefix(3);
+                const auto x = parseFloat(line);
+                const auto y = parseFloat(line);
+                const auto z = parseFloat(line);
+                normals.emplace_back(x, y, z);
+            } else if (line.starts_with("f ")) {
+                line.remove_prefix(2);
+                face.clear();
+                while (true) {
+                    skipSpaces(line);
+                    if (line.empty()) { break; }
+                    const auto position = parseIndex(line, positions.size());
+                    auto uv = 0u, normal = 0u;
+                    if (!line.empty() && line.front() == '/') {
+                        line.remove_prefix(1);
+                        uv = parseIndex(line, uvs.size());
+                        if (!line.empty() && line.front() == '/') {
+                            line.remove_prefix(1);
+                            normal = parseIndex(line, normals.size());
+                        }
+                    }
+                    if (position == 0 || position > positions.size() || uv > uvs.size() || normal > normals.size()) {
+                        throw std::runtime_error("Invalid face in mesh: " + path.string());
+                    }
+                    if (std::max({position, uv, normal}) >= 1u << KEY_INDEX_BITS) {
+                        throw std::runtime_error("Too many vertex attributes in mesh: " + path.string());
+                    }
+                    const auto key =
+                        static_cast<std::uint64_t>(position) << 2 * KEY_INDEX_BITS |
+                        static_cast<std::uint64_t>(uv) << KEY_INDEX_BITS |
+                        static_cast<std::uint64_t>(normal);
+                    const auto [it, inserted] = vertexIndices.try_emplace(
+                        key, static_cast<std::uint32_t>(mesh.vertices.size()));
+                    if (inserted) {
+                        mesh.vertices.push_back({
+                            .position = positions[position - 1],
+                            .normal   = normal > 0 ? normals[normal - 1] : glm::vec3{0.0f},
+                            .uv       = uv > 0 ? uvs[uv - 1] : glm::vec2{0.0f},
+                        });
+                        missingNormals |= normal == 0;
+                    }
+                    face.push_back(it->second);
+                    // Skip anything left in this vertex reference
+                    while (!line.empty() && line.front() != ' ' && line.front() != '\t') { line.remove_prefix(1); }
+                }
+                // Triangle fan for the polygons
+                for (auto i = 2; i < face.size(); i++) {
+                    mesh.indices.insert(mesh.indices.end(), {face[0], face[i - 1], face[i]});
+                }
+            }
+        }
+        if (mesh.indices.empty()) {
+            throw std::runtime_error("Empty mesh: " + path.string());
+        }
+
+        if (missingNormals) {
+            for (auto& vertex : mesh.vertices) { vertex.normal = glm::vec3{0.0f}; }
+            for (auto i = 0; i < mesh.indices.size(); i += 3) {
+                auto& v0 = mesh.vertices[mesh.indices[i + 0]];
+                auto& v1 = mesh.vertices[mesh.indices[i + 1]];
+                auto& v2 = mesh.vertices[mesh.indices[i + 2]];
+                // Area weighted
+                const auto normal = glm::cross(v1.position - v0.position, v2.position - v0.position);
+                v0.normal += normal;
+                v1.normal += normal;
+                v2.normal += normal;
+            }
+            for (auto& vertex : mesh.vertices) {
+                const auto length = glm::length(vertex.normal);
+                vertex.normal = length > 0.0f ? vertex.normal / length : AXIS_UP;
+            }
+        }
+        generateTangents(mesh);
+        return mesh;
+    }
+
+    void MeshImporter::generateTangents(Mesh& mesh) {
+        auto tangents = std::vector<glm::vec3>(mesh.vertices.size(), glm::vec3{0.0f});
+        auto bitangents = std::vector<glm::vec3>(mesh.vertices.size(), glm::vec3{0.0f});
+        for (auto i = 0; i < mesh.indices.size(); i += 3) {
+            const auto i0 = mesh.indices[i + 0], i1 = mesh.indices[i + 1], i2 = mesh.indices[i + 2];
+            const auto& v0 = mesh.vertices[i0];
+            const auto& v1 = mesh.vertices[i1];
+            const auto& v2 = mesh.vertices[i2];
+            const auto edge1 = v1.position - v0.position;
+            const auto edge2 = v2.position - v0.position;
+            const auto deltaUV1 = v1.uv - v0.uv;
+            const auto deltaUV2 = v2.uv - v0.uv;
+            const auto determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+            if (std::abs(determinant) < 1e-12f) { continue; }
+            const auto r = 1.0f / determinant;
+            const auto tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * r;
+            const auto bitangent = (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * r;
+            for (const auto index : {i0, i1, i2}) {
+                tangents[index] += tangent;
+                bitangents[index] += bitangent;
+            }
+        }
+        mesh.bitangentSigns.resize(mesh.vertices.size());
+        for (auto i = 0; i < mesh.vertices.size(); i++) {
+            auto& vertex = mesh.vertices[i];
+            // Gram-Schmidt orthogonalization, with an arbitrary tangent for the vertices without UVs
+            auto tangent = tangents[i] - vertex.normal * glm::dot(vertex.normal, tangents[i]);
+            if (glm::length(tangent) < 1e-6f) {
+                tangent = glm::cross(vertex.normal, std::abs(vertex.normal.x) < 0.9f ? AXIS_X : AXIS_Y);
+            }
+            vertex.tangent = glm::normalize(tangent);
+            // The textures are loaded top row first, so the green channel of the (OpenGL) normal maps points
+            // toward decreasing v, this is the default bitangent of the shaders : cross(normal, tangent)
+            mesh.bitangentSigns[i] = glm::dot(glm::cross(vertex.normal, vertex.tangent), bitangents[i]) > 0.0f ? -1.0f : 1.0f;
+        }
+    }
+
+    void MeshImporter::optimizeVertexCache(std::vector<std::uint32_t>& indices, const std::size_t vertexCount) {
+        // https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+        static constexpr auto CACHE_DECAY_POWER{1.5f};
+        static constexpr auto LAST_TRIANGLE_SCORE{0.75f};
+        static constexpr auto VALENCE_BOOST_SCALE{2.0f};
+        static constexpr auto VALENCE_BOOST_POWER{0.5f};
+        static constexpr auto NONE{std::numeric_limits<std::uint32_t>::max()};
+
+        const auto triangleCount = indices.size() / 3;
+        if (triangleCount == 0) { return; }
+
+        // Triangles using each vertex, the first remaining[v] ones are not emitted yet
+        auto remaining = std::vector<std::uint32_t>(vertexCount, 0);
+        for (const auto index : indices) { remaining[index] += 1; }
+        auto offsets = std::vector<std::uint32_t>(vertexCount + 1, 0);
+        for (auto v = 0; v < vertexCount; v++) { offsets[v + 1] = offsets[v] + remaining[v]; }
+        auto adjacency = std::vector<std::uint32_t>(indices.size());
+        {
+            auto fill = std::vector<std::uint32_t>(offsets.begin(), offsets.end() - 1);
+            for (auto i = 0; i < indices.size(); i++) {
+                adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+            }
+        }
+
+        auto cachePosition = std::vector<std::int32_t>(vertexCount, -1);
+        const auto vertexScore = [&](const std::uint32_t v) {
+            if (remaining[v] == 0) { return -1.0f; }
+            auto score = 0.0f;
+            const auto position = cachePosition[v];
+            if (position >= 0) {
+                if (position < 3) {
+                    score = LAST_TRIANGLE_SCORE;
+                } else {
+                    const auto scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+                    score = std::pow(1.0f - (position - 3) * scaler, CACHE_DECAY_POWER);
+                }
+            }
+            return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining[v]), -VALENCE_BOOST_POWER);
+        };
+
+        auto scores = std::vector<float>(vertexCount);
+        for (auto v = 0u; v < vertexCount; v++) { scores[v] = vertexScore(v); }
+        auto triangleScores = std::vector<float>(triangleCount);
+        auto emitted = std::vector<bool>(triangleCount, false);
+        auto best = NONE;
+        auto bestScore = -1.0f;
+        for (auto t = 0u; t < triangleCount; t++) {
+            triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+            if (triangleScores[t] > bestScore) {
+                bestScore = triangleScores[t];
+                best = t;
+            }
+        }
+
+        auto output = std::vector<std::uint32_t>{};
+        output.reserve(indices.size());
+        auto cache = std::vector<std::uint32_t>{};
+        auto newCache = std::vector<std::uint32_t>{};
+        auto cursor = 0u;
+        while (output.size() < indices.size()) {
+            if (best == NONE) {
+                // No candidate in the cache, continue with the next triangle in the original order
+                while (emitted[cursor]) { cursor += 1; }
+                best = cursor;
+            }
+            const std::uint32_t triangle[3] = {indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2]};
+            output.insert(output.end(), std::begin(triangle), std::end(triangle));
+            emitted[best] = true;
+            for (const auto v : triangle) {
+                const auto begin = adjacency.begin() + offsets[v];
+                const auto end = begin + remaining[v];
+                std::iter_swap(std::find(begin, end, best), end - 1);
+                remaining[v] -= 1;
+            }
+
+            // Most recently used vertices first
+            newCache.assign(std::begin(triangle), std::end(triangle));
+            for (const auto v : cache) {
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                    newCache.push_back(v);
+                }
+            }
+            for (auto i = 0; i < newCache.size(); i++) {
+                cachePosition[newCache[i]] = i < VERTEX_CACHE_SIZE ? static_cast<std::int32_t>(i) : -1;
+            }
+            for (const auto v : newCache) {
+                scores[v] = vertexScore(v);
+            }
+            best = NONE;
+            bestScore = -1.0f;
+            for (const auto v : newCache) {
+                for (auto i = offsets[v]; i < offsets[v] + remaining[v]; i++) {
+                    const auto t = adjacency[i];
+                    triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+                    if (triangleScores[t] > bestScore) {
+                        bestScore = triangleScores[t];
+                        best = t;
+                    }
+                }
+            }
+            if (newCache.size() > VERTEX_CACHE_SIZE) {
+                newCache.resize(VERTEX_CACHE_SIZE);
+            }
+            std::swap(cache, newCache);
+        }
+        indices = std::move(output);
+    }
+
+    void MeshImporter::optimizeVertexFetch(Mesh& mesh) {
+        static constexpr auto UNUSED{std::numeric_limits<std::uint32_t>::max()};
+        auto remap = std::vector<std::uint32_t>(mesh.vertices.size(), UNUSED);
+        auto vertices = std::vector<Vertex>{};
+        auto bitangentSigns = std::vector<float>{};
+        vertices.reserve(mesh.vertices.size());
+        bitangentSigns.reserve(mesh.vertices.size());
+        for (auto& index : mesh.indices) {
+            if (remap[index] == UNUSED) {
+                remap[index] = static_cast<std::uint32_t>(vertices.size());
+                vertices.push_back(mesh.vertices[index]);
+                bitangentSigns.push_back(mesh.bitangentSigns[index]);
+            }
+            index = remap[index];
+        }
+        mesh.vertices = std::move(vertices);
+        mesh.bitangentSigns = std::move(bitangentSigns);
+    }
+
+    void MeshImporter::buildMeshlets(Mesh& mesh) {
+        static constexpr auto UNUSED{std::numeric_limits<std::uint32_t>::max()};
+        mesh.meshlets.clear();
+        mesh.meshletVertices.clear();
+        mesh.meshletTriangles.clear();
+
+        // Index of the mesh vertices in the current meshlet
+        auto localIndices = std::vector<std::uint32_t>(mesh.vertices.size(), UNUSED);
+        auto meshlet = Meshlet{};
+        const auto finish = [&] {
+            if (meshlet.triangleCount == 0) { return; }
+            computeMeshletBounds(mesh, meshlet);
+            for (auto i = 0; i < meshlet.vertexCount; i++) {
+                localIndices[mesh.meshletVertices[meshlet.vertexOffset + i]] = UNUSED;
+            }
+            mesh.meshlets.push_back(meshlet);
+            meshlet = Meshlet{
+                .vertexOffset   = static_cast<std::uint32_t>(mesh.meshletVertices.size()),
+                .triangleOffset = static_cast<std::uint32_t>(mesh.meshletTriangles.size()),
+            };
+        };
+
+        // The triangles are already in a cache-friendly order, so neighbors are consecutive
+        for (auto i = 0; i < mesh.indices.size(); i += 3) {
+            auto newVertices = 0u;
+            for (auto j = 0; j < 3; j++) {
+                newVertices += localIndices[mesh.indices[i + j]] == UNUSED ? 1 : 0;
+            }
+            if (meshlet.vertexCount + newVertices > MESHLET_MAX_VERTICES ||
+                meshlet.triangleCount + 1 > MESHLET_MAX_TRIANGLES) {
+                finish();
+            }
+            for (auto j = 0; j < 3; j++) {
+                const auto index = mesh.indices[i + j];
+                if (localIndices[index] == UNUSED) {
+                    localIndices[index] = meshlet.vertexCount++;
+                    mesh.meshletVertices.push_back(index);
+                }
+                mesh.meshletTriangles.push_back(static_cast<std::uint8_t>(localIndices[index]));
+            }
+            meshlet.triangleCount += 1;
+        }
+        finish();
+    }
+
+    void MeshImporter::computeMeshletBounds(const Mesh& mesh, Meshlet& meshlet) {
+        // Bounding sphere centered on the bounding box
+        auto min = glm::vec3{std::numeric_limits<float>::max()};
+        auto max = glm::vec3{std::numeric_limits<float>::lowest()};
+        for (auto i = 0; i < meshlet.vertexCount; i++) {
+            const auto& position = mesh.vertices[mesh.meshletVertices[meshlet.vertexOffset + i]].position;
+            min = glm::min(min, position);
+            max = glm::max(max, position);
+        }
+        const auto center = (min + max) * 0.5f;
+        auto radius = 0.0f;
+        for (auto i = 0; i < meshlet.vertexCount; i++) {
+            const auto& position = mesh.vertices[mesh.meshletVertices[meshlet.vertexOffset + i]].position;
+            radius = std::max(radius, glm::distance(center, position));
+        }
+        meshlet.boundingSphere = glm::vec4{center, radius};
+
+        // Normal cone, used for cluster backface culling : the meshlet is hidden
+        // when dot(normalize(apex - cameraPosition), axis) >= cutoff
+        const auto getTriangle = [&](const std::uint32_t triangle, glm::vec3 positions[3]) {
+            for (auto j = 0; j < 3; j++) {
+                const auto local = mesh.meshletTriangles[meshlet.triangleOffset + triangle * 3 + j];
+                positions[j] = mesh.vertices[mesh.meshletVertices[meshlet.vertexOffset + local]].position;
+            }
+        };
+        auto normals = std::vector<glm::vec3>{};
+        normals.reserve(meshlet.triangleCount);
+        auto axis = glm::vec3{0.0f};
+        for (auto t = 0; t < meshlet.triangleCount; t++) {
+            glm::vec3 positions[3];
+            getTriangle(t, positions);
+            const auto normal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+            const auto length = glm::length(normal);
+            normals.push_back(length > 0.0f ? normal / length : glm::vec3{0.0f});
+            axis += normals.back();
+        }
+        meshlet.cone = glm::vec4{0.0f, 0.0f, 0.0f, 1.0f};
+        meshlet.coneApex = glm::vec4{center, 0.0f};
+        const auto axisLength = glm::length(axis);
+        if (axisLength < 1e-6f) { return; }
+        axis /= axisLength;
+
+        auto minDot = 1.0f;
+        for (const auto& normal : normals) {
+            minDot = std::min(minDot, glm::dot(normal, axis));
+        }
+        // Cone wider than ~85 degrees, not worth testing
+        if (minDot <= 0.1f) { return; }
+
+        // Move the apex back along the axis so that the cone contains all the triangles planes
+        auto maxT = 0.0f;
+        for (auto t = 0; t < meshlet.triangleCount; t++) {
+            glm::vec3 positions[3];
+            getTriangle(t, positions);
+            const auto dn = glm::dot(normals[t], axis);
+            if (dn <= 0.0f) { continue; }
+            maxT = std::max(maxT, glm::dot(center - positions[0], normals[t]) / dn);
+        }
+        // The normals are within acos(minDot) of the axis, the cutoff is the sine of that angle
+        meshlet.cone = glm::vec4{axis, std::sqrt(1.0f - minDot * minDot)};
+        meshlet.coneApex = glm::vec4{center - axis * maxT, 0.0f};
+    }
+
+    void MeshImporter::computeBounds(Mesh& mesh) {
+        auto min = glm::vec3{std::numeric_limits<float>::max()};
+        auto max = glm::vec3{std::numeric_limits<float>::lowest()};
+        for (const auto& vertex : mesh.vertices) {
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
+        }
+        mesh.boundsCenter = (min + max) * 0.5f;
+        mesh.boundsExtent = (max - min) * 0.5f;
+    }
+
+    namespace {
+
+        template<typename T>
+        void writeArray(std::ofstream& file, const std::vector<T>& data) {
+            const auto size = static_cast<std::uint64_t>(data.size());
+            file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(size * sizeof(T)));
+        }
+
+        template<typename T>
+        bool readArray(std::ifstream& file, const std::uint64_t fileSize, std::vector<T>& data) {
+            auto size = std::uint64_t{0};
+            // The size is checked against the end of the file before allocating
+            if (!file.read(reinterpret_cast<char*>(&size), sizeof(size)) ||
+                size > (fileSize - static_cast<std::uint64_t>(file.tellg())) / sizeof(T)) {
+                return false;
+            }
+            data.resize(size);
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size * sizeof(T))));
+        }
+
+    }
+
+    bool MeshImporter::readCache(const std::filesystem::path& path, const std::int64_t sourceTime, Mesh& mesh) {
+        auto file = std::ifstream{path, std::ios::binary};
+        if (!file) { return false; }
+        auto error = std::error_code{};
+        const auto fileSize = static_cast<std::uint64_t>(std::filesystem::file_size(path, error));
+        if (error) { return false; }
+        std::uint32_t magic, version;
+        std::int64_t time;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(&time), sizeof(time));
+        if (!file || magic != CACHE_MAGIC || version != CACHE_VERSION || time != sourceTime) {
+            return false;
+        }
+        if (!readArray(file, fileSize, mesh.vertices) ||
+            !readArray(file, fileSize, mesh.bitangentSigns) ||
+            !readArray(file, fileSize, mesh.indices) ||
+            !readArray(file, fileSize, mesh.meshlets) ||
+            !readArray(file, fileSize, mesh.meshletVertices) ||
+            !readArray(file, fileSize, mesh.meshletTriangles) ||
+            static_cast<std::uint64_t>(file.tellg()) != fileSize) {
+            return false;
+        }
+
+        // The indices are used without checks by the importer and the renderers
+        const auto vertexCount = mesh.vertices.size();
+        if (mesh.bitangentSigns.size() != vertexCount ||
+            !std::ranges::all_of(mesh.indices, [&](const auto index) { return index < vertexCount; }) ||
+            !std::ranges::all_of(mesh.meshletVertices, [&](const auto index) { return index < vertexCount; })) {
+            return false;
+        }
+        for (const auto& meshlet : mesh.meshlets) {
+            if (meshlet.vertexCount > MESHLET_MAX_VERTICES ||
+                meshlet.triangleCount > MESHLET_MAX_TRIANGLES ||
+                std::uint64_t{meshlet.vertexOffset} + meshlet.vertexCount > mesh.meshletVertices.size() ||
+                std::uint64_t{meshlet.triangleOffset} + meshlet.triangleCount * 3 > mesh.meshletTriangles.size()) {
+                return false;
+            }
+            for (auto i = 0u; i < meshlet.triangleCount * 3; i++) {
+                if (mesh.meshletTriangles[meshlet.triangleOffset + i] >= meshlet.vertexCount) { return false; }
+            }
+        }
+        return true;
+    }
+
+    void MeshImporter::writeCache(const std::filesystem::path& path, const std::int64_t sourceTime, const Mesh& mesh) {
+        // The cache is only an optimization, failing to write it is not an error.
+        // Written to a file of its own then renamed : a killed write, or another sample writing the same cache,
+        // never leaves a partial file under the cache name.
+        auto error = std::error_code{};
+        std::filesystem::create_directories(path.parent_path(), error);
+        auto temporaryPath = path;
+        temporaryPath += "." + std::to_string(std::random_device{}()) + ".tmp";
+        {
+            auto file = std::ofstream{temporaryPath, std::ios::binary | std::ios::trunc};
+            if (!file) { return; }
+            file.write(reinterpret_cast<const char*>(&CACHE_MAGIC), sizeof(CACHE_MAGIC));
+            file.write(reinterpret_cast<const char*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+            file.write(reinterpret_cast<const char*>(&sourceTime), sizeof(sourceTime));
+            writeArray(file, mesh.vertices);
+            writeArray(file, mesh.bitangentSigns);
+            writeArray(file, mesh.indices);
+            writeArray(file, mesh.meshlets);
+            writeArray(file, mesh.meshletVertices);
+            writeArray(file, mesh.meshletTriangles);
+            file.close();
+            if (!file) {
+                std::filesystem::remove(temporaryPath, error);
+                return;
+            }
+        }
+        std::filesystem::rename(temporaryPath, path, error);
+        if (error) {
+            std::filesystem::remove(temporaryPath, error);
+        }
+    }
+
+}
@@ -0,0 +1,76 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.meshimporter;
+
+import std;
+import glm;
+import samples.common.global;
+
+export namespace samples {
+
+    // Group of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles
+    struct Meshlet {
+        std::uint32_t vertexOffset;   // first index in Mesh::meshletVertices
+        std::uint32_t triangleOffset; // first index in Mesh::meshletTriangles
+        std::uint32_t vertexCount;
+        std::uint32_t triangleCount;
+        glm::vec4     boundingSphere; // xyz = center, w = radius
+        // xyz = axis, w = cutoff : the sine of the half angle of the normals cone, 1 if it can't be used for culling
+        glm::vec4     cone;
+        glm::vec4     coneApex;
+    };
+
+    struct Mesh {
+        std::vector<Vertex>        vertices;
+        std::vector<float>         bitangentSigns;   // one per vertex, for PackedVertex
+        std::vector<std::uint32_t> indices;
+        std::vector<Meshlet>       meshlets;
+        std::vector<std::uint32_t> meshletVertices;  // indices in vertices
+        std::vector<std::uint8_t>  meshletTriangles; // 3 indices in the meshlet vertices per triangle
+        glm::vec3                  boundsCenter{0.0f};
+        glm::vec3                  boundsExtent{0.0f};
+    };
+
+    class MeshImporter {
+    public:
+        static constexpr std::uint32_t MESHLET_MAX_VERTICES{64};
+        static constexpr std::uint32_t MESHLET_MAX_TRIANGLES{124};
+        static constexpr std::uint32_t VERTEX_CACHE_SIZE{32};
+
+        // Loads res/filename from the binary cache if it is up to date, or imports and optimizes it then
+        // updates the cache
+        static Mesh load(const std::string& filename, const std::string& cacheDirectory = "cache");
+
+        // Wavefront OBJ with positions, UVs and normals, polygons are triangulated and vertices deduplicated.
+        // UVs are used as stored in the file.
+        static Mesh importObj(const std::filesystem::path& path);
+
+        // Reorders the triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm)
+        static void optimizeVertexCache(std::vector<std::uint32_t>& indices, std::size_t vertexCount);
+
+        // Reorders the vertices in the order of their first use by the indices
+        static void optimizeVertexFetch(Mesh& mesh);
+
+        static void buildMeshlets(Mesh& mesh);
+
+    private:
+        static constexpr std::uint32_t CACHE_MAGIC{0x48534d56}; // "VMSH"
+        static constexpr std::uint32_t CACHE_VERSION{1};
+
+        static void generateTangents(Mesh& mesh);
+
+        static void computeBounds(Mesh& mesh);
+
+        static void computeMeshletBounds(const Mesh& mesh, Meshlet& meshlet);
+
+        // Returns false if there is no valid and up to date cache : missing, outdated, truncated or corrupted
+        static bool readCache(const std::filesystem::path& path, std::int64_t sourceTime, Mesh& mesh);
+
+        static void writeCache(const std::filesystem::path& path, std::int64_t sourceTime, const Mesh& mesh);
+    };
+
+}
@@ -0,0 +1,181 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.occlusionculling;
+
+namespace samples {
+
+    void OcclusionCulling::onInit(
+        const std::shared_ptr<vireo::Vireo>& vireo,
+        PipelineCache& pipelineCache,
+        const std::uint32_t framesInFlight) {
+        this->vireo = vireo;
+
+        descriptorLayout = vireo->createDescriptorLayout();
+        descriptorLayout->add(BINDING_PARAMS, vireo::DescriptorType::UNIFORM);
+        descriptorLayout->add(BINDING_MODELS, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_INSTANCE_INDICES, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_DEPTH, vireo::DescriptorType::SAMPLED_IMAGE);
+        descriptorLayout->add(BINDING_PYRAMID, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->add(BINDING_VISIBILITY, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->add(BINDING_LISTS, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->add(BINDING_COMMANDS, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->add(BINDING_COUNTER, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->build();
+
+        const auto resources = vireo->createPipelineResources({ descriptorLayout });
+        pipelineCache.declareComputePipeline(hizPipeline, resources, "shaders/hiz_build.comp");
+        pipelineCache.declareComputePipeline(earlyPipeline, resources, "shaders/occlusion_early.comp");
+        pipelineCache.declareComputePipeline(latePipeline, resources, "shaders/occlusion_late.comp");
+
+        framesData.resize(framesInFlight);
+        for (auto& frame : framesData) {
+            frame.paramsBuffer = vireo->createBuffer(vireo::BufferType::UNIFORM, sizeof(Params));
+            frame.paramsBuffer->map();
+            frame.counterBuffer = vireo->createBuffer(
+                vireo::BufferType::READWRITE_STORAGE, sizeof(std::uint32_t), 1, "Hi-Z counter");
+            frame.commandsBuffer = vireo->createBuffer(
+                vireo::BufferType::INDIRECT, sizeof(vireo::DrawIndexedIndirectCommand), 3, "Occlusion draw commands");
+            frame.descriptorSet = vireo->createDescriptorSet(descriptorLayout, "Occlusion culling");
+            frame.descriptorSet->update(BINDING_PARAMS, frame.paramsBuffer);
+            frame.descriptorSet->update(BINDING_COUNTER, frame.counterBuffer);
+            frame.descriptorSet->update(BINDING_COMMANDS, frame.commandsBuffer);
+        }
+    }
+
+    void OcclusionCulling::onResize(const vireo::Extent& extent) {
+        // Level 0 is half the depth buffer resolution, each level is half the previous one, rounded up
+        params.depthWidth = extent.width;
+        params.depthHeight = extent.height;
+        auto width = (extent.width + 1) / 2;
+        auto height = (extent.height + 1) / 2;
+        auto offset = 0u;
+        params.levelCount = 0;
+        while (params.levelCount < MAX_LEVELS) {
+            params.levels[params.levelCount++] = {width, height, offset, 0};
+            offset += width * height;
+            if (width == 1 && height == 1) { break; }
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+        params.groupCount =
+            ((extent.width + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE) *
+            ((extent.height + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE);
+
+        for (auto& frame : framesData) {
+            frame.pyramidBuffer = vireo->createBuffer(
+                vireo::BufferType::READWRITE_STORAGE, sizeof(glm::vec2), offset, "Hi-Z pyramid");
+            frame.descriptorSet->update(BINDING_PYRAMID, frame.pyramidBuffer);
+            frame.depthBuffer.reset();
+        }
+    }
+
+    void OcclusionCulling::earlyPass(
+        const std::uint32_t frameIndex,
+        const Scene& scene,
+        const std::shared_ptr<vireo::CommandList>& cmdList) {
+        auto& frame = framesData[frameIndex];
+        const auto instanceCount = scene.getInstanceCount();
+
+        if (frame.listCapacity < instanceCount) {
+            frame.listsBuffer = vireo->createBuffer(
+                vireo::BufferType::READWRITE_STORAGE, sizeof(std::uint32_t), 3 * instanceCount, "Occlusion lists");
+            frame.listCapacity = instanceCount;
+            frame.descriptorSet->update(BINDING_LISTS, frame.listsBuffer);
+            frame.buffersInitialized = false;
+        }
+        if (visibilityCapacity < scene.getTotalInstanceCount()) {
+            // The content is undefined : no history for all the frames until they write it in their late pass
+            visibilityCapacity = scene.getTotalInstanceCount();
+            visibilityBuffer = vireo->createBuffer(
+                vireo::BufferType::READWRITE_STORAGE, sizeof(std::uint32_t), visibilityCapacity, "Instances visibility");
+            visibilityInitialized = false;
+            for (auto& other : framesData) {
+                other.historyValid = false;
+            }
+        }
+        if (frame.visibilityBuffer != visibilityBuffer) {
+            frame.visibilityBuffer = visibilityBuffer;
+            frame.descriptorSet->update(BINDING_VISIBILITY, frame.visibilityBuffer);
+        }
+        if (frame.modelsBuffer != scene.getModelsBuffer(frameIndex)) {
+            frame.modelsBuffer = scene.getModelsBuffer(frameIndex);
+            frame.descriptorSet->update(BINDING_MODELS, frame.modelsBuffer);
+        }
+        if (frame.instanceIndicesBuffer != scene.getInstanceIndicesBuffer(frameIndex)) {
+            frame.instanceIndicesBuffer = scene.getInstanceIndicesBuffer(frameIndex);
+            frame.descriptorSet->update(BINDING_INSTANCE_INDICES, frame.instanceIndicesBuffer);
+        }
+
+        const auto& global = scene.getGlobal();
+        const auto& mesh = scene.getCubeMesh();
+        params.viewProjection = global.projection * global.view;
+        params.boundsCenter = glm::vec4{mesh.boundsCenter, 0.0f};
+        params.boundsExtent = glm::vec4{mesh.boundsExtent, 0.0f};
+        params.instanceCount = instanceCount;
+        params.firstInstance = scene.getFirstInstance();
+        params.indexCount = scene.getCubeRange().indexCount;
+        params.firstIndex = scene.getCubeRange().firstIndex;
+        params.listCapacity = frame.listCapacity;
+        // Without history the early pass only clears the draw commands
+        params.historyValid = frame.historyValid ? 1 : 0;
+        frame.paramsBuffer->write(&params);
+        frame.historyValid = true;
+
+        if (!frame.buffersInitialized) {
+            cmdList->barrier(frame.listsBuffer, vireo::ResourceState::UNDEFINED, vireo::ResourceState::SHADER_READ);
+            cmdList->barrier(frame.commandsBuffer, vireo::ResourceState::UNDEFINED, vireo::ResourceState::INDIRECT_DRAW);
+            frame.buffersInitialized = true;
+        }
+        // Written by the late pass of the previous frame, on the same queue
+        cmdList->barrier(
+            visibilityBuffer,
+            visibilityInitialized ? vireo::ResourceState::COMPUTE_WRITE : vireo::ResourceState::UNDEFINED,
+            vireo::ResourceState::COMPUTE_READ);
+        visibilityInitialized = true;
+        cmdList->barrier(frame.listsBuffer, vireo::ResourceState::SHADER_READ, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->barrier(frame.commandsBuffer, vireo::ResourceState::INDIRECT_DRAW, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->bindPipeline(earlyPipeline);
+        cmdList->bindDescriptors({frame.descriptorSet});
+        cmdList->dispatch((instanceCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+        cmdList->barrier(frame.listsBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::SHADER_READ);
+        cmdList->barrier(frame.commandsBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::INDIRECT_DRAW);
+    }
+
+    void OcclusionCulling::latePass(
+        const std::uint32_t frameIndex,
+        const std::shared_ptr<vireo::RenderTarget>& depthBuffer,
+        const vireo::ResourceState depthState,
+        const std::shared_ptr<vireo::CommandList>& cmdList) {
+        auto& frame = framesData[frameIndex];
+        if (frame.depthBuffer != depthBuffer) {
+            frame.depthBuffer = depthBuffer;
+            frame.descriptorSet->update(BINDING_DEPTH, depthBuffer->getImage());
+        }
+
+        // Single dispatch : each group reduces a 64x64 depth tile to 6 levels, the last group the remaining ones
+        cmdList->barrier(depthBuffer, depthState, vireo::ResourceState::SHADER_READ);
+        cmdList->bindPipeline(hizPipeline);
+        cmdList->bindDescriptors({frame.descriptorSet});
+        cmdList->dispatch(
+            (params.depthWidth + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE,
+            (params.depthHeight + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE,
+            1);
+        cmdList->barrier(depthBuffer, vireo::ResourceState::SHADER_READ, depthState);
+        cmdList->barrier(frame.pyramidBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::COMPUTE_READ);
+
+        cmdList->barrier(frame.visibilityBuffer, vireo::ResourceState::COMPUTE_READ, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->barrier(frame.listsBuffer, vireo::ResourceState::SHADER_READ, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->barrier(frame.commandsBuffer, vireo::ResourceState::INDIRECT_DRAW, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->bindPipeline(latePipeline);
+        cmdList->bindDescriptors({frame.descriptorSet});
+        cmdList->dispatch((params.instanceCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+        cmdList->barrier(frame.listsBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::SHADER_READ);
+        cmdList->barrier(frame.commandsBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::INDIRECT_DRAW);
+        cmdList->barrier(frame.pyramidBuffer, vireo::ResourceState::COMPUTE_READ, vireo::ResourceState::COMPUTE_WRITE);
+    }
+
+}
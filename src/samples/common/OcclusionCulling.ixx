@@ -0,0 +1,121 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.occlusionculling;
+
+import std;
+import vireo;
+import glm;
+import samples.common.pipelinecache;
+import samples.common.scene;
+
+export namespace samples {
+
+    // Two-phase GPU occlusion culling of the stress mode instances :
+    // the instances visible in the previous frame are drawn first (early list), a min/max
+    // hierarchical-Z pyramid is built from the resulting depth, then all the instances are tested
+    // against it and the newly visible ones are drawn (late list).
+    // The final list contains all the instances visible in this frame, for the next passes.
+    class OcclusionCulling {
+    public:
+        static constexpr std::uint32_t LIST_EARLY{0};
+        static constexpr std::uint32_t LIST_LATE{1};
+        static constexpr std::uint32_t LIST_FINAL{2};
+
+        void onInit(
+            const std::shared_ptr<vireo::Vireo>& vireo,
+            PipelineCache& pipelineCache,
+            std::uint32_t framesInFlight);
+
+        void onResize(const vireo::Extent& extent);
+
+        // Selects the instances visible in the previous frame
+        void earlyPass(
+            std::uint32_t frameIndex,
+            const Scene& scene,
+            const std::shared_ptr<vireo::CommandList>& cmdList);
+
+        // Builds the Hi-Z pyramid from the early depth then tests all the instances against it
+        void latePass(
+            std::uint32_t frameIndex,
+            const std::shared_ptr<vireo::RenderTarget>& depthBuffer,
+            vireo::ResourceState depthState,
+            const std::shared_ptr<vireo::CommandList>& cmdList);
+
+        // Instances lists, indices in the instances part of the models buffer
+        const auto& getListsBuffer(const std::uint32_t frameIndex) const { return framesData[frameIndex].listsBuffer; }
+        auto getListOffset(const std::uint32_t list, const std::uint32_t frameIndex) const {
+            return list * framesData[frameIndex].listCapacity;
+        }
+
+        const auto& getCommandsBuffer(const std::uint32_t frameIndex) const { return framesData[frameIndex].commandsBuffer; }
+        static auto getCommandOffset(const std::uint32_t list) { return list * sizeof(vireo::DrawIndexedIndirectCommand); }
+
+    private:
+        static constexpr std::uint32_t MAX_LEVELS{16};
+        static constexpr std::uint32_t GROUP_SIZE{64};
+        static constexpr std::uint32_t HIZ_TILE_SIZE{64}; // depth pixels reduced by one group
+
+        static constexpr vireo::DescriptorIndex BINDING_PARAMS{0};
+        static constexpr vireo::DescriptorIndex BINDING_MODELS{1};
+        static constexpr vireo::DescriptorIndex BINDING_INSTANCE_INDICES{2};
+        static constexpr vireo::DescriptorIndex BINDING_DEPTH{3};
+        static constexpr vireo::DescriptorIndex BINDING_PYRAMID{4};
+        static constexpr vireo::DescriptorIndex BINDING_VISIBILITY{5};
+        static constexpr vireo::DescriptorIndex BINDING_LISTS{6};
+        static constexpr vireo::DescriptorIndex BINDING_COMMANDS{7};
+        static constexpr vireo::DescriptorIndex BINDING_COUNTER{8};
+
+        struct Params {
+            glm::mat4     viewProjection;
+            glm::vec4     boundsCenter;
+            glm::vec4     boundsExtent;
+            std::uint32_t instanceCount;
+            std::uint32_t firstInstance;
+            std::uint32_t indexCount;
+            std::uint32_t listCapacity;
+            std::uint32_t depthWidth;
+            std::uint32_t depthHeight;
+            std::uint32_t levelCount;
+            std::uint32_t groupCount;
+            std::uint32_t historyValid;
+            std::uint32_t firstIndex;
+            std::uint32_t padding[2];
+            glm::uvec4    levels[MAX_LEVELS]; // x, y = size, z = offset in the pyramid buffer
+        };
+
+        struct FrameData {
+            std::shared_ptr<vireo::Buffer>        paramsBuffer;
+            std::shared_ptr<vireo::Buffer>        pyramidBuffer;
+            std::shared_ptr<vireo::Buffer>        counterBuffer;
+            std::shared_ptr<vireo::Buffer>        listsBuffer;
+            std::shared_ptr<vireo::Buffer>        commandsBuffer;
+            std::shared_ptr<vireo::DescriptorSet> descriptorSet;
+            // Buffers currently bound to the descriptor set
+            std::shared_ptr<vireo::Buffer>        modelsBuffer;
+            std::shared_ptr<vireo::Buffer>        instanceIndicesBuffer;
+            std::shared_ptr<vireo::Buffer>        visibilityBuffer;
+            std::shared_ptr<vireo::RenderTarget>  depthBuffer;
+            std::uint32_t                         listCapacity{0};
+            bool                                  historyValid{false};
+            bool                                  buffersInitialized{false};
+        };
+
+        Params                                   params{};
+        std::vector<FrameData>                   framesData;
+        // Visibility of each scene instance in the last frame, shared by the frames :
+        // read by the early pass then written by the late pass, in the submission order
+        std::shared_ptr<vireo::Buffer>           visibilityBuffer;
+        std::uint32_t                            visibilityCapacity{0};
+        bool                                     visibilityInitialized{false};
+        std::shared_ptr<vireo::Vireo>            vireo;
+        std::shared_ptr<vireo::DescriptorLayout> descriptorLayout;
+        std::shared_ptr<vireo::Pipeline>         hizPipeline;
+        std::shared_ptr<vireo::Pipeline>         earlyPipeline;
+        std::shared_ptr<vireo::Pipeline>         latePipeline;
+    };
+
+}
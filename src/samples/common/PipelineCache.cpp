@@ -0,0 +1,337 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.pipelinecache;
+
+namespace samples {
+
+    namespace {
+
+        constexpr std::uint64_t FNV_OFFSET{0xcbf29ce484222325};
+        constexpr std::uint64_t FNV_PRIME{0x100000001b3};
+
+        void hash(std::uint64_t& value, const void* data, const std::size_t size) {
+            const auto* bytes = static_cast<const std::uint8_t*>(data);
+            for (auto i = 0uz; i < size; i++) {
+                value = (value ^ bytes[i]) * FNV_PRIME;
+            }
+        }
+
+        // Driver packages and Vulkan drivers manifests with their dates, rewritten when a driver is updated
+        std::vector<std::pair<std::filesystem::path, std::int64_t>> getDriverFiles() {
+#ifdef _WIN32
+            const auto directories = {std::filesystem::path{"C:/Windows/System32/DriverStore/FileRepository"}};
+#else
+            const auto directories = {
+                std::filesystem::path{"/usr/share/vulkan/icd.d"},
+                std::filesystem::path{"/etc/vulkan/icd.d"}};
+#endif
+            auto files = std::vector<std::pair<std::filesystem::path, std::int64_t>>{};
+            auto error = std::error_code{};
+            for (const auto& directory : directories) {
+                for (const auto& entry : std::filesystem::directory_iterator{directory, error}) {
+                    const auto time = entry.last_write_time(error);
+                    if (!error) {
+                        files.emplace_back(entry.path(), time.time_since_epoch().count());
+                    }
+                }
+            }
+            // The directory order is unspecified
+            std::ranges::sort(files);
+            return files;
+        }
+
+    }
+
+    void PipelineCache::onInit(
+        const std::shared_ptr<vireo::Vireo>& vireo,
+        WorkerPool& workerPool,
+        const vireo::Backend backend,
+        const std::string& cacheDirectory) {
+        this->vireo = vireo;
+        workers = &workerPool;
+        threadsCount = workers->getThreadCount();
+        startTime = std::chrono::steady_clock::now();
+        path = std::filesystem::path{cacheDirectory} / "startup.manifest";
+        // Without the archive the shaders are read from the individual binaries
+        archive.open(backend == vireo::Backend::VULKAN ? "shaders/spirv.pack" : "shaders/dxil.pack");
+        const auto identity = computeIdentity(backend);
+        manifestMatch = readManifest() && manifest.identity == identity;
+        if (!manifestMatch) {
+            manifest = Manifest{ identity };
+        }
+    }
+
+    void PipelineCache::declareGraphicPipeline(
+        std::shared_ptr<vireo::Pipeline>& pipeline,
+        const vireo::GraphicPipelineConfiguration& configuration,
+        const std::string& vertexShader,
+        const std::string& fragmentShader) {
+        const auto key = getPipelineKey(configuration, vertexShader, fragmentShader);
+        if (!pipelines.contains(key)) {
+            keyedObjects.push_back(configuration.resources);
+            keyedObjects.push_back(configuration.vertexInputLayout);
+        }
+        declare(pipeline, key, [this, config = configuration, vertexShader, fragmentShader]() mutable {
+            config.vertexShader = getShaderModule(vertexShader);
+            if (!fragmentShader.empty()) {
+                config.fragmentShader = getShaderModule(fragmentShader);
+            }
+            return std::shared_ptr<vireo::Pipeline>{vireo->createGraphicPipeline(config)};
+        });
+    }
+
+    void PipelineCache::declareComputePipeline(
+        std::shared_ptr<vireo::Pipeline>& pipeline,
+        const std::shared_ptr<vireo::PipelineResources>& resources,
+        const std::string& shader) {
+        auto key = FNV_OFFSET;
+        const auto shaderKey = getShaderKey(shader);
+        const auto resourcesKey = resources.get();
+        hash(key, &shaderKey, sizeof(shaderKey));
+        hash(key, &resourcesKey, sizeof(resourcesKey));
+        if (!pipelines.contains(key)) {
+            keyedObjects.push_back(resources);
+        }
+        declare(pipeline, key, [this, resources, shader] {
+            return std::shared_ptr<vireo::Pipeline>{vireo->createComputePipeline(resources, getShaderModule(shader))};
+        });
+    }
+
+    std::shared_ptr<vireo::ShaderModule> PipelineCache::getShaderModule(const std::string& fileName) {
+        const auto key = getShaderKey(fileName);
+        auto created = std::promise<std::shared_ptr<vireo::ShaderModule>>{};
+        auto shaderModule = std::shared_future<std::shared_ptr<vireo::ShaderModule>>{};
+        auto first = false;
+        {
+            auto lock = std::lock_guard{mutex};
+            if (const auto it = shaderModules.find(key); it != shaderModules.end()) {
+                shaderModule = it->second;
+                shaderModulesReused += 1;
+            } else {
+                shaderModule = created.get_future().share();
+                shaderModules[key] = shaderModule;
+                first = true;
+            }
+        }
+        // The first user creates the module, the others wait for it
+        if (first) {
+            try {
+                const auto code = archive.get(std::filesystem::path{fileName}.filename().string());
+                if (code.empty()) {
+                    created.set_value(vireo->createShaderModule(fileName));
+                } else {
+                    const auto bytes = reinterpret_cast<const char*>(code.data());
+                    created.set_value(vireo->createShaderModule(std::vector<char>(bytes, bytes + code.size()), fileName));
+                }
+            } catch (...) {
+                created.set_exception(std::current_exception());
+            }
+        }
+        return shaderModule.get();
+    }
+
+    void PipelineCache::declare(
+        std::shared_ptr<vireo::Pipeline>& pipeline,
+        const std::uint64_t key,
+        std::function<std::shared_ptr<vireo::Pipeline>()> create) {
+        if (const auto it = pipelines.find(key); it != pipelines.end()) {
+            pipelinesReused += 1;
+            if (creating) {
+                // Written by wait(), the pipeline may still be in creation
+                reusedPipelines.push_back({&pipeline, it->second});
+            } else {
+                // Created, rethrows the creation error if it failed
+                pipeline = it->second.get();
+            }
+            return;
+        }
+        if (started) {
+            // Declared after the startup, nothing waits for the workers anymore
+            pipeline = create();
+            auto created = std::promise<std::shared_ptr<vireo::Pipeline>>{};
+            created.set_value(pipeline);
+            pipelines[key] = created.get_future().share();
+            return;
+        }
+        creating = true;
+        if (pipelinesCount == 0) {
+            firstDeclarationTime = std::chrono::steady_clock::now();
+        }
+        pipelinesCount += 1;
+        const auto created = std::make_shared<std::promise<std::shared_ptr<vireo::Pipeline>>>();
+        pipelines[key] = created->get_future().share();
+        workers->submit([this, &pipeline, created, create = std::move(create)] {
+            const auto start = std::chrono::steady_clock::now();
+            try {
+                pipeline = create();
+                created->set_value(pipeline);
+            } catch (...) {
+                created->set_exception(std::current_exception());
+                auto lock = std::lock_guard{mutex};
+                if (!error) { error = std::current_exception(); }
+                return;
+            }
+            const auto time = std::chrono::steady_clock::now() - start;
+            auto lock = std::lock_guard{mutex};
+            pipelinesTotalTime += time;
+            longestPipelineTime = std::max(longestPipelineTime, std::chrono::duration_cast<std::chrono::nanoseconds>(time));
+        }, &creations);
+    }
+
+    void PipelineCache::wait() {
+        started = true;
+        if (creating) {
+            // Only the pipelines jobs, the pool is shared with the application
+            workers->wait(creations);
+            creating = false;
+            pipelinesTime = std::chrono::steady_clock::now() - firstDeclarationTime;
+        }
+        if (error) {
+            reusedPipelines.clear();
+            std::rethrow_exception(std::exchange(error, nullptr));
+        }
+        for (const auto& [pipeline, created] : reusedPipelines) {
+            *pipeline = created.get();
+        }
+        reusedPipelines.clear();
+    }
+
+    std::uint64_t PipelineCache::getShaderKey(const std::string& fileName) const {
+        auto key = FNV_OFFSET;
+        const auto code = archive.get(std::filesystem::path{fileName}.filename().string());
+        if (code.empty()) {
+            hash(key, fileName.data(), fileName.size());
+        } else {
+            hash(key, code.data(), code.size());
+        }
+        return key;
+    }
+
+    std::uint64_t PipelineCache::getPipelineKey(
+        const vireo::GraphicPipelineConfiguration& configuration,
+        const std::string& vertexShader,
+        const std::string& fragmentShader) const {
+        auto key = FNV_OFFSET;
+        const auto add = [&key](const auto& value) { hash(key, &value, sizeof(value)); };
+        const auto addStencil = [&add](const auto& state) {
+            add(state.failOp);
+            add(state.passOp);
+            add(state.depthFailOp);
+            add(state.compareOp);
+            add(state.compareMask);
+            add(state.writeMask);
+        };
+        add(getShaderKey(vertexShader));
+        add(fragmentShader.empty() ? std::uint64_t{0} : getShaderKey(fragmentShader));
+        // The layouts are shared objects, compared by address
+        add(configuration.resources.get());
+        add(configuration.vertexInputLayout.get());
+        for (const auto format : configuration.colorRenderFormats) {
+            add(format);
+        }
+        for (const auto& blend : configuration.colorBlendDesc) {
+            add(blend.blendEnable);
+            add(blend.srcColorBlendFactor);
+            add(blend.dstColorBlendFactor);
+            add(blend.colorBlendOp);
+            add(blend.srcAlphaBlendFactor);
+            add(blend.dstAlphaBlendFactor);
+            add(blend.alphaBlendOp);
+            add(blend.colorWriteMask);
+        }
+        add(configuration.msaa);
+        add(configuration.cullMode);
+        add(configuration.depthTestEnable);
+        add(configuration.depthWriteEnable);
+        add(configuration.depthStencilImageFormat);
+        add(configuration.stencilTestEnable);
+        addStencil(configuration.frontStencilOpState);
+        addStencil(configuration.backStencilOpState);
+        return key;
+    }
+
+    std::string PipelineCache::getPermutation(const std::string& fileName, const std::uint32_t key) {
+        const auto stage = fileName.rfind('.');
+        return fileName.substr(0, stage) + "_" + std::to_string(key) + fileName.substr(stage);
+    }
+
+    void PipelineCache::onStartupDone() {
+        const auto ms = [](const auto duration) { return std::chrono::duration<float, std::milli>(duration).count(); };
+        const auto startup = ms(std::chrono::steady_clock::now() - startTime);
+        // Nothing is reused from the previous run : a match only tells that both startup times are comparable
+        std::cout << "Startup : " << startup << " ms, ";
+        if (manifestMatch) {
+            std::cout << "manifest match (previous start : " << manifest.startMilliseconds << " ms), ";
+        } else {
+            std::cout << "no manifest match, ";
+        }
+        manifest.startMilliseconds = startup;
+        std::cout << pipelinesCount << " pipelines created in " << ms(pipelinesTime) << " ms on "
+                  << threadsCount << " threads (longest : " << ms(longestPipelineTime) << " ms, sum : "
+                  << ms(pipelinesTotalTime) << " ms, " << pipelinesReused << " reused), "
+                  << shaderModules.size() << " shader modules ("
+                  << shaderModulesReused << " reused) read from " << (archive.isOpen() ? "the shaders archive" : "the shader files")
+                  << std::endl;
+    }
+
+    void PipelineCache::onDestroy() {
+        // The manifest is only used for the startup report, failing to write it is not an error
+        auto error = std::error_code{};
+        std::filesystem::create_directories(path.parent_path(), error);
+        auto file = std::ofstream{path, std::ios::binary | std::ios::trunc};
+        if (!file) { return; }
+        file.write(reinterpret_cast<const char*>(&MANIFEST_MAGIC), sizeof(MANIFEST_MAGIC));
+        file.write(reinterpret_cast<const char*>(&MANIFEST_VERSION), sizeof(MANIFEST_VERSION));
+        file.write(reinterpret_cast<const char*>(&manifest), sizeof(manifest));
+    }
+
+    std::uint64_t PipelineCache::computeIdentity(const vireo::Backend backend) const {
+        auto value = FNV_OFFSET;
+        hash(value, &backend, sizeof(backend));
+        const auto& description = vireo->getPhysicalDevice()->getDescription();
+        const auto deviceName = std::string{description.name};
+        hash(value, deviceName.data(), deviceName.size());
+        hash(value, &description.dedicatedVideoMemory, sizeof(description.dedicatedVideoMemory));
+        // The RHI does not expose the driver version, the dates of the installed drivers stand for it
+        for (const auto& driver : getDriverFiles()) {
+            const auto name = driver.first.string();
+            hash(value, name.data(), name.size());
+            hash(value, &driver.second, sizeof(driver.second));
+        }
+
+        // Any rebuilt shader breaks the match, the directory order is unspecified
+        const auto extension = backend == vireo::Backend::VULKAN ? ".spv" : ".dxil";
+        auto binaries = std::vector<std::filesystem::path>{};
+        auto error = std::error_code{};
+        for (const auto& entry : std::filesystem::directory_iterator{"shaders", error}) {
+            if (entry.is_regular_file() && entry.path().extension() == extension) {
+                binaries.push_back(entry.path());
+            }
+        }
+        std::ranges::sort(binaries);
+        for (const auto& binary : binaries) {
+            const auto name = binary.filename().string();
+            const auto size = static_cast<std::uint64_t>(std::filesystem::file_size(binary, error));
+            const auto time = std::filesystem::last_write_time(binary, error).time_since_epoch().count();
+            hash(value, name.data(), name.size());
+            hash(value, &size, sizeof(size));
+            hash(value, &time, sizeof(time));
+        }
+        return value;
+    }
+
+    bool PipelineCache::readManifest() {
+        auto file = std::ifstream{path, std::ios::binary};
+        if (!file) { return false; }
+        std::uint32_t magic, version;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(&manifest), sizeof(manifest));
+        return file && magic == MANIFEST_MAGIC && version == MANIFEST_VERSION;
+    }
+
+}
@@ -0,0 +1,129 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.pipelinecache;
+
+import std;
+import vireo;
+import samples.common.shaderarchive;
+import samples.common.workerpool;
+
+export namespace samples {
+
+    // Creates the pipelines of the samples and measures the startup.
+    // The passes declare their pipelines during their initialization, the shader modules and the pipelines
+    // are then created in parallel by the worker pool of the application while it continues its initialization.
+    // The shader binaries are read from the memory mapped shaders archive of the backend.
+    // The shader modules are keyed by the hash of their binary and the pipelines by the hash of their
+    // configuration : identical modules and pipelines are created once and shared by all the passes,
+    // including the pipelines declared again after the first frame.
+    // No pipeline data is saved : the RHI does not give access to the driver pipeline cache.
+    // A startup manifest is saved on shutdown with the identity of the run (backend, device, drivers and shader
+    // binaries) and its startup time. Nothing else is reused : when the manifest matches the current run the
+    // previous startup time is reported for comparison.
+    class PipelineCache {
+    public:
+        // The worker pool is shared with the application and must outlive the cache
+        void onInit(
+            const std::shared_ptr<vireo::Vireo>& vireo,
+            WorkerPool& workerPool,
+            vireo::Backend backend,
+            const std::string& cacheDirectory = "cache");
+
+        // Queues the creation of a graphic pipeline with its shader modules, or reuses an identical one.
+        // Until the first wait() the pipeline is written by a worker thread or by wait() and must not be used
+        // before wait(). After it, the pipeline is created or reused on the calling thread and written on return.
+        // No fragment shader if fragmentShader is empty.
+        void declareGraphicPipeline(
+            std::shared_ptr<vireo::Pipeline>& pipeline,
+            const vireo::GraphicPipelineConfiguration& configuration,
+            const std::string& vertexShader,
+            const std::string& fragmentShader = {});
+
+        void declareComputePipeline(
+            std::shared_ptr<vireo::Pipeline>& pipeline,
+            const std::shared_ptr<vireo::PipelineResources>& resources,
+            const std::string& shader);
+
+        // Waits for all the declared pipelines and rethrows the first creation error,
+        // called by the applications before the first frame
+        void wait();
+
+        // Prints the startup times, called by the applications at the end of their initialization
+        void onStartupDone();
+
+        // Saves the startup manifest
+        void onDestroy();
+
+        // Returns the shader module of a "shaders/name.stage" file, created on first use of its binary. Thread safe.
+        std::shared_ptr<vireo::ShaderModule> getShaderModule(const std::string& fileName);
+
+        // True when the previous run had the same identity
+        auto isManifestMatch() const { return manifestMatch; }
+
+        // "shaders/name_<key>.stage" permutation of a "shaders/name.stage" file for a features key
+        static std::string getPermutation(const std::string& fileName, std::uint32_t key);
+
+    private:
+        static constexpr std::uint32_t MANIFEST_MAGIC{0x54535056}; // "VPST"
+        static constexpr std::uint32_t MANIFEST_VERSION{2};
+
+        struct Manifest {
+            std::uint64_t identity{0};
+            float         startMilliseconds{0.0f};
+        };
+
+        std::shared_ptr<vireo::Vireo>         vireo;
+        std::filesystem::path                 path;
+        Manifest                              manifest;
+        bool                                  manifestMatch{false};
+        std::chrono::steady_clock::time_point startTime;
+        ShaderArchive                         archive;
+        std::unordered_map<std::uint64_t, std::shared_future<std::shared_ptr<vireo::ShaderModule>>> shaderModules;
+        std::uint32_t                         shaderModulesReused{0};
+        // Only used by the thread declaring the pipelines
+        std::unordered_map<std::uint64_t, std::shared_future<std::shared_ptr<vireo::Pipeline>>> pipelines;
+        std::vector<std::pair<std::shared_ptr<vireo::Pipeline>*, std::shared_future<std::shared_ptr<vireo::Pipeline>>>> reusedPipelines;
+        std::uint32_t                         pipelinesReused{0};
+        // The layouts are keyed by address, kept alive so that their address is not reused
+        std::vector<std::shared_ptr<const void>> keyedObjects;
+        WorkerPool*                           workers{nullptr};
+        // Pipelines in creation, waited for by wait()
+        WorkerPool::Counter                   creations;
+        bool                                  creating{false};
+        // Set by the first wait(), the next declarations are resolved immediately
+        bool                                  started{false};
+        std::mutex                            mutex;
+        std::exception_ptr                    error;
+        std::uint32_t                         pipelinesCount{0};
+        std::uint32_t                         threadsCount{0};
+        std::chrono::steady_clock::time_point firstDeclarationTime;
+        // From the first declaration to the end of the wait, and of all the creations
+        std::chrono::nanoseconds              pipelinesTime{0};
+        std::chrono::nanoseconds              pipelinesTotalTime{0};
+        std::chrono::nanoseconds              longestPipelineTime{0};
+
+        void declare(
+            std::shared_ptr<vireo::Pipeline>& pipeline,
+            std::uint64_t key,
+            std::function<std::shared_ptr<vireo::Pipeline>()> create);
+
+        // Hash of the binary in the archive, or of the file name if it is not in the archive
+        std::uint64_t getShaderKey(const std::string& fileName) const;
+
+        // Hash of the configuration fields set by the samples, the others must keep their default values
+        std::uint64_t getPipelineKey(
+            const vireo::GraphicPipelineConfiguration& configuration,
+            const std::string& vertexShader,
+            const std::string& fragmentShader) const;
+
+        // Hash of the backend, the device and the names, sizes and dates of the shader binaries
+        std::uint64_t computeIdentity(vireo::Backend backend) const;
+
+        bool readManifest();
+    };
+
+}
@@ -16,6 +16,7 @@ namespace samples {
 
     void PostProcessing::onInit(
            const std::shared_ptr<vireo::Vireo>& vireo,
+           PipelineCache& pipelineCache,
            const vireo::ImageFormat renderFormat,
            const Samplers& samplers,
            const std::uint32_t framesInFlight) {
@@ -36,8 +37,6 @@ namespace samples {
         taaDescriptorLayout->add(BINDING_VELOCITY, vireo::DescriptorType::SAMPLED_IMAGE);
         taaDescriptorLayout->build();
 
-        pipelineConfig.vertexShader = vireo->createShaderModule("shaders/quad.vert");
-
         const auto resources = vireo->createPipelineResources({
             descriptorLayout,
             samplers.getDescriptorLayout() });
@@ -47,16 +46,12 @@ namespace samples {
 
         pipelineConfig.colorRenderFormats.push_back(renderFormat);
         pipelineConfig.resources = taaResources;
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/taa.frag");
-        taaPipeline = vireo->createGraphicPipeline(pipelineConfig);
+        pipelineCache.declareGraphicPipeline(taaPipeline, pipelineConfig, "shaders/quad.vert", "shaders/taa.frag");
 
         pipelineConfig.resources = resources;
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/fxaa.frag");
-        fxaaPipeline = vireo->createGraphicPipeline(pipelineConfig);
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/voronoi.frag");
-        effectPipeline = vireo->createGraphicPipeline(pipelineConfig);
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/gamma_correction.frag");
-        gammaCorrectionPipeline = vireo->createGraphicPipeline(pipelineConfig);
+        pipelineCache.declareGraphicPipeline(fxaaPipeline, pipelineConfig, "shaders/quad.vert", "shaders/fxaa.frag");
+        pipelineCache.declareGraphicPipeline(effectPipeline, pipelineConfig, "shaders/quad.vert", "shaders/voronoi.frag");
+        pipelineCache.declareGraphicPipeline(gammaCorrectionPipeline, pipelineConfig, "shaders/quad.vert", "shaders/gamma_correction.frag");
 
         smaaDataBuffer = vireo->createBuffer(vireo::BufferType::UNIFORM, sizeof(SmaaData));
         smaaDataBuffer->map();
@@ -79,15 +74,12 @@ namespace samples {
 
         pipelineConfig.resources = smaaResources;
         pipelineConfig.colorRenderFormats[0] = vireo::ImageFormat::R16G16_SFLOAT;
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/smaa_edge_detect.frag");
-        smaaEdgePipeline = vireo->createGraphicPipeline(pipelineConfig);
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/smaa_blend_weight.frag");
-        smaaBlendWeightPipeline = vireo->createGraphicPipeline(pipelineConfig);
+        pipelineCache.declareGraphicPipeline(smaaEdgePipeline, pipelineConfig, "shaders/quad.vert", "shaders/smaa_edge_detect.frag");
+        pipelineCache.declareGraphicPipeline(smaaBlendWeightPipeline, pipelineConfig, "shaders/quad.vert", "shaders/smaa_blend_weight.frag");
 
         pipelineConfig.resources = smaaBlendResources;
         pipelineConfig.colorRenderFormats[0] = renderFormat;
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/smaa_neighborhood_blend.frag");
-        smaaBlendPipeline = vireo->createGraphicPipeline(pipelineConfig);
+        pipelineCache.declareGraphicPipeline(smaaBlendPipeline, pipelineConfig, "shaders/quad.vert", "shaders/smaa_neighborhood_blend.frag");
 
         framesData.resize(framesInFlight);
         for (auto& frame : framesData) {
@@ -119,94 +111,56 @@ namespace samples {
        const std::shared_ptr<vireo::CommandList>& cmdList,
        const std::shared_ptr<vireo::RenderTarget>& colorBuffer) {
         auto& frame = framesData[frameIndex];
-        std::vector<std::shared_ptr<vireo::Image>> shaderReadTargets;
-
-        if (!frame.colorBuffersInitialized) {
-            cmdList->barrier(
-                frame.effectColorBuffer,
-                vireo::ResourceState::UNDEFINED,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-            cmdList->barrier(
-                frame.gammaCorrectionColorBuffer,
-                vireo::ResourceState::UNDEFINED,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-            cmdList->barrier(
-                frame.fxaaColorBuffer,
-                vireo::ResourceState::UNDEFINED,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-            cmdList->barrier(
-                frame.smaaEdgeBuffer,
-                vireo::ResourceState::UNDEFINED,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-            cmdList->barrier(
-                frame.smaaBlendBuffer,
-                vireo::ResourceState::UNDEFINED,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-            cmdList->barrier(
-                frame.smaaColorBuffer,
-                vireo::ResourceState::UNDEFINED,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-        }
+        stateTracker.track(colorBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
 
         if (applyEffect) {
             const auto colorInput =
-                applyTAA ? frame.taaColorBuffer[taaIndex]->getImage() :
-                colorBuffer->getImage();
-            frame.effectDescriptorSet->update(BINDING_INPUT, colorInput);
+                applyTAA ? frame.taaColorBuffer[taaIndex] :
+                colorBuffer;
+            descriptorCache.update(frame.effectDescriptorSet, BINDING_INPUT, colorInput->getImage());
             renderingConfig.colorRenderTargets[0].renderTarget = frame.effectColorBuffer;
-            cmdList->barrier(
-                colorInput,
-                vireo::ResourceState::RENDER_TARGET_COLOR,
-                vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(colorInput, vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(frame.effectColorBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.flush(cmdList);
             cmdList->beginRendering(renderingConfig);
             cmdList->bindPipeline(effectPipeline);
             cmdList->bindDescriptors({frame.effectDescriptorSet, samplers.getDescriptorSet()});
             cmdList->draw(3);
             cmdList->endRendering();
-            cmdList->barrier(
-                colorInput,
-                vireo::ResourceState::SHADER_READ,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-            shaderReadTargets.push_back(colorInput);
+            stateTracker.transition(colorInput, vireo::ResourceState::RENDER_TARGET_COLOR);
         }
 
         if (applyGammaCorrection) {
             const auto colorInput =
-                applyEffect ? frame.effectColorBuffer->getImage() :
-                applyTAA ? frame.taaColorBuffer[taaIndex]->getImage() :
-                colorBuffer->getImage();
-            frame.gammaCorrectionDescriptorSet->update(BINDING_INPUT, colorInput);
+                applyEffect ? frame.effectColorBuffer :
+                applyTAA ? frame.taaColorBuffer[taaIndex] :
+                colorBuffer;
+            descriptorCache.update(frame.gammaCorrectionDescriptorSet, BINDING_INPUT, colorInput->getImage());
             renderingConfig.colorRenderTargets[0].renderTarget = frame.gammaCorrectionColorBuffer;
-            cmdList->barrier(
-                colorInput,
-                vireo::ResourceState::RENDER_TARGET_COLOR,
-                vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(colorInput, vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(frame.gammaCorrectionColorBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.flush(cmdList);
             cmdList->beginRendering(renderingConfig);
             cmdList->bindPipeline(gammaCorrectionPipeline);
             cmdList->bindDescriptors({frame.gammaCorrectionDescriptorSet, samplers.getDescriptorSet()});
             cmdList->draw(3);
             cmdList->endRendering();
-            cmdList->barrier(
-                colorInput,
-                vireo::ResourceState::SHADER_READ,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-            shaderReadTargets.push_back(colorInput);
+            stateTracker.transition(colorInput, vireo::ResourceState::RENDER_TARGET_COLOR);
         }
 
         if (applySMAA) {
             const auto colorInput =
-                applyGammaCorrection ? frame.gammaCorrectionColorBuffer->getImage() :
-                applyEffect ? frame.effectColorBuffer->getImage() :
-                applyTAA ? frame.taaColorBuffer[taaIndex]->getImage() :
-                colorBuffer->getImage();
+                applyGammaCorrection ? frame.gammaCorrectionColorBuffer :
+                applyEffect ? frame.effectColorBuffer :
+                applyTAA ? frame.taaColorBuffer[taaIndex] :
+                colorBuffer;
 
-            frame.smaaEdgeDescriptorSet->update(SMAA_BINDING_INPUT, colorInput);
-            frame.smaaBlendWeightDescriptorSet->update(SMAA_BINDING_INPUT, frame.smaaEdgeBuffer->getImage());
-            frame.smaaBlendDescriptorSet->update(SMAA_BLEND_BINDING_INPUT, colorInput);
-            frame.smaaBlendDescriptorSet->update(SMAA_BLEND_BINDING_BLEND, frame.smaaBlendBuffer->getImage());
-
-            cmdList->barrier(colorInput, vireo::ResourceState::RENDER_TARGET_COLOR, vireo::ResourceState::SHADER_READ);
+            descriptorCache.update(frame.smaaEdgeDescriptorSet, SMAA_BINDING_INPUT, colorInput->getImage());
+            descriptorCache.update(frame.smaaBlendDescriptorSet, SMAA_BLEND_BINDING_INPUT, colorInput->getImage());
 
+            stateTracker.transition(colorInput, vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(frame.smaaEdgeBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.flush(cmdList);
             renderingConfig.colorRenderTargets[0].renderTarget = frame.smaaEdgeBuffer;
             cmdList->beginRendering(renderingConfig);
             cmdList->setViewport(vireo::Viewport{static_cast<float>(extent.width), static_cast<float>(extent.height)});
@@ -216,7 +170,9 @@ namespace samples {
             cmdList->draw(3);
             cmdList->endRendering();
 
-            cmdList->barrier(frame.smaaEdgeBuffer, vireo::ResourceState::RENDER_TARGET_COLOR, vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(frame.smaaEdgeBuffer, vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(frame.smaaBlendBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.flush(cmdList);
             renderingConfig.colorRenderTargets[0].renderTarget = frame.smaaBlendBuffer;
             cmdList->beginRendering(renderingConfig);
             cmdList->setViewport(vireo::Viewport{static_cast<float>(extent.width), static_cast<float>(extent.height)});
@@ -225,9 +181,11 @@ namespace samples {
             cmdList->bindDescriptors({frame.smaaBlendWeightDescriptorSet, samplers.getDescriptorSet()});
             cmdList->draw(3);
             cmdList->endRendering();
-            cmdList->barrier(frame.smaaEdgeBuffer, vireo::ResourceState::SHADER_READ, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.transition(frame.smaaEdgeBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
 
-            cmdList->barrier(frame.smaaBlendBuffer, vireo::ResourceState::RENDER_TARGET_COLOR, vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(frame.smaaBlendBuffer, vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(frame.smaaColorBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.flush(cmdList);
             renderingConfig.colorRenderTargets[0].renderTarget = frame.smaaColorBuffer;
             cmdList->beginRendering(renderingConfig);
             cmdList->setViewport(vireo::Viewport{static_cast<float>(extent.width), static_cast<float>(extent.height)});
@@ -236,23 +194,21 @@ namespace samples {
             cmdList->bindDescriptors({frame.smaaBlendDescriptorSet, samplers.getDescriptorSet()});
             cmdList->draw(3);
             cmdList->endRendering();
-            cmdList->barrier(frame.smaaBlendBuffer, vireo::ResourceState::SHADER_READ, vireo::ResourceState::RENDER_TARGET_COLOR);
-
-            cmdList->barrier(colorInput, vireo::ResourceState::SHADER_READ, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.transition(frame.smaaBlendBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.transition(colorInput, vireo::ResourceState::RENDER_TARGET_COLOR);
         }
 
         if (applyFXAA) {
             const auto colorInput =
-                applySMAA ? frame.smaaColorBuffer->getImage() :
-                applyGammaCorrection ? frame.gammaCorrectionColorBuffer->getImage() :
-                applyEffect ? frame.effectColorBuffer->getImage() :
-                applyTAA ? frame.taaColorBuffer[taaIndex]->getImage() :
-                colorBuffer->getImage();
-            cmdList->barrier(
-               colorInput,
-               vireo::ResourceState::RENDER_TARGET_COLOR,
-               vireo::ResourceState::SHADER_READ);
-            frame.fxaaDescriptorSet->update(BINDING_INPUT, colorInput );
+                applySMAA ? frame.smaaColorBuffer :
+                applyGammaCorrection ? frame.gammaCorrectionColorBuffer :
+                applyEffect ? frame.effectColorBuffer :
+                applyTAA ? frame.taaColorBuffer[taaIndex] :
+                colorBuffer;
+            stateTracker.transition(colorInput, vireo::ResourceState::SHADER_READ);
+            stateTracker.transition(frame.fxaaColorBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
+            stateTracker.flush(cmdList);
+            descriptorCache.update(frame.fxaaDescriptorSet, BINDING_INPUT, colorInput->getImage());
             renderingConfig.colorRenderTargets[0].renderTarget = frame.fxaaColorBuffer;
             cmdList->beginRendering(renderingConfig);
             cmdList->setViewport(vireo::Viewport{
@@ -265,16 +221,14 @@ namespace samples {
             cmdList->bindDescriptors({frame.fxaaDescriptorSet, samplers.getDescriptorSet()});
             cmdList->draw(3);
             cmdList->endRendering();
-            cmdList->barrier(
-                colorInput,
-                vireo::ResourceState::SHADER_READ,
-                vireo::ResourceState::RENDER_TARGET_COLOR);
-            shaderReadTargets.push_back(colorInput);
+            stateTracker.transition(colorInput, vireo::ResourceState::RENDER_TARGET_COLOR);
         }
         if (applyTAA) {
             taaIndex = (taaIndex + 1) % 2;
         }
-        frame.colorBuffersInitialized = true;
+        // Also moves the targets created by onResize() out of UNDEFINED, in one barrier
+        stateTracker.transitionAll(vireo::ResourceState::RENDER_TARGET_COLOR);
+        stateTracker.flush(cmdList);
     }
 
      std::shared_ptr<vireo::QueryPool>  PostProcessing::taaPass(
@@ -285,33 +239,20 @@ namespace samples {
         const std::shared_ptr<vireo::RenderTarget>& colorBuffer,
         const std::shared_ptr<vireo::RenderTarget>& velocityBuffer) {
         const auto& frame = framesData[frameIndex];
-        if (!frame.colorBuffersInitialized) {
-            for (const auto& buffer : frame.taaColorBuffer) {
-                cmdList->barrier(
-                    buffer,
-                    vireo::ResourceState::UNDEFINED,
-                    vireo::ResourceState::RENDER_TARGET_COLOR);
-            }
-        }
-
         if (!applyTAA) return nullptr;
 
         const auto historyIndex = (taaIndex + 1) % 2;
         const auto currentHistory = frame.taaColorBuffer[taaIndex];
         const auto previousHistory = frame.taaColorBuffer[historyIndex];
 
-        cmdList->barrier(
-           colorBuffer,
-           vireo::ResourceState::RENDER_TARGET_COLOR,
-           vireo::ResourceState::SHADER_READ);
-        cmdList->barrier(
-            previousHistory,
-            vireo::ResourceState::RENDER_TARGET_COLOR,
-            vireo::ResourceState::SHADER_READ);
-
-        frame.taaDescriptorSet[taaIndex]->update(BINDING_INPUT, colorBuffer->getImage());
-        frame.taaDescriptorSet[taaIndex]->update(BINDING_HISTORY, previousHistory->getImage());
-        frame.taaDescriptorSet[taaIndex]->update(BINDING_VELOCITY, velocityBuffer->getImage());
+        stateTracker.track(colorBuffer, vireo::ResourceState::RENDER_TARGET_COLOR);
+        stateTracker.transition(colorBuffer, vireo::ResourceState::SHADER_READ);
+        stateTracker.transition(previousHistory, vireo::ResourceState::SHADER_READ);
+        stateTracker.transition(currentHistory, vireo::ResourceState::RENDER_TARGET_COLOR);
+        stateTracker.flush(cmdList);
+
+        descriptorCache.update(frame.taaDescriptorSet[taaIndex], BINDING_INPUT, colorBuffer->getImage());
+        descriptorCache.update(frame.taaDescriptorSet[taaIndex], BINDING_VELOCITY, velocityBuffer->getImage());
         renderingConfig.colorRenderTargets[0].renderTarget = currentHistory;
 
         auto pool = vireo->createQueryPool(2, "TAA timing");
@@ -329,14 +270,8 @@ namespace samples {
         cmdList->draw(3);
         cmdList->endRendering();
 
-        cmdList->barrier(
-            previousHistory,
-            vireo::ResourceState::SHADER_READ,
-            vireo::ResourceState::RENDER_TARGET_COLOR);
-        cmdList->barrier(
-            colorBuffer,
-            vireo::ResourceState::SHADER_READ,
-            vireo::ResourceState::RENDER_TARGET_COLOR);
+        stateTracker.transitionAll(vireo::ResourceState::RENDER_TARGET_COLOR);
+        stateTracker.flush(cmdList);
 
         cmdList->writeTimestamp(*pool, 1);
         cmdList->resolveQueryPool(*pool, 0, 2);
@@ -396,6 +331,17 @@ namespace samples {
                 vireo::RenderTargetType::COLOR, {},
                 1, vireo::MSAA::NONE,
                 "Gamma Correction Color Buffer");
+            // Internal targets, bound once per size
+            frame.smaaBlendWeightDescriptorSet->update(SMAA_BINDING_INPUT, frame.smaaEdgeBuffer->getImage());
+            frame.smaaBlendDescriptorSet->update(SMAA_BLEND_BINDING_BLEND, frame.smaaBlendBuffer->getImage());
+            frame.taaDescriptorSet[0]->update(BINDING_HISTORY, frame.taaColorBuffer[1]->getImage());
+            frame.taaDescriptorSet[1]->update(BINDING_HISTORY, frame.taaColorBuffer[0]->getImage());
+            for (const auto& target : {
+                frame.fxaaColorBuffer, frame.smaaColorBuffer, frame.smaaEdgeBuffer, frame.smaaBlendBuffer,
+                frame.taaColorBuffer[0], frame.taaColorBuffer[1],
+                frame.effectColorBuffer, frame.gammaCorrectionColorBuffer}) {
+                stateTracker.track(target, vireo::ResourceState::UNDEFINED);
+            }
         }
     }
 
@@ -10,8 +10,11 @@ export module samples.common.postprocessing;
 import glm;
 import std;
 import vireo;
+import samples.common.descriptorcache;
 import samples.common.global;
+import samples.common.pipelinecache;
 import samples.common.samplers;
+import samples.common.statetracker;
 
 export namespace samples {
 
@@ -21,6 +24,7 @@ export namespace samples {
 
         void onInit(
             const std::shared_ptr<vireo::Vireo>& vireo,
+            PipelineCache& pipelineCache,
             vireo::ImageFormat renderFormat,
             const Samplers& samplers,
             std::uint32_t framesInFlight);
@@ -95,7 +99,6 @@ export namespace samples {
             std::shared_ptr<vireo::RenderTarget>  smaaBlendBuffer;
             std::shared_ptr<vireo::DescriptorSet> taaDescriptorSet[2];
             std::shared_ptr<vireo::RenderTarget>  taaColorBuffer[2];
-            bool colorBuffersInitialized{false};
         };
 
         vireo::GraphicPipelineConfiguration pipelineConfig {
@@ -129,6 +132,10 @@ export namespace samples {
         std::shared_ptr<vireo::DescriptorLayout>  smaaBlendDescLayout;
         std::shared_ptr<vireo::PipelineResources> smaaResources;
         std::shared_ptr<vireo::PipelineResources> smaaBlendResources;
+        // The inputs depend on the enabled effects and rarely change between frames
+        DescriptorCache                           descriptorCache;
+        // All the targets are left in RENDER_TARGET_COLOR between the calls
+        StateTracker                              stateTracker;
 
         std::uint32_t taaIndex{0};
 
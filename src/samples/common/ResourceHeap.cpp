@@ -0,0 +1,41 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.resourceheap;
+
+namespace samples {
+
+    void ResourceHeap::onInit(
+        const std::shared_ptr<vireo::Vireo>& vireo,
+        const std::shared_ptr<vireo::Buffer>& materialsBuffer,
+        const std::vector<std::shared_ptr<vireo::Image>>& textures,
+        const std::uint32_t framesInFlight) {
+        descriptorLayout = vireo->createDescriptorLayout("Resource heap");
+        descriptorLayout->add(BINDING_MATERIALS, vireo::DescriptorType::STORAGE);
+        // The shaders declare an unsized array, the size only comes from the scene
+        descriptorLayout->add(BINDING_TEXTURES, vireo::DescriptorType::SAMPLED_IMAGE, textures.size());
+        descriptorLayout->build();
+
+        framesData.resize(framesInFlight);
+        for (auto& frame : framesData) {
+            frame.descriptorSet = vireo->createDescriptorSet(descriptorLayout, "Resource heap");
+            frame.descriptorSet->update(BINDING_MATERIALS, materialsBuffer);
+            frame.descriptorSet->update(BINDING_TEXTURES, textures);
+        }
+    }
+
+    void ResourceHeap::onRender(
+        const std::uint32_t frameIndex,
+        const std::vector<std::shared_ptr<vireo::Image>>& textures,
+        const std::uint32_t texturesVersion) {
+        auto& frame = framesData[frameIndex];
+        if (frame.texturesVersion != texturesVersion) {
+            frame.descriptorSet->update(BINDING_TEXTURES, textures);
+            frame.texturesVersion = texturesVersion;
+        }
+    }
+
+}
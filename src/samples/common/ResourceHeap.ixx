@@ -0,0 +1,47 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.resourceheap;
+
+import std;
+import vireo;
+
+export namespace samples {
+
+    // Scene resources shared by all the passes : the materials and the textures, indexed by the shaders
+    // with the material index of each draw. One descriptor set per frame, refreshed once per frame
+    // when the resources changed, and bound by the passes after their own sets.
+    class ResourceHeap {
+    public:
+        static constexpr vireo::DescriptorIndex BINDING_MATERIALS{0};
+        static constexpr vireo::DescriptorIndex BINDING_TEXTURES{1};
+
+        void onInit(
+            const std::shared_ptr<vireo::Vireo>& vireo,
+            const std::shared_ptr<vireo::Buffer>& materialsBuffer,
+            const std::vector<std::shared_ptr<vireo::Image>>& textures,
+            std::uint32_t framesInFlight);
+
+        // Updates the textures of the frame set if they changed since its last use
+        void onRender(
+            std::uint32_t frameIndex,
+            const std::vector<std::shared_ptr<vireo::Image>>& textures,
+            std::uint32_t texturesVersion);
+
+        const auto& getDescriptorLayout() const { return descriptorLayout; }
+        const auto& getDescriptorSet(const std::uint32_t frameIndex) const { return framesData[frameIndex].descriptorSet; }
+
+    private:
+        struct FrameData {
+            std::shared_ptr<vireo::DescriptorSet> descriptorSet;
+            std::uint32_t                         texturesVersion{0};
+        };
+
+        std::vector<FrameData>                   framesData;
+        std::shared_ptr<vireo::DescriptorLayout> descriptorLayout;
+    };
+
+}
@@ -5,49 +5,74 @@
 * https://opensource.org/licenses/MIT
 */
 module;
-#include <stb_image.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 module samples.common.scene;
 
 namespace samples {
 
-    void Scene::drawCube(const std::shared_ptr<vireo::CommandList>& cmdList) const {
-        cmdList->bindVertexBuffer(vertexBuffer);
-        cmdList->bindIndexBuffer(indexBuffer);
-        cmdList->drawIndexed(cubeIndices.size());
+    void Scene::drawCube(CommandState& commandState) const {
+        commandState.bindIndexBuffer(geometry.getIndexBuffer());
+        commandState.getCommandList()->drawIndexed(cubeRange.indexCount, 1, cubeRange.firstIndex);
+    }
+
+    void Scene::drawCubes(CommandState& commandState, const DrawRange& range) const {
+        if (range.count == 0) { return; }
+        commandState.bindIndexBuffer(geometry.getIndexBuffer());
+        commandState.getCommandList()->drawIndexed(cubeRange.indexCount, range.count, cubeRange.firstIndex);
+    }
+
+    void Scene::drawInstancesIndirect(
+        CommandState& commandState,
+        const std::shared_ptr<vireo::Buffer>& commandBuffer,
+        const std::size_t offset) const {
+        commandState.bindIndexBuffer(geometry.getIndexBuffer());
+        commandState.getCommandList()->drawIndexedIndirect(commandBuffer, offset, 1, sizeof(vireo::DrawIndexedIndirectCommand));
     }
 
     void Scene::onInit(
         const std::shared_ptr<vireo::Vireo>& vireo,
-        const std::shared_ptr<vireo::CommandList>& uploadCommandList,
-        std::vector<std::shared_ptr<vireo::Buffer>>& stagingBuffers,
-        const vireo::Extent& extent) {
+        WorkerPool& workerPool,
+        UploadQueue& uploadQueue,
+        const std::shared_ptr<vireo::SubmitQueue>& graphicQueue,
+        const vireo::Extent& extent,
+        const std::uint32_t framesInFlight) {
         this->vireo = vireo;
+        this->workerPool = &workerPool;
+        assetLoader.onInit(vireo, workerPool, graphicQueue, framesInFlight);
+        textureStreamer.onInit(vireo, graphicQueue, assetLoader, framesInFlight);
 
-        vertexBuffer = vireo->createBuffer(vireo::BufferType::VERTEX,sizeof(Vertex),cubeVertices.size());
-        indexBuffer = vireo->createBuffer(vireo::BufferType::INDEX,sizeof(uint32_t),cubeIndices.size());
-        uploadCommandList->upload(vertexBuffer, &cubeVertices[0]);
-        uploadCommandList->upload(indexBuffer, &cubeIndices[0]);
+        geometry.onInit(vireo);
+        cubeMesh = MeshImporter::load("cube.obj");
+        if (usePackedVertices) {
+            cubePackedVertices = packVertices(cubeMesh.vertices, vertexQuantization, cubeMesh.bitangentSigns);
+            cubeRange = geometry.add(cubePackedVertices, cubeMesh.indices);
+        } else {
+            cubeRange = geometry.add(cubeMesh.vertices, cubeMesh.indices);
+        }
+        for (const auto& vertex : cubeMesh.vertices) {
+            cubePositions.push_back(vertex.position);
+        }
 
         models.resize(2);
         materials.resize(2);
 
-        materials[MATERIAL_ROCKS].diffuseTextureIndex = textures.size();
-        textures.push_back(uploadTexture(uploadCommandList, stagingBuffers, vireo::ImageFormat::R8G8B8A8_SRGB,
-            "gray_rocks_diff_1k.jpg"));
-        materials[MATERIAL_ROCKS].normalTextureIndex = textures.size();
-        textures.push_back(uploadTexture(uploadCommandList, stagingBuffers, vireo::ImageFormat::R8G8B8A8_UNORM,
-            "gray_rocks_nor_gl_1k.jpg"));
-        materials[MATERIAL_ROCKS].aoTextureIndex = textures.size();
-        textures.push_back(uploadTexture(uploadCommandList, stagingBuffers, vireo::ImageFormat::R8_UNORM,
-            "gray_rocks_ao_1k.jpg"));
-
-        materials[MATERIAL_GRID].diffuseTextureIndex = textures.size();
-        textures.push_back(uploadTexture(uploadCommandList, stagingBuffers, vireo::ImageFormat::R8G8B8A8_SRGB,
-            "Net004A_1K-JPG_Color.png"));
-        materials[MATERIAL_GRID].normalTextureIndex = textures.size();
-        textures.push_back(uploadTexture(uploadCommandList, stagingBuffers, vireo::ImageFormat::R8G8B8A8_UNORM,
-            "Net004A_1K-JPG_NormalGL.jpg"));
+        materials[MATERIAL_ROCKS].diffuseTextureIndex = textureStreamer.add(
+            uploadQueue, vireo::ImageFormat::R8G8B8A8_SRGB, "gray_rocks_diff_1k.jpg");
+        materials[MATERIAL_ROCKS].normalTextureIndex = textureStreamer.add(
+            uploadQueue, vireo::ImageFormat::R8G8B8A8_UNORM, "gray_rocks_nor_gl_1k.jpg");
+        materials[MATERIAL_ROCKS].aoTextureIndex = textureStreamer.add(
+            uploadQueue, vireo::ImageFormat::R8_UNORM, "gray_rocks_ao_1k.jpg");
+
+        materials[MATERIAL_GRID].diffuseTextureIndex = textureStreamer.add(
+            uploadQueue, vireo::ImageFormat::R8G8B8A8_SRGB, "Net004A_1K-JPG_Color.png");
+        materials[MATERIAL_GRID].normalTextureIndex = textureStreamer.add(
+            uploadQueue, vireo::ImageFormat::R8G8B8A8_UNORM, "Net004A_1K-JPG_NormalGL.jpg");
+
+        materialsBuffer = vireo->createBuffer(vireo::BufferType::STORAGE, sizeof(Material), materials.size(), "Materials");
+        uploadQueue.getCommandList()->upload(materialsBuffer, materials.data());
+        resourceHeap.onInit(vireo, materialsBuffer, textureStreamer.getImages(), framesInFlight);
+        textureCount = textureStreamer.getImages().size();
 
         global.view = glm::lookAt(global.cameraPosition, cameraTarget, AXIS_UP);
         global.viewInverse = glm::inverse(global.view);
@@ -60,31 +85,331 @@ namespace samples {
         jitterProjection(extent);
 
         static constexpr float angle = glm::radians(-45.0f);
-        models[MODEL_OPAQUE].transform = glm::rotate(models[MODEL_OPAQUE].transform, angle, AXIS_X);
-        models[MODEL_OPAQUE].transform = glm::rotate(models[MODEL_OPAQUE].transform, angle, AXIS_Y);
-        models[MODEL_TRANSPARENT].transform =
-                glm::rotate(glm::mat4{1.0f}, cubeYRotationAngle, AXIS_Y) *
-                glm::translate(glm::mat4{1.0f}, radius_transparent) *
-                glm::scale(glm::mat4{1.0f}, scale_transparent) *
-                glm::rotate(models[MODEL_OPAQUE].transform, -angle, AXIS_X) *
-                glm::rotate(models[MODEL_OPAQUE].transform, -angle, AXIS_X);
+        const auto toVec4 = [](const glm::quat& q) { return glm::vec4{q.x, q.y, q.z, q.w}; };
+        instances.add(
+            glm::vec3{0.0f},
+            toVec4(glm::angleAxis(angle, AXIS_X) * glm::angleAxis(angle, AXIS_Y)),
+            glm::vec3{1.0f},
+            glm::vec3{angle_opaque, angle_opaque, 0.0f});
+        instances.add(
+            glm::vec3{0.0f},
+            toVec4(glm::angleAxis(glm::radians(-60.0f), AXIS_Y)),
+            glm::vec3{1.0f},
+            glm::vec3{0.0f, angle_transparent, 0.0f});
+        instances.add(
+            radius_transparent,
+            glm::vec4{0.0f, 0.0f, 0.0f, 1.0f},
+            scale_transparent,
+            glm::vec3{angle_opaque, angle_opaque, 0.0f},
+            INSTANCE_PIVOT);
+        lastUpdateTime = std::chrono::steady_clock::now();
+        lastStatsTime = lastUpdateTime;
+        updateInstances();
+        cullInstances();
+        publishSnapshot(extent);
+        snapshots.acquire();
+
+        globalBuffers.resize(framesInFlight);
+        lightBuffers.resize(framesInFlight);
+        for (auto i = 0u; i < framesInFlight; i++) {
+            globalBuffers[i] = vireo->createBuffer(vireo::BufferType::UNIFORM, sizeof(Global), 1, "Global");
+            globalBuffers[i]->map();
+            lightBuffers[i] = vireo->createBuffer(vireo::BufferType::UNIFORM, sizeof(Light), 1, "Light");
+            lightBuffers[i]->map();
+            lightBuffers[i]->write(&light);
+            lightBuffers[i]->unmap();
+        }
+        modelsBuffers.resize(framesInFlight);
+        instanceIndicesBuffers.resize(framesInFlight);
+        drawsBuffers.resize(framesInFlight);
+        modelsBuffersCapacity.resize(framesInFlight);
     }
 
     void Scene::onUpdate(const vireo::Extent& extent) {
         global.screenSize = { static_cast<float>(extent.width), static_cast<float>(extent.height) };
         jitterProjection(extent);
-        if (rotateCube) {
-            models[MODEL_OPAQUE].transform = glm::rotate(models[MODEL_OPAQUE].transform, angle_opaque, AXIS_X);
-            models[MODEL_OPAQUE].transform = glm::rotate(models[MODEL_OPAQUE].transform, angle_opaque, AXIS_Y);
+        updateInstances();
+        cullInstances();
+        publishSnapshot(extent);
+    }
+
+    void Scene::publishSnapshot(const vireo::Extent& extent) {
+        auto& snapshot = snapshots.getBack();
+        snapshot.global = global;
+        snapshot.models = models;
+        snapshot.totalInstanceCount = static_cast<std::uint32_t>(instances.size());
+        snapshot.softwareOcclusionEnabled = softwareOcclusionEnabled;
 
-            cubeYRotationAngle += angle_transparent;
-            models[MODEL_TRANSPARENT].transform =
-                glm::rotate(glm::mat4{1.0f}, cubeYRotationAngle, AXIS_Y) *
-                glm::translate(glm::mat4{1.0f}, radius_transparent) *
-                glm::scale(glm::mat4{1.0f}, scale_transparent) *
-                glm::rotate(models[MODEL_OPAQUE].transform, -angle_opaque, AXIS_X) *
-                glm::rotate(models[MODEL_OPAQUE].transform, -angle_opaque, AXIS_X);
+        static constexpr std::pair<int, int> modelMaterials[] {
+            {MODEL_OPAQUE, MATERIAL_ROCKS},
+            {MODEL_TRANSPARENT, MATERIAL_GRID},
+        };
+        snapshot.textureScreenSizes.assign(textureCount, 0.0f);
+        for (const auto& [modelIndex, materialIndex] : modelMaterials) {
+            const auto screenSize = getScreenSize(models[modelIndex], extent);
+            const auto& material = materials[materialIndex];
+            for (const auto textureIndex : {
+                material.diffuseTextureIndex, material.normalTextureIndex, material.aoTextureIndex}) {
+                if (textureIndex != -1) {
+                    snapshot.textureScreenSizes[textureIndex] = std::max(snapshot.textureScreenSizes[textureIndex], screenSize);
+                }
+            }
         }
+        snapshots.publish();
+    }
+
+    void Scene::onRender(const std::uint32_t frameIndex) {
+        const auto fresh = snapshots.acquire();
+        const auto& snapshot = snapshots.getFront();
+        if (fresh && snapshot.printStats) {
+            std::cout << "Transforms update : " << snapshot.updateMilliseconds << " ms for "
+                      << snapshot.totalInstanceCount << " instances ("
+                      << workerPool->getThreadCount() << " threads), culling : "
+                      << snapshot.cullMilliseconds << " ms for " << snapshot.visibleInstanceCount << " visible, descriptor writes : "
+                      << DescriptorCache::getFrameStats().writes << " ("
+                      << DescriptorCache::getFrameStats().skipped << " skipped), binds : "
+                      << CommandState::getFrameStats().binds << " ("
+                      << CommandState::getFrameStats().skipped << " skipped), command lists : "
+                      << CachedCommandList::getFrameStats().recorded << " recorded ("
+                      << CachedCommandList::getFrameStats().replayed << " replayed)" << std::endl;
+        }
+        assetLoader.onUpdate();
+        // The streaming requests are reset by each update of the streamer
+        for (auto i = 0u; i < snapshot.textureScreenSizes.size(); i++) {
+            textureStreamer.requestScreenSize(i, snapshot.textureScreenSizes[i]);
+        }
+        textureStreamer.onUpdate();
+
+        globalBuffers[frameIndex]->write(&snapshot.global);
+        const auto instanceCount = getInstanceCount();
+        const auto count = snapshot.models.size() + instanceCount;
+        auto& buffer = modelsBuffers[frameIndex];
+        // The previous buffer of this frame is no longer used by the GPU
+        if (modelsBuffersCapacity[frameIndex] < count) {
+            buffer = vireo->createBuffer(vireo::BufferType::STORAGE, sizeof(Model), count, "Models");
+            buffer->map();
+            instanceIndicesBuffers[frameIndex] = vireo->createBuffer(
+                vireo::BufferType::STORAGE, sizeof(std::uint32_t), count, "Instance indices");
+            instanceIndicesBuffers[frameIndex]->map();
+            drawsBuffers[frameIndex] = vireo->createBuffer(
+                vireo::BufferType::STORAGE, sizeof(DrawInstance), count, "Draws");
+            drawsBuffers[frameIndex]->map();
+            modelsBuffersCapacity[frameIndex] = count;
+        }
+        buffer->write(snapshot.models.data(), snapshot.models.size() * sizeof(Model));
+        if (!snapshot.draws.empty()) {
+            drawsBuffers[frameIndex]->write(snapshot.draws.data(), snapshot.draws.size() * sizeof(DrawInstance));
+        }
+        if (instanceCount > 0) {
+            buffer->write(
+                snapshot.visibleTransforms.data(),
+                instanceCount * sizeof(Model),
+                snapshot.models.size() * sizeof(Model));
+            instanceIndicesBuffers[frameIndex]->write(snapshot.visibleIndices.data(), instanceCount * sizeof(std::uint32_t));
+        }
+        resourceHeap.onRender(frameIndex, textureStreamer.getImages(), textureStreamer.getVersion());
+    }
+
+    void Scene::onDestroy() {
+        assetLoader.onDestroy();
+        textureStreamer.onDestroy();
+    }
+
+    void Scene::toggleStressMode() {
+        stressMode = !stressMode;
+        if (stressMode) {
+            addStressInstances();
+        } else {
+            instances.truncate(SCENE_INSTANCES);
+        }
+        updateTime = std::chrono::nanoseconds{0};
+        cullTime = std::chrono::nanoseconds{0};
+        updateCount = 0;
+    }
+
+    void Scene::addStressInstances() {
+        // Four instances per cluster
+        instances.addClusters(STRESS_INSTANCE_COUNT / 4, cubeMesh.boundsCenter, cubeMesh.boundsExtent);
+    }
+
+    void Scene::updateInstances() {
+        const auto now = std::chrono::steady_clock::now();
+        const auto deltaTime = rotateCube ?
+            std::min(std::chrono::duration<float>(now - lastUpdateTime).count(), 0.1f) :
+            0.0f;
+        lastUpdateTime = now;
+
+        instances.update(deltaTime, *workerPool);
+        const auto& worldMatrices = instances.getWorldMatrices();
+        for (const auto& [modelIndex, instanceIndex] : modelInstances) {
+            models[modelIndex].transform = worldMatrices[instanceIndex];
+        }
+
+        // Only the paths to the moved instances are refitted
+        if (bvh.size() != instances.size()) {
+            bvh.build(instances.getWorldBoundsMin(), instances.getWorldBoundsMax());
+        } else if (!instances.getChangedInstances().empty()) {
+            bvh.refit(
+                instances.getWorldBoundsMin(),
+                instances.getWorldBoundsMax(),
+                instances.getChangedInstances());
+        }
+
+        // The rendering counters are only read by the render thread, the timings are printed by onRender()
+        auto& snapshot = snapshots.getBack();
+        snapshot.printStats = false;
+        if (stressMode) {
+            updateTime += std::chrono::steady_clock::now() - now;
+            updateCount += 1;
+            if (now - lastStatsTime >= std::chrono::seconds(1)) {
+                snapshot.printStats = true;
+                snapshot.updateMilliseconds = std::chrono::duration<double, std::milli>(updateTime).count() / updateCount;
+                snapshot.cullMilliseconds = std::chrono::duration<double, std::milli>(cullTime).count() / updateCount;
+                snapshot.visibleInstanceCount = static_cast<std::uint32_t>(visibleInstances.size());
+                updateTime = std::chrono::nanoseconds{0};
+                cullTime = std::chrono::nanoseconds{0};
+                updateCount = 0;
+                lastStatsTime = now;
+            }
+        }
+    }
+
+    void Scene::cullInstances() {
+        const auto start = std::chrono::steady_clock::now();
+        const auto viewProjection = global.projection * global.view;
+        bvh.cull(viewProjection, visibleInstances);
+        if (stressMode && softwareOcclusionEnabled) {
+            cullOccludedInstances(viewProjection);
+        }
+
+        auto& snapshot = snapshots.getBack();
+        auto& modelsVisibility = snapshot.modelsVisibility;
+        auto& visibleTransforms = snapshot.visibleTransforms;
+        auto& visibleIndices = snapshot.visibleIndices;
+        auto& draws = snapshot.draws;
+        auto& drawBuckets = snapshot.drawBuckets;
+        modelsVisibility.assign(models.size(), false);
+        const auto& worldMatrices = instances.getWorldMatrices();
+        // The pipeline of a draw is the permutation of its material, all the models are cubes
+        const auto addDraw = [&](const std::uint32_t bucket, const std::uint32_t instanceIndex, const std::uint32_t index) {
+            const auto material = bucketMaterials[bucket];
+            const auto viewPosition = global.view * worldMatrices[instanceIndex][3];
+            drawList.add(
+                DrawList::makeKey(
+                    bucket,
+                    getMaterialFeatures(materials[material]),
+                    material,
+                    0,
+                    -viewPosition.z,
+                    bucket == BUCKET_TRANSPARENT),
+                index);
+        };
+        drawList.clear();
+        for (const auto index : visibleInstances) {
+            if (index >= SCENE_INSTANCES) {
+                addDraw(BUCKET_INSTANCES, index, index);
+            } else {
+                for (const auto& [modelIndex, instanceIndex] : modelInstances) {
+                    if (instanceIndex == index) {
+                        modelsVisibility[modelIndex] = true;
+                        addDraw(modelIndex == MODEL_TRANSPARENT ? BUCKET_TRANSPARENT : BUCKET_OPAQUE, index, modelIndex);
+                    }
+                }
+            }
+        }
+        // Grouped by bucket and state, front to back except for the transparent models
+        drawList.sort(*workerPool);
+
+        // One instanced draw per bucket : the opaque model, the stress mode instances, the transparent model.
+        // The visible stress mode instances are uploaded in the order of their draws.
+        visibleTransforms.clear();
+        visibleIndices.clear();
+        draws.clear();
+        std::ranges::fill(drawBuckets, DrawRange{});
+        for (const auto& draw : drawList.getDraws()) {
+            const auto bucket = DrawList::getPass(draw.key);
+            if (drawBuckets[bucket].count == 0) {
+                drawBuckets[bucket].first = static_cast<std::uint32_t>(draws.size());
+            }
+            drawBuckets[bucket].count += 1;
+            if (bucket == BUCKET_INSTANCES) {
+                draws.push_back({static_cast<std::uint32_t>(models.size() + visibleTransforms.size()), bucketMaterials[bucket]});
+                visibleTransforms.push_back(worldMatrices[draw.index]);
+                visibleIndices.push_back(draw.index);
+            } else {
+                draws.push_back({draw.index, bucketMaterials[bucket]});
+            }
+        }
+        // The empty buckets start at the end of the previous one
+        auto bucketEnd = std::uint32_t{0};
+        for (auto& bucket : drawBuckets) {
+            if (bucket.count == 0) {
+                bucket.first = bucketEnd;
+            }
+            bucketEnd = bucket.first + bucket.count;
+        }
+
+        if (stressMode) {
+            cullTime += std::chrono::steady_clock::now() - start;
+        }
+    }
+
+    void Scene::cullOccludedInstances(const glm::mat4& viewProjection) {
+        const auto& worldMatrices = instances.getWorldMatrices();
+        softwareOcclusion.begin(viewProjection);
+        softwareOcclusion.addOccluder(cubePositions, cubeMesh.indices, worldMatrices[INSTANCE_OPAQUE]);
+        occluders.clear();
+        for (const auto index : visibleInstances) {
+            if (index >= SCENE_INSTANCES) {
+                occluders.push_back(index);
+            }
+        }
+        const auto occluderCount = std::min(OCCLUDER_COUNT, occluders.size());
+        const auto distance = [&](const std::uint32_t index) {
+            const auto offset = glm::vec3(worldMatrices[index][3]) - global.cameraPosition;
+            return glm::dot(offset, offset);
+        };
+        std::partial_sort(
+            occluders.begin(),
+            occluders.begin() + occluderCount,
+            occluders.end(),
+            [&](const auto a, const auto b) { return distance(a) < distance(b); });
+        for (auto i = std::size_t{0}; i < occluderCount; i++) {
+            softwareOcclusion.addOccluder(cubePositions, cubeMesh.indices, worldMatrices[occluders[i]]);
+        }
+        softwareOcclusion.rasterize(*workerPool);
+
+        const auto& boundsMin = instances.getWorldBoundsMin();
+        const auto& boundsMax = instances.getWorldBoundsMax();
+        occludedInstances.resize(visibleInstances.size());
+        workerPool->parallelFor(visibleInstances.size(), 1024, [&](const std::size_t begin, const std::size_t end) {
+            for (auto i = begin; i < end; i++) {
+                const auto index = visibleInstances[i];
+                occludedInstances[i] = index >= SCENE_INSTANCES && softwareOcclusion.isOccluded(boundsMin[index], boundsMax[index]);
+            }
+        });
+        auto visibleCount = std::size_t{0};
+        for (auto i = std::size_t{0}; i < visibleInstances.size(); i++) {
+            if (!occludedInstances[i]) {
+                visibleInstances[visibleCount++] = visibleInstances[i];
+            }
+        }
+        visibleInstances.resize(visibleCount);
+    }
+
+    float Scene::getScreenSize(const Model& model, const vireo::Extent& extent) const {
+        // Unit cube bounding sphere, scaled by the largest axis of the model
+        const auto scale = std::max({
+            glm::length(glm::vec3(model.transform[0])),
+            glm::length(glm::vec3(model.transform[1])),
+            glm::length(glm::vec3(model.transform[2]))});
+        const auto radius = 0.5f * std::sqrt(3.0f) * scale;
+        const auto center = global.view * model.transform[3];
+        const auto depth = -center.z;
+        if (depth <= radius) {
+            return static_cast<float>(std::max(extent.width, extent.height));
+        }
+        return radius / depth * global.projection[1][1] * static_cast<float>(extent.height);
     }
 
     void Scene::onKeyDown(const KeyScanCodes keyCode) {
@@ -96,6 +421,10 @@ namespace samples {
         case KeyScanCodes::SPACE:
             rotateCube = !rotateCube;
             return;
+        case KeyScanCodes::O:
+            softwareOcclusionEnabled = !softwareOcclusionEnabled;
+            std::cout << "Occlusion culling on the " << (softwareOcclusionEnabled ? "CPU" : "GPU") << std::endl;
+            return;
         case KeyScanCodes::W:
             global.cameraPosition.z -= 0.1f;
             global.view = lookAt(global.cameraPosition, cameraTarget, AXIS_Y);
@@ -139,82 +468,6 @@ namespace samples {
         global.view = lookAt(global.cameraPosition, cameraTarget, AXIS_Y);
     }
 
-    std::shared_ptr<vireo::Image> Scene::uploadTexture(
-        const std::shared_ptr<vireo::CommandList>& uploadCommandList,
-        std::vector<std::shared_ptr<vireo::Buffer>>& stagingBuffer,
-        const vireo::ImageFormat format,
-        const std::string& filename) const {
-        const auto pixelSize = vireo::Image::getPixelSize(format);
-
-        int width, height, channels;
-        stbi_uc* pixels = stbi_load(("res/" + filename).c_str(), &width, &height,&channels, pixelSize);
-        if (!pixels) {
-            throw std::runtime_error("Failed to load texture: " + filename);
-        }
-
-        auto buffer = vireo->createBuffer(vireo::BufferType::IMAGE_UPLOAD, width * pixelSize, height);
-        buffer->map();
-        buffer->write(pixels);
-        stbi_image_free(pixels);
-
-        const auto mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) - 1;
-        auto texture = vireo->createImage(
-            format,
-            width, height,
-            mipLevels, 1,
-            filename);
-        uploadCommandList->barrier(
-            texture,
-            vireo::ResourceState::UNDEFINED,
-            vireo::ResourceState::COPY_DST,
-            0, mipLevels);
-        uploadCommandList->copy(buffer, texture, 0, 0, false);
-        stagingBuffer.push_back(buffer);
-
-        // generating mip levels until reaching 4x4 resolution
-        auto currentWidth = width;
-        auto currentHeight = height;
-        auto previousData = static_cast<unsigned char*>(buffer->getMappedAddress());
-        auto mipLevel = 1;
-        while (currentWidth > 4 || currentHeight > 4) {
-            const auto w = (currentWidth > 1) ? currentWidth / 2 : 1;
-            const auto h = (currentHeight > 1) ? currentHeight / 2 : 1;
-            const auto dataSize = w * h * pixelSize;
-            const auto dataVector = std::make_shared<std::vector<uint8_t>>(static_cast<std::vector<uint8_t>::size_type>(dataSize));
-            const auto data = dataVector->data();
-            // Generate mip data by averaging 2x2 blocks from the previous level
-            for (auto y = 0; y < h; ++y) {
-                for (auto x = 0; x < w; ++x) {
-                    const auto srcX = x * 2;
-                    const auto srcY = y * 2;
-                    // Average 2x2 block
-                    for (int c = 0; c < pixelSize; ++c) {
-                        const auto sum = previousData[(srcY * currentWidth + srcX) * pixelSize + c] +
-                                       previousData[(srcY * currentWidth + (srcX + 1)) * pixelSize + c] +
-                                       previousData[((srcY + 1) * currentWidth + srcX) * pixelSize + c] +
-                                       previousData[((srcY + 1) * currentWidth + (srcX + 1)) * pixelSize + c];
-                        data[(y * w + x) * pixelSize + c] = static_cast<uint8_t>(sum / pixelSize);
-                    }
-                }
-            }
-            buffer = vireo->createBuffer(vireo::BufferType::IMAGE_UPLOAD, w * pixelSize, h);
-            buffer->map();
-            buffer->write(data);
-            uploadCommandList->copy(buffer, texture, 0, mipLevel, false);
-            stagingBuffer.push_back(buffer);
-            currentWidth = w;
-            currentHeight = h;
-            previousData = static_cast<unsigned char*>(buffer->getMappedAddress());
-            mipLevel += 1;
-        }
-        uploadCommandList->barrier(
-            texture,
-            vireo::ResourceState::COPY_DST,
-            vireo::ResourceState::SHADER_READ,
-            0, mipLevels);
-        return texture;
-    }
-
     void Scene::jitterProjection(const vireo::Extent& extent) {
         static uint32_t frameIndex = 0;
         // https://en.wikipedia.org/wiki/Halton_sequence
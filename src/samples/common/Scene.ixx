@@ -9,7 +9,23 @@ export module samples.common.scene;
 import glm;
 import std;
 import vireo;
+import samples.common.assetloader;
+import samples.common.bvh;
+import samples.common.cachedcommandlist;
+import samples.common.commandstate;
+import samples.common.descriptorcache;
+import samples.common.drawlist;
+import samples.common.geometryarena;
 import samples.common.global;
+import samples.common.instances;
+import samples.common.meshimporter;
+import samples.common.resourceheap;
+import samples.common.softwareocclusion;
+import samples.common.texturestreamer;
+import samples.common.triplebuffer;
+import samples.common.uploadqueue;
+import samples.common.vertexpacking;
+import samples.common.workerpool;
 
 export namespace samples {
 
@@ -19,101 +35,209 @@ export namespace samples {
         static constexpr auto MODEL_TRANSPARENT{1};
         static constexpr auto MATERIAL_ROCKS{0};
         static constexpr auto MATERIAL_GRID{1};
+        static constexpr auto STRESS_INSTANCE_COUNT{100000};
+
+        // Groups of draw instances sharing the mesh and the pipeline, consecutive in the draws buffer
+        static constexpr std::uint32_t BUCKET_OPAQUE{0};
+        static constexpr std::uint32_t BUCKET_INSTANCES{1}; // stress mode instances
+        static constexpr std::uint32_t BUCKET_TRANSPARENT{2};
+        static constexpr std::uint32_t BUCKET_COUNT{3};
+        // Material of the draws of each bucket
+        static constexpr int bucketMaterials[BUCKET_COUNT]{MATERIAL_ROCKS, MATERIAL_ROCKS, MATERIAL_GRID};
+
+        struct DrawRange {
+            std::uint32_t first{0};
+            std::uint32_t count{0};
+        };
+
+        // Use PackedVertex instead of Vertex in the geometry arena, must be set before onInit()
+        bool usePackedVertices{true};
 
+        // The worker pool is shared with the application and must outlive the scene
         void onInit(
             const std::shared_ptr<vireo::Vireo>& vireo,
-            const std::shared_ptr<vireo::CommandList>& uploadCommandList,
-            std::vector<std::shared_ptr<vireo::Buffer>>& stagingBuffers,
-            const vireo::Extent& extent);
-
+            WorkerPool& workerPool,
+            UploadQueue& uploadQueue,
+            const std::shared_ptr<vireo::SubmitQueue>& graphicQueue,
+            const vireo::Extent& extent,
+            std::uint32_t framesInFlight);
+
+        // Simulation : animates and culls the instances, then publishes a snapshot of the frame data.
+        // onUpdate(), onKeyDown() and toggleStressMode() may run on another thread than the rendering.
         void onUpdate(const vireo::Extent& extent);
 
+        // Acquires the last published snapshot, read by the getters of the frame data until the next call.
+        // Publishes the global uniform, uploads the models and the visible instances world matrices for the frame,
+        // resumes the loading tasks, streams the textures and refreshes the resource heap
+        void onRender(std::uint32_t frameIndex);
+
+        void onDestroy();
+
         void onKeyDown(KeyScanCodes keyCode);
 
-        void drawCube(const std::shared_ptr<vireo::CommandList>& cmdList) const;
+        // Adds or removes the stress mode instances
+        void toggleStressMode();
 
-        const auto& getGlobal() const { return global; }
-        const auto& getModels() const { return models; }
+        void drawCube(CommandState& commandState) const;
+
+        // Draws a range of the draws buffer with one instanced call
+        void drawCubes(CommandState& commandState, const DrawRange& range) const;
+
+        // Draws the stress mode instances with a command written by the GPU
+        void drawInstancesIndirect(
+            CommandState& commandState,
+            const std::shared_ptr<vireo::Buffer>& commandBuffer,
+            std::size_t offset) const;
+
+        const auto& getGlobal() const { return snapshots.getFront().global; }
+        const auto& getVertexQuantization() const { return vertexQuantization; }
+        const auto& getModels() const { return snapshots.getFront().models; }
         const auto& getMaterials() const { return materials; }
         const auto& getLight() const { return light; }
-        const auto& getTextures() const { return textures; }
-
+        // Uniform buffers shared by all the passes, Global is written once per frame and Light once at init
+        const auto& getGlobalBuffer(const std::uint32_t frameIndex) const { return globalBuffers[frameIndex]; }
+        const auto& getLightBuffer(const std::uint32_t frameIndex) const { return lightBuffers[frameIndex]; }
+        const auto& getTextures() const { return textureStreamer.getImages(); }
+        const auto& getCubeMesh() const { return cubeMesh; }
+        // Range of the cube in the geometry arena
+        const auto& getCubeRange() const { return cubeRange; }
+        // Vertices and indices of the meshes of the scene and of the passes, uploaded by the applications
+        auto& getGeometry() { return geometry; }
+        const auto& getGeometry() const { return geometry; }
+        // Materials and textures, bound by the passes once per frame
+        const auto& getResourceHeap() const { return resourceHeap; }
+        // Coroutines loading the textures of the scene and the assets of the passes, resumed by onRender()
+        auto& getAssetLoader() { return assetLoader; }
+
+        // Models followed by the visible stress mode instances
+        const auto& getModelsBuffer(const std::uint32_t frameIndex) const { return modelsBuffers[frameIndex]; }
+        auto getFirstInstance() const { return static_cast<std::uint32_t>(snapshots.getFront().models.size()); }
+        auto getInstanceCount() const { return static_cast<std::uint32_t>(snapshots.getFront().visibleTransforms.size()); }
+        // Index in the scene instances of each visible stress mode instance
+        const auto& getInstanceIndicesBuffer(const std::uint32_t frameIndex) const { return instanceIndicesBuffers[frameIndex]; }
+        auto getTotalInstanceCount() const { return snapshots.getFront().totalInstanceCount; }
+
+        // Model and material of each visible object, grouped by bucket
+        const auto& getDrawsBuffer(const std::uint32_t frameIndex) const { return drawsBuffers[frameIndex]; }
+        // Draws of consecutive buckets
+        DrawRange getDrawRange(const std::uint32_t firstBucket, const std::uint32_t lastBucket) const {
+            const auto& drawBuckets = snapshots.getFront().drawBuckets;
+            return { drawBuckets[firstBucket].first,
+                     drawBuckets[lastBucket].first + drawBuckets[lastBucket].count - drawBuckets[firstBucket].first };
+        }
+
+        // Material features of the draws of a bucket, the draws of a bucket share their material
+        auto getBucketFeatures(const std::uint32_t bucket) const {
+            return getMaterialFeatures(materials[bucketMaterials[bucket]]);
+        }
+
+        // Frustum culling result of a scene model
+        auto isVisible(const int modelIndex) const { return snapshots.getFront().modelsVisibility[modelIndex]; }
+
+        // The stress mode instances are occlusion culled on the CPU instead of the GPU, toggled with the `O` key
+        auto isSoftwareOcclusionEnabled() const { return snapshots.getFront().softwareOcclusionEnabled; }
+
+        void setTextureMemoryBudget(const std::size_t budget) { textureStreamer.setMemoryBudget(budget); }
 
     private:
-        static constexpr float angle_opaque = glm::radians(-0.1);
-        static constexpr float angle_transparent = glm::radians(-0.5);
+        static constexpr float angle_opaque = glm::radians(-6.0f); // per second
+        static constexpr float angle_transparent = glm::radians(-30.0f); // per second
         static constexpr auto scale_transparent = glm::vec3{0.25f, 0.25f, 0.25f};
         static constexpr auto radius_transparent = glm::vec3{1.25f, 0.0f, 0.0f};
 
+        // Instances of the scene models, stress mode instances are added after them
+        static constexpr std::uint32_t INSTANCE_OPAQUE{0};
+        static constexpr std::uint32_t INSTANCE_PIVOT{1};
+        static constexpr std::uint32_t INSTANCE_TRANSPARENT{2};
+        static constexpr std::uint32_t SCENE_INSTANCES{3};
+        static constexpr std::pair<int, std::uint32_t> modelInstances[] {
+            {MODEL_OPAQUE, INSTANCE_OPAQUE},
+            {MODEL_TRANSPARENT, INSTANCE_TRANSPARENT},
+        };
+        // Nearest visible stress mode instances rasterized as occluders, with the opaque cube
+        static constexpr std::size_t OCCLUDER_COUNT{64};
+
+        // Frame data written by the simulation and read by the rendering
+        struct Snapshot {
+            Global                     global{};
+            std::vector<Model>         models;
+            std::vector<bool>          modelsVisibility;
+            std::vector<glm::mat4>     visibleTransforms;
+            std::vector<std::uint32_t> visibleIndices;
+            std::vector<DrawInstance>  draws;
+            DrawRange                  drawBuckets[BUCKET_COUNT];
+            // Indexed by texture
+            std::vector<float>         textureScreenSizes;
+            std::uint32_t              totalInstanceCount{0};
+            bool                       softwareOcclusionEnabled{false};
+            // Simulation timings of the stress mode, printed with the rendering counters by onRender() when set
+            bool                       printStats{false};
+            double                     updateMilliseconds{0.0};
+            double                     cullMilliseconds{0.0};
+            std::uint32_t              visibleInstanceCount{0};
+        };
+
         Global     global{};
         Light      light{};
         bool       rotateCube{true};
-        float      cubeYRotationAngle{glm::radians(-60.0f)};
+        bool       stressMode{false};
+        bool       softwareOcclusionEnabled{false};
         float      cameraYRotationAngle{0.0f};
         glm::vec3  cameraTarget{0.0f, 0.0f, 0.0f};
 
         std::vector<Model>                         models;
         std::vector<Material>                      materials;
+        std::vector<std::shared_ptr<vireo::Buffer>> globalBuffers;
+        std::vector<std::shared_ptr<vireo::Buffer>> lightBuffers;
+        std::vector<std::shared_ptr<vireo::Buffer>> modelsBuffers;
+        std::vector<std::shared_ptr<vireo::Buffer>> instanceIndicesBuffers;
+        std::vector<std::shared_ptr<vireo::Buffer>> drawsBuffers;
+        std::vector<std::size_t>                   modelsBuffersCapacity;
+        InstanceStore                              instances;
+        WorkerPool*                                workerPool{nullptr};
+        BVH                                        bvh;
+        std::vector<std::uint32_t>                 visibleInstances;
+        DrawList                                   drawList;
+        TripleBuffer<Snapshot>                     snapshots;
+        SoftwareOcclusion                          softwareOcclusion;
+        std::vector<std::uint32_t>                 occluders;
+        std::vector<std::uint8_t>                  occludedInstances;
+        std::chrono::steady_clock::time_point      lastUpdateTime;
+        std::chrono::steady_clock::time_point      lastStatsTime;
+        std::chrono::nanoseconds                   updateTime{0};
+        std::chrono::nanoseconds                   cullTime{0};
+        std::uint32_t                              updateCount{0};
         std::shared_ptr<vireo::Vireo>              vireo;
-        std::shared_ptr<vireo::Buffer>             vertexBuffer;
-        std::shared_ptr<vireo::Buffer>             indexBuffer;
-        std::vector<std::shared_ptr<vireo::Image>> textures;
-
-        std::vector<Vertex> cubeVertices {
-            // (-Z)
-            {{-0.5f, -0.5f, -0.5f}, { 0,  0, -1}, {0, 0}, {1, 0, 0}},
-            {{ 0.5f, -0.5f, -0.5f}, { 0,  0, -1}, {1, 0}, {1, 0, 0}},
-            {{ 0.5f,  0.5f, -0.5f}, { 0,  0, -1}, {1, 1}, {1, 0, 0}},
-            {{-0.5f,  0.5f, -0.5f}, { 0,  0, -1}, {0, 1}, {1, 0, 0}},
-
-            // (+Z)
-            {{ 0.5f, -0.5f, 0.5f}, { 0,  0, 1}, {0, 0}, {-1, 0, 0}},
-            {{-0.5f, -0.5f, 0.5f}, { 0,  0, 1}, {1, 0}, {-1, 0, 0}},
-            {{-0.5f,  0.5f, 0.5f}, { 0,  0, 1}, {1, 1}, {-1, 0, 0}},
-            {{ 0.5f,  0.5f, 0.5f}, { 0,  0, 1}, {0, 1}, {-1, 0, 0}},
-
-            // (-X)
-            {{-0.5f, -0.5f,  0.5f}, {-1,  0,  0}, {0, 0}, {0, 0, -1}},
-            {{-0.5f, -0.5f, -0.5f}, {-1,  0,  0}, {1, 0}, {0, 0, -1}},
-            {{-0.5f,  0.5f, -0.5f}, {-1,  0,  0}, {1, 1}, {0, 0, -1}},
-            {{-0.5f,  0.5f,  0.5f}, {-1,  0,  0}, {0, 1}, {0, 0, -1}},
-
-            // (+X)
-            {{0.5f, -0.5f, -0.5f}, {1, 0, 0}, {0, 0}, {0, 0, 1}},
-            {{0.5f, -0.5f,  0.5f}, {1, 0, 0}, {1, 0}, {0, 0, 1}},
-            {{0.5f,  0.5f,  0.5f}, {1, 0, 0}, {1, 1}, {0, 0, 1}},
-            {{0.5f,  0.5f, -0.5f}, {1, 0, 0}, {0, 1}, {0, 0, 1}},
-
-            // (-Y)
-            {{-0.5f, -0.5f,  0.5f}, {0, -1, 0}, {0, 0}, {1, 0, 0}},
-            {{ 0.5f, -0.5f,  0.5f}, {0, -1, 0}, {1, 0}, {1, 0, 0}},
-            {{ 0.5f, -0.5f, -0.5f}, {0, -1, 0}, {1, 1}, {1, 0, 0}},
-            {{-0.5f, -0.5f, -0.5f}, {0, -1, 0}, {0, 1}, {1, 0, 0}},
-
-            // (+Y)
-            {{-0.5f, 0.5f, -0.5f}, {0, 1, 0}, {0, 0}, {1, 0, 0}},
-            {{ 0.5f, 0.5f, -0.5f}, {0, 1, 0}, {1, 0}, {1, 0, 0}},
-            {{ 0.5f, 0.5f,  0.5f}, {0, 1, 0}, {1, 1}, {1, 0, 0}},
-            {{-0.5f, 0.5f,  0.5f}, {0, 1, 0}, {0, 1}, {1, 0, 0}},
-        };
-
-        // CCW
-        std::vector<std::uint32_t> cubeIndices {
-            0,  2,  1,   0,  3,  2, // (-Z)
-            4,  6,  5,   4,  7,  6, // (+Z)
-            8, 10,  9,   8, 11, 10, // (-X)
-            12,14,13,   12,15,14,   // (+X)
-            16,18,17,   16,19,18,   // (-Y)
-            20,22,21,   20,23,22    // (+Y)
-        };
+        std::shared_ptr<vireo::Buffer>             materialsBuffer;
+        GeometryArena                              geometry;
+        Mesh                                       cubeMesh;
+        GeometryArena::MeshRange                   cubeRange;
+        std::vector<PackedVertex>                  cubePackedVertices;
+        std::vector<glm::vec3>                     cubePositions;
+        VertexQuantization                         vertexQuantization{};
+        AssetLoader                                assetLoader;
+        TextureStreamer                            textureStreamer;
+        std::size_t                                textureCount{0};
+        ResourceHeap                               resourceHeap;
 
         void jitterProjection(const vireo::Extent& extent); // For TAA
 
-        std::shared_ptr<vireo::Image> uploadTexture(
-            const std::shared_ptr<vireo::CommandList>& uploadCommandList,
-            std::vector<std::shared_ptr<vireo::Buffer>>& stagingBuffer,
-            vireo::ImageFormat format,
-            const std::string& filename) const;
+        void addStressInstances();
+
+        void updateInstances();
+
+        // Fills the models visibility, the visible instances list from the BVH and the draws sorted by state and depth
+        // of the next snapshot
+        void cullInstances();
+
+        // Completes the next snapshot with the simulation state and publishes it
+        void publishSnapshot(const vireo::Extent& extent);
+
+        // Removes the stress mode instances hidden by the occluders from the visible instances list
+        void cullOccludedInstances(const glm::mat4& viewProjection);
+
+        // Size in pixels of the projected bounding sphere of a model, used to stream the textures
+        float getScreenSize(const Model& model, const vireo::Extent& extent) const;
     };
 
 }
\ No newline at end of file
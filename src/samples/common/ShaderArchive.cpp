@@ -0,0 +1,102 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module;
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+module samples.common.shaderarchive;
+
+namespace samples {
+
+    ShaderArchive::~ShaderArchive() {
+        close();
+    }
+
+    bool ShaderArchive::open(const std::filesystem::path& path) {
+        close();
+#ifdef _WIN32
+        const auto file = CreateFileW(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) { return false; }
+        auto fileSize = LARGE_INTEGER{};
+        GetFileSizeEx(file, &fileSize);
+        const auto fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (fileMapping == nullptr) { return false; }
+        const auto view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            CloseHandle(fileMapping);
+            return false;
+        }
+        mapping = fileMapping;
+        data = static_cast<const std::byte*>(view);
+        size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+        const auto file = ::open(path.c_str(), O_RDONLY);
+        if (file == -1) { return false; }
+        struct stat status{};
+        if (fstat(file, &status) != 0 || status.st_size == 0) {
+            ::close(file);
+            return false;
+        }
+        const auto view = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        // The mapping keeps its own reference to the file
+        ::close(file);
+        if (view == MAP_FAILED) { return false; }
+        data = static_cast<const std::byte*>(view);
+        size = static_cast<std::size_t>(status.st_size);
+#endif
+        auto header = Header{};
+        if (size < sizeof(header)) {
+            close();
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        const auto namesOffset = sizeof(Header) + header.entryCount * sizeof(Entry);
+        if (header.magic != MAGIC || header.version != VERSION || namesOffset + header.namesSize > size) {
+            close();
+            return false;
+        }
+        entryCount = header.entryCount;
+        entries = reinterpret_cast<const Entry*>(data + sizeof(Header));
+        names = reinterpret_cast<const char*>(data + namesOffset);
+        return true;
+    }
+
+    void ShaderArchive::close() {
+        if (data == nullptr) { return; }
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+#else
+        munmap(const_cast<std::byte*>(data), size);
+#endif
+        data = nullptr;
+        mapping = nullptr;
+        size = 0;
+        entries = nullptr;
+        names = nullptr;
+        entryCount = 0;
+    }
+
+    std::span<const std::byte> ShaderArchive::get(const std::string_view name) const {
+        const auto end = entries + entryCount;
+        const auto it = std::lower_bound(entries, end, name, [this](const Entry& entry, const std::string_view value) {
+            return getName(entry) < value;
+        });
+        if (it == end || getName(*it) != name || it->offset + it->size > size) {
+            return {};
+        }
+        return {data + it->offset, static_cast<std::size_t>(it->size)};
+    }
+
+}
@@ -0,0 +1,65 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.shaderarchive;
+
+import std;
+
+export namespace samples {
+
+    // Read-only memory mapping of the shaders archive written by the shader_packer tool at build time.
+    // Layout : the header, the entries sorted by name, the names, then the binaries aligned on
+    // ALIGNMENT bytes. Identical binaries are stored once.
+    class ShaderArchive {
+    public:
+        static constexpr std::uint32_t MAGIC{0x4b505356}; // "VSPK"
+        static constexpr std::uint32_t VERSION{1};
+        static constexpr std::size_t   ALIGNMENT{64};
+
+        struct Header {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint32_t entryCount;
+            std::uint32_t namesSize;
+        };
+
+        struct Entry {
+            std::uint32_t nameOffset; // from the start of the names
+            std::uint32_t nameSize;
+            std::uint64_t offset;     // from the start of the archive
+            std::uint64_t size;
+        };
+
+        ShaderArchive() = default;
+        ShaderArchive(const ShaderArchive&) = delete;
+        ShaderArchive& operator=(const ShaderArchive&) = delete;
+        ~ShaderArchive();
+
+        // Maps the archive, returns false if it does not exist or is invalid
+        bool open(const std::filesystem::path& path);
+
+        void close();
+
+        auto isOpen() const { return data != nullptr; }
+
+        // View of a shader binary, by file name without the backend extension ("quad.vert").
+        // Empty if the shader is not in the archive.
+        std::span<const std::byte> get(std::string_view name) const;
+
+    private:
+        const std::byte* data{nullptr};
+        std::size_t      size{0};
+        const Entry*     entries{nullptr};
+        const char*      names{nullptr};
+        std::uint32_t    entryCount{0};
+        void*            mapping{nullptr}; // platform handle of the mapping, if any
+
+        std::string_view getName(const Entry& entry) const {
+            return {names + entry.nameOffset, entry.nameSize};
+        }
+    };
+
+}
@@ -21,19 +21,26 @@ namespace samples {
 
     void Skybox::onInit(
         const std::shared_ptr<vireo::Vireo>& vireo,
-        const std::shared_ptr<vireo::CommandList>& uploadCommandList,
+        PipelineCache& pipelineCache,
+        GeometryArena& geometry,
+        UploadQueue& uploadQueue,
+        AssetLoader& assetLoader,
         const vireo::ImageFormat renderFormat,
         const DepthPrepass& depthPrepass,
         const Samplers& samplers,
         const uint32_t framesInFlight) {
         this->vireo = vireo;
 
-        vertexBuffer = vireo->createBuffer(vireo::BufferType::VERTEX, sizeof(float) * 3,cubemapVertices.size() / 3);
-        uploadCommandList->upload(vertexBuffer, &cubemapVertices[0]);
+        // Positions only, the vertices are not shared between the faces
+        auto indices = std::vector<std::uint32_t>(cubemapVertices.size() / 3);
+        std::iota(indices.begin(), indices.end(), 0);
+        mesh = geometry.add(cubemapVertices.data(), sizeof(float) * 3, static_cast<std::uint32_t>(indices.size()), indices);
+        indexBuffer = geometry.getIndexBuffer();
 
         descriptorLayout = vireo->createDescriptorLayout();
         descriptorLayout->add(BINDING_GLOBAL, vireo::DescriptorType::UNIFORM);
         descriptorLayout->add(BINDING_CUBEMAP, vireo::DescriptorType::SAMPLED_IMAGE);
+        descriptorLayout->add(BINDING_VERTICES, vireo::DescriptorType::STORAGE);
         descriptorLayout->build();
 
         pipelineConfig.colorRenderFormats.push_back(renderFormat);
@@ -43,22 +50,32 @@ namespace samples {
         pipelineConfig.backStencilOpState = pipelineConfig.frontStencilOpState;
         pipelineConfig.resources = vireo->createPipelineResources(
             { descriptorLayout, samplers.getDescriptorLayout() });
-        pipelineConfig.vertexInputLayout = vireo->createVertexLayout(sizeof(float) * 3, vertexAttributes);
-        pipelineConfig.vertexShader = vireo->createShaderModule("shaders/skybox.vert");
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/skybox.frag");
-        pipeline = vireo->createGraphicPipeline(pipelineConfig);
+        pipelineCache.declareGraphicPipeline(pipeline, pipelineConfig, "shaders/skybox.vert", "shaders/skybox.frag");
 
-        cubeMap = loadCubemap(uploadCommandList, "res/StandardCubeMap.jpg", vireo::ImageFormat::R8G8B8A8_SRGB);
+        std::uint8_t placeholderColor[]{0, 64, 128, 255};
+        placeholder = vireo->createImage(vireo::ImageFormat::R8G8B8A8_SRGB, 1, 1, 1, 6, "Cubemap placeholder");
+        uploadQueue.getCommandList()->barrier(placeholder, vireo::ResourceState::UNDEFINED, vireo::ResourceState::COPY_DST);
+        uploadQueue.getCommandList()->uploadArray(placeholder, std::vector<void*>(6, placeholderColor));
+        uploadQueue.acquire(placeholder);
+        cubeMap = placeholder;
+        assetLoader.start(loadCubemap(assetLoader, "res/StandardCubeMap.jpg", vireo::ImageFormat::R8G8B8A8_SRGB));
 
         framesData.resize(framesInFlight);
         for (auto& frame : framesData) {
-            frame.commandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
-            frame.commandList = frame.commandAllocator->createCommandList();
+            frame.commandList.onInit(vireo);
             frame.globalBuffer = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Global));
             frame.globalBuffer->map();
             frame.descriptorSet = vireo->createDescriptorSet(descriptorLayout);
             frame.descriptorSet->update(BINDING_GLOBAL, frame.globalBuffer);
             frame.descriptorSet->update(BINDING_CUBEMAP, cubeMap);
+            frame.descriptorSet->update(BINDING_VERTICES, geometry.getVertexBuffer());
+        }
+    }
+
+    void Skybox::onResize() {
+        targetsGeneration += 1;
+        for (auto& frame : framesData) {
+            frame.commandList.invalidate();
         }
     }
 
@@ -77,54 +94,65 @@ namespace samples {
         renderingConfig.depthStencilRenderTarget = depthPrepass.getDepthBuffer(frameIndex);
 
         frame.globalBuffer->write(&global);
-
-        frame.commandAllocator->reset();
-        const auto cmdList = frame.commandList;
-        cmdList->begin();
-
-        if (depthIsReadOnly && depthPrepass.isWithStencil()) {
-            cmdList->barrier(
-                renderingConfig.depthStencilRenderTarget,
-                vireo::ResourceState::RENDER_TARGET_DEPTH_STENCIL_READ,
-                vireo::ResourceState::RENDER_TARGET_DEPTH_STENCIL);
-        }
-        if (!frame.bufferInitialized) {
-            cmdList->barrier(
-               colorBuffer,
-               vireo::ResourceState::UNDEFINED,
-               vireo::ResourceState::RENDER_TARGET_COLOR);
-            frame.bufferInitialized = true;
+        if (frame.cubeMapVersion != cubeMapVersion) {
+            // The previous commands of this frame are done with the descriptor set
+            frame.descriptorSet->update(BINDING_CUBEMAP, cubeMap);
+            frame.commandList.invalidate();
+            frame.cubeMapVersion = cubeMapVersion;
         }
 
-        cmdList->beginRendering(renderingConfig);
-        cmdList->setViewport(vireo::Viewport{
-            static_cast<float>(extent.width),
-            static_cast<float>(extent.height)});
-        cmdList->setScissors(vireo::Rect{
+        const auto withStencilBarrier = depthIsReadOnly && depthPrepass.isWithStencil();
+        const auto key = CachedCommandList::makeKey(
+            targetsGeneration,
             extent.width,
-            extent.height});
-        if (depthPrepass.isWithStencil()) {
-            cmdList->setStencilReference(0);
-        }
-        cmdList->bindPipeline(pipeline);
-        cmdList->bindVertexBuffer(vertexBuffer);
-        cmdList->bindDescriptors({frame.descriptorSet, samplers.getDescriptorSet()});
-        cmdList->draw(cubemapVertices.size() / 3);
-        cmdList->endRendering();
+            extent.height,
+            withStencilBarrier,
+            frame.bufferInitialized);
+        const auto& commands = frame.commandList.update(key, [&](const std::shared_ptr<vireo::CommandList>& cmdList) {
+            if (withStencilBarrier) {
+                cmdList->barrier(
+                    renderingConfig.depthStencilRenderTarget,
+                    vireo::ResourceState::RENDER_TARGET_DEPTH_STENCIL_READ,
+                    vireo::ResourceState::RENDER_TARGET_DEPTH_STENCIL);
+            }
+            if (!frame.bufferInitialized) {
+                cmdList->barrier(
+                   colorBuffer,
+                   vireo::ResourceState::UNDEFINED,
+                   vireo::ResourceState::RENDER_TARGET_COLOR);
+            }
+
+            cmdList->beginRendering(renderingConfig);
+            cmdList->setViewport(vireo::Viewport{
+                static_cast<float>(extent.width),
+                static_cast<float>(extent.height)});
+            cmdList->setScissors(vireo::Rect{
+                extent.width,
+                extent.height});
+            if (depthPrepass.isWithStencil()) {
+                cmdList->setStencilReference(0);
+            }
+            cmdList->bindPipeline(pipeline);
+            cmdList->bindIndexBuffer(indexBuffer);
+            cmdList->bindDescriptors({frame.descriptorSet, samplers.getDescriptorSet()});
+            cmdList->drawIndexed(mesh.indexCount, 1, mesh.firstIndex);
+            cmdList->endRendering();
+        });
+        frame.bufferInitialized = true;
 
-        cmdList->end();
         graphicQueue->submit(
            semaphore,
            vireo::WaitStage::FRAGMENT_SHADER,
            vireo::WaitStage::FRAGMENT_SHADER,
            semaphore,
-           {cmdList});
+           {commands});
     }
 
-    std::shared_ptr<vireo::Image> Skybox::loadCubemap(
-        const std::shared_ptr<vireo::CommandList>& cmdList,
-        const std::string& filepath,
-        const vireo::ImageFormat imageFormat) const {
+    Task<> Skybox::loadCubemap(
+        AssetLoader& assetLoader,
+        const std::string filepath,
+        const vireo::ImageFormat imageFormat) {
+        co_await assetLoader.onWorker();
         uint32_t texWidth, texHeight;
         uint64_t imageSize;
         auto *pixels = loadRGBAImage(filepath, texWidth, texHeight, imageSize);
@@ -181,22 +209,29 @@ namespace samples {
                                     imgWidth,
                                     imgHeight,
                                     4));
-        const auto image = vireo->createImage(
-                                     imageFormat,
-                                     imgWidth, imgHeight,
-                                     1,
-                                     6,
-                                     "Cubemap");
+        stbi_image_free(pixels);
 
-        cmdList->barrier(image, vireo::ResourceState::UNDEFINED, vireo::ResourceState::COPY_DST);
-        cmdList->uploadArray(image, data);
-        cmdList->barrier(image, vireo::ResourceState::COPY_DST, vireo::ResourceState::SHADER_READ);
+        auto image = std::shared_ptr<vireo::Image>{};
+        co_await assetLoader.submit(
+            [&](const std::shared_ptr<vireo::CommandList>& cmdList) {
+                image = vireo->createImage(
+                                         imageFormat,
+                                         imgWidth, imgHeight,
+                                         1,
+                                         6,
+                                         "Cubemap");
+                cmdList->barrier(image, vireo::ResourceState::UNDEFINED, vireo::ResourceState::COPY_DST);
+                cmdList->uploadArray(image, data);
+            },
+            [&](const std::shared_ptr<vireo::CommandList>& cmdList) {
+                cmdList->barrier(image, vireo::ResourceState::COPY_DST, vireo::ResourceState::SHADER_READ);
+            });
 
         for (int i = 0; i < 6; i++) {
             delete[] static_cast<std::byte*>(data[i]);
         }
-        stbi_image_free(pixels);
-        return image;
+        cubeMap = image;
+        cubeMapVersion += 1;
     }
 
     std::byte* Skybox::loadRGBAImage(
@@ -9,10 +9,15 @@ export module samples.common.skybox;
 
 import std;
 import vireo;
+import samples.common.assetloader;
 import samples.common.global;
+import samples.common.cachedcommandlist;
 import samples.common.depthprepass;
+import samples.common.geometryarena;
+import samples.common.pipelinecache;
 import samples.common.scene;
 import samples.common.samplers;
+import samples.common.uploadqueue;
 
 export namespace samples {
 
@@ -21,11 +26,16 @@ export namespace samples {
         void onUpdate(const Scene& scene);
         void onInit(
             const std::shared_ptr<vireo::Vireo>& vireo,
-            const std::shared_ptr<vireo::CommandList>& uploadCommandList,
+            PipelineCache& pipelineCache,
+            GeometryArena& geometry,
+            UploadQueue& uploadQueue,
+            AssetLoader& assetLoader,
             vireo::ImageFormat renderFormat,
             const DepthPrepass& depthPrepass,
             const Samplers& samplers,
             std::uint32_t framesInFlight);
+        // Called after the color and depth buffers are recreated
+        void onResize();
         void onRender(
             std::uint32_t frameIndex,
             const vireo::Extent& extent,
@@ -39,18 +49,19 @@ export namespace samples {
         auto getClearValue() const { return renderingConfig.colorRenderTargets[0].clearValue; }
 
     private:
-        struct FrameData : FrameDataCommand {
+        struct FrameData {
+            // Recorded again only when the render targets are recreated, or the extent or the barriers change
+            CachedCommandList                     commandList;
             std::shared_ptr<vireo::Buffer>        globalBuffer;
             std::shared_ptr<vireo::DescriptorSet> descriptorSet;
+            std::uint32_t                         cubeMapVersion{0};
             bool                                  bufferInitialized{false};
         };
 
         static constexpr vireo::DescriptorIndex BINDING_GLOBAL{0};
         static constexpr vireo::DescriptorIndex BINDING_CUBEMAP{1};
+        static constexpr vireo::DescriptorIndex BINDING_VERTICES{2};
 
-        const std::vector<vireo::VertexAttributeDesc> vertexAttributes{
-            {"POSITION", vireo::AttributeFormat::R32G32B32_FLOAT, 0 },
-        };
         vireo::GraphicPipelineConfiguration pipelineConfig {
             .colorBlendDesc      = {{}},
             .cullMode            = vireo::CullMode::BACK,
@@ -77,8 +88,14 @@ export namespace samples {
         Global                                   global{};
         std::vector<FrameData>                   framesData;
         std::shared_ptr<vireo::Vireo>            vireo;
-        std::shared_ptr<vireo::Buffer>           vertexBuffer;
+        std::shared_ptr<vireo::Buffer>           indexBuffer;
+        GeometryArena::MeshRange                 mesh;
+        // 1x1 placeholder until the cube map is loaded
+        std::shared_ptr<vireo::Image>            placeholder;
         std::shared_ptr<vireo::Image>            cubeMap;
+        std::uint32_t                            cubeMapVersion{0};
+        // Incremented each time the render targets are recreated
+        std::uint32_t                            targetsGeneration{0};
         std::shared_ptr<vireo::Pipeline>         pipeline;
         std::shared_ptr<vireo::DescriptorLayout> descriptorLayout;
 
@@ -101,10 +118,11 @@ export namespace samples {
              -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f,  1.0f,  -1.0f, -1.0f,
              1.0f,  -1.0f, -1.0f, -1.0f, -1.0f, 1.0f,  1.0f,  -1.0f, 1.0f};
 
-        std::shared_ptr<vireo::Image> loadCubemap(
-            const std::shared_ptr<vireo::CommandList>& cmdList,
-            const std::string &filepath,
-            vireo::ImageFormat imageFormat) const;
+        // Decodes the cube map on a worker thread and replaces the placeholder once uploaded
+        Task<> loadCubemap(
+            AssetLoader& assetLoader,
+            std::string filepath,
+            vireo::ImageFormat imageFormat);
 
         static std::byte* loadRGBAImage(const std::string& filepath, std::uint32_t& width, std::uint32_t& height, std::uint64_t& size);
 
@@ -0,0 +1,392 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module;
+// The AVX2 functions are compiled for AVX2 whatever the target of the build and only called when the CPU supports it
+#if defined(__x86_64__) || defined(_M_X64)
+#define OCCLUSION_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#else
+#define AVX2_TARGET
+#endif
+module samples.common.softwareocclusion;
+
+namespace samples {
+
+    void SoftwareOcclusion::begin(const glm::mat4& viewProjection) {
+        this->viewProjection = viewProjection;
+        std::fill(depth.begin(), depth.end(), 1.0f);
+        vertexX.clear();
+        vertexY.clear();
+        vertexZ.clear();
+        vertexW.clear();
+        indices.clear();
+    }
+
+    void SoftwareOcclusion::addOccluder(
+        const std::vector<glm::vec3>& positions,
+        const std::vector<std::uint32_t>& indices,
+        const glm::mat4& transform) {
+        const auto mvp = viewProjection * transform;
+        const auto first = static_cast<std::uint32_t>(vertexX.size());
+        for (const auto& position : positions) {
+            const auto clip = mvp * glm::vec4{position, 1.0f};
+            if (clip.w > NEAR_W) {
+                vertexX.push_back((clip.x / clip.w * 0.5f + 0.5f) * WIDTH);
+                vertexY.push_back((0.5f - clip.y / clip.w * 0.5f) * HEIGHT);
+                vertexZ.push_back(clip.z / clip.w);
+            } else {
+                vertexX.push_back(0.0f);
+                vertexY.push_back(0.0f);
+                vertexZ.push_back(0.0f);
+            }
+            vertexW.push_back(clip.w);
+        }
+        for (const auto index : indices) {
+            this->indices.push_back(first + index);
+        }
+    }
+
+    bool SoftwareOcclusion::isAvx2Supported() {
+#ifdef OCCLUSION_AVX2
+        static const auto supported = [] {
+#ifdef _MSC_VER
+            // AVX2 instructions, and the YMM registers saved by the OS
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) { return false; }
+            __cpuid(info, 1);
+            const auto osxsave = (info[2] & (1 << 27)) != 0;
+            const auto avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) { return false; }
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }();
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    void SoftwareOcclusion::setAvx2Enabled(const bool enabled) {
+        avx2 = enabled && isAvx2Supported();
+    }
+
+    void SoftwareOcclusion::rasterize(WorkerPool& workerPool) {
+        if (indices.empty()) { return; }
+        // Degenerated triangles up to a multiple of 8, rejected by the setup
+        while (indices.size() % 24 != 0) {
+            indices.push_back(indices.back());
+        }
+        resizeTriangles(indices.size() / 3);
+        if (avx2) {
+            setupTrianglesAvx2();
+        } else {
+            setupTriangles();
+        }
+        workerPool.parallelFor(HEIGHT / BAND_HEIGHT, 1, [this](const std::size_t begin, const std::size_t end) {
+            for (auto band = begin; band < end; band++) {
+                if (avx2) {
+                    rasterizeBandAvx2(static_cast<std::uint32_t>(band));
+                } else {
+                    rasterizeBand(static_cast<std::uint32_t>(band));
+                }
+            }
+        });
+    }
+
+    void SoftwareOcclusion::resizeTriangles(const std::size_t count) {
+        for (auto i = 0; i < 3; i++) {
+            triangles.edgeA[i].resize(count);
+            triangles.edgeB[i].resize(count);
+            triangles.edgeC[i].resize(count);
+        }
+        triangles.depthA.resize(count);
+        triangles.depthB.resize(count);
+        triangles.depthC.resize(count);
+        triangles.depthMax.resize(count);
+        triangles.minX.resize(count);
+        triangles.maxX.resize(count);
+        triangles.minY.resize(count);
+        triangles.maxY.resize(count);
+    }
+
+    void SoftwareOcclusion::setupTriangles() {
+        const auto count = indices.size() / 3;
+        for (auto t = std::size_t{0}; t < count; t++) {
+            float x[3], y[3], z[3];
+            auto valid = true;
+            for (auto v = 0; v < 3; v++) {
+                const auto index = indices[t * 3 + v];
+                x[v] = vertexX[index];
+                y[v] = vertexY[index];
+                z[v] = vertexZ[index];
+                valid = valid && vertexW[index] > NEAR_W;
+            }
+            const auto x10 = x[1] - x[0], y10 = y[1] - y[0], z10 = z[1] - z[0];
+            const auto x20 = x[2] - x[0], y20 = y[2] - y[0], z20 = z[2] - z[0];
+            const auto area = x10 * y20 - x20 * y10;
+            valid = valid && std::abs(area) > 1e-6f;
+
+            const auto sign = area < 0.0f ? -1.0f : 1.0f;
+            for (auto e = 0; e < 3; e++) {
+                const auto a = (e + 1) % 3;
+                const auto b = (e + 2) % 3;
+                triangles.edgeA[e][t] = (y[a] - y[b]) * sign;
+                triangles.edgeB[e][t] = (x[b] - x[a]) * sign;
+                triangles.edgeC[e][t] = (x[a] * y[b] - y[a] * x[b]) * sign;
+            }
+
+            const auto inverseArea = valid ? 1.0f / area : 1.0f;
+            const auto depthA = (z10 * y20 - z20 * y10) * inverseArea;
+            const auto depthB = (z20 * x10 - z10 * x20) * inverseArea;
+            triangles.depthA[t] = depthA;
+            triangles.depthB[t] = depthB;
+            triangles.depthC[t] = z[0] - (depthA * x[0] + depthB * y[0]) + 0.5f * (std::abs(depthA) + std::abs(depthB));
+            triangles.depthMax[t] = std::max({z[0], z[1], z[2]});
+
+            const auto clampX = [](const float value) { return static_cast<std::int32_t>(std::clamp(value, 0.0f, static_cast<float>(WIDTH))); };
+            const auto clampY = [](const float value) { return static_cast<std::int32_t>(std::clamp(value, 0.0f, static_cast<float>(HEIGHT))); };
+            triangles.minX[t] = clampX(std::floor(std::min({x[0], x[1], x[2]}))) & ~7;
+            triangles.maxX[t] = clampX(std::ceil(std::max({x[0], x[1], x[2]})));
+            triangles.minY[t] = clampY(std::floor(std::min({y[0], y[1], y[2]})));
+            triangles.maxY[t] = valid ? clampY(std::ceil(std::max({y[0], y[1], y[2]}))) : 0;
+        }
+    }
+
+    AVX2_TARGET void SoftwareOcclusion::setupTrianglesAvx2() {
+#ifdef OCCLUSION_AVX2
+        const auto count = indices.size() / 3;
+        const auto stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+        const auto zero = _mm256_setzero_ps();
+        const auto half = _mm256_set1_ps(0.5f);
+        const auto signMask = _mm256_set1_ps(-0.0f);
+        const auto minArea = _mm256_set1_ps(1e-6f);
+        const auto nearW = _mm256_set1_ps(NEAR_W);
+        const auto width = _mm256_set1_ps(static_cast<float>(WIDTH));
+        const auto height = _mm256_set1_ps(static_cast<float>(HEIGHT));
+        const auto alignX = _mm256_set1_epi32(~7);
+        const auto* indexData = reinterpret_cast<const int*>(indices.data());
+        for (auto first = std::size_t{0}; first < count; first += 8) {
+            __m256 x[3], y[3], z[3];
+            auto valid = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (auto v = 0; v < 3; v++) {
+                const auto index = _mm256_i32gather_epi32(indexData + first * 3 + v, stride, 4);
+                x[v] = _mm256_i32gather_ps(vertexX.data(), index, 4);
+                y[v] = _mm256_i32gather_ps(vertexY.data(), index, 4);
+                z[v] = _mm256_i32gather_ps(vertexZ.data(), index, 4);
+                valid = _mm256_and_ps(valid, _mm256_cmp_ps(_mm256_i32gather_ps(vertexW.data(), index, 4), nearW, _CMP_GT_OQ));
+            }
+
+            const auto x10 = _mm256_sub_ps(x[1], x[0]);
+            const auto y10 = _mm256_sub_ps(y[1], y[0]);
+            const auto x20 = _mm256_sub_ps(x[2], x[0]);
+            const auto y20 = _mm256_sub_ps(y[2], y[0]);
+            const auto z10 = _mm256_sub_ps(z[1], z[0]);
+            const auto z20 = _mm256_sub_ps(z[2], z[0]);
+            const auto area = _mm256_sub_ps(_mm256_mul_ps(x10, y20), _mm256_mul_ps(x20, y10));
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(_mm256_andnot_ps(signMask, area), minArea, _CMP_GT_OQ));
+
+            // Both windings are rasterized : the edge functions are flipped to be positive inside
+            const auto sign = _mm256_and_ps(area, signMask);
+            for (auto e = 0; e < 3; e++) {
+                const auto a = (e + 1) % 3;
+                const auto b = (e + 2) % 3;
+                const auto edgeA = _mm256_xor_ps(_mm256_sub_ps(y[a], y[b]), sign);
+                const auto edgeB = _mm256_xor_ps(_mm256_sub_ps(x[b], x[a]), sign);
+                const auto edgeC = _mm256_xor_ps(
+                    _mm256_sub_ps(_mm256_mul_ps(x[a], y[b]), _mm256_mul_ps(y[a], x[b])), sign);
+                _mm256_storeu_ps(&triangles.edgeA[e][first], edgeA);
+                _mm256_storeu_ps(&triangles.edgeB[e][first], edgeB);
+                _mm256_storeu_ps(&triangles.edgeC[e][first], edgeC);
+            }
+
+            const auto inverseArea = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_blendv_ps(_mm256_set1_ps(1.0f), area, valid));
+            const auto depthA = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(z10, y20), _mm256_mul_ps(z20, y10)), inverseArea);
+            const auto depthB = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(z20, x10), _mm256_mul_ps(z10, x20)), inverseArea);
+            // Moved to the farthest corner of the pixel
+            const auto bias = _mm256_mul_ps(half, _mm256_add_ps(
+                _mm256_andnot_ps(signMask, depthA),
+                _mm256_andnot_ps(signMask, depthB)));
+            const auto depthC = _mm256_add_ps(
+                _mm256_sub_ps(z[0], _mm256_add_ps(_mm256_mul_ps(depthA, x[0]), _mm256_mul_ps(depthB, y[0]))),
+                bias);
+            _mm256_storeu_ps(&triangles.depthA[first], depthA);
+            _mm256_storeu_ps(&triangles.depthB[first], depthB);
+            _mm256_storeu_ps(&triangles.depthC[first], depthC);
+            _mm256_storeu_ps(&triangles.depthMax[first], _mm256_max_ps(z[0], _mm256_max_ps(z[1], z[2])));
+
+            // No lambdas : they would not be compiled for AVX2
+            const auto minX = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(
+                _mm256_floor_ps(_mm256_min_ps(x[0], _mm256_min_ps(x[1], x[2]))), zero), width));
+            const auto maxX = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(
+                _mm256_ceil_ps(_mm256_max_ps(x[0], _mm256_max_ps(x[1], x[2]))), zero), width));
+            const auto minY = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(
+                _mm256_floor_ps(_mm256_min_ps(y[0], _mm256_min_ps(y[1], y[2]))), zero), height));
+            // Rejected triangles get an empty rows range
+            const auto maxY = _mm256_and_si256(
+                _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(
+                    _mm256_ceil_ps(_mm256_max_ps(y[0], _mm256_max_ps(y[1], y[2]))), zero), height)),
+                _mm256_castps_si256(valid));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&triangles.minX[first]), _mm256_and_si256(minX, alignX));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&triangles.maxX[first]), maxX);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&triangles.minY[first]), minY);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&triangles.maxY[first]), maxY);
+        }
+#endif
+    }
+
+    void SoftwareOcclusion::rasterizeBand(const std::uint32_t band) {
+        const auto bandMinY = static_cast<std::int32_t>(band * BAND_HEIGHT);
+        const auto bandMaxY = bandMinY + static_cast<std::int32_t>(BAND_HEIGHT);
+        const auto count = indices.size() / 3;
+        for (auto t = std::size_t{0}; t < count; t++) {
+            const auto minY = std::max(triangles.minY[t], bandMinY);
+            const auto maxY = std::min(triangles.maxY[t], bandMaxY);
+            if (minY >= maxY) { continue; }
+            const auto depthA = triangles.depthA[t];
+            const auto depthMax = triangles.depthMax[t];
+
+            // Same operations as the AVX2 path, for the same results
+            for (auto y = minY; y < maxY; y++) {
+                const auto py = static_cast<float>(y) + 0.5f;
+                float edgeA[3], rowC[3];
+                for (auto e = 0; e < 3; e++) {
+                    edgeA[e] = triangles.edgeA[e][t];
+                    rowC[e] = triangles.edgeB[e][t] * py + triangles.edgeC[e][t];
+                }
+                const auto rowDepthC = triangles.depthB[t] * py + triangles.depthC[t];
+                auto* row = &depth[y * WIDTH];
+                for (auto x = triangles.minX[t]; x < triangles.maxX[t]; x++) {
+                    const auto px = static_cast<float>(x) + 0.5f;
+                    if (!(edgeA[0] * px + rowC[0] >= 0.0f &&
+                          edgeA[1] * px + rowC[1] >= 0.0f &&
+                          edgeA[2] * px + rowC[2] >= 0.0f)) {
+                        continue;
+                    }
+                    row[x] = std::min(row[x], std::min(depthA * px + rowDepthC, depthMax));
+                }
+            }
+        }
+    }
+
+    AVX2_TARGET void SoftwareOcclusion::rasterizeBandAvx2(const std::uint32_t band) {
+#ifdef OCCLUSION_AVX2
+        const auto bandMinY = static_cast<std::int32_t>(band * BAND_HEIGHT);
+        const auto bandMaxY = bandMinY + static_cast<std::int32_t>(BAND_HEIGHT);
+        const auto count = indices.size() / 3;
+        const auto zero = _mm256_setzero_ps();
+        const auto lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        for (auto t = std::size_t{0}; t < count; t++) {
+            const auto minY = std::max(triangles.minY[t], bandMinY);
+            const auto maxY = std::min(triangles.maxY[t], bandMaxY);
+            if (minY >= maxY) { continue; }
+            const auto depthA = _mm256_set1_ps(triangles.depthA[t]);
+            const auto depthMax = _mm256_set1_ps(triangles.depthMax[t]);
+
+            for (auto y = minY; y < maxY; y++) {
+                const auto py = static_cast<float>(y) + 0.5f;
+                __m256 edgeA[3], rowC[3];
+                for (auto e = 0; e < 3; e++) {
+                    edgeA[e] = _mm256_set1_ps(triangles.edgeA[e][t]);
+                    rowC[e] = _mm256_set1_ps(triangles.edgeB[e][t] * py + triangles.edgeC[e][t]);
+                }
+                const auto rowDepthC = _mm256_set1_ps(triangles.depthB[t] * py + triangles.depthC[t]);
+                auto* row = &depth[y * WIDTH];
+                for (auto x = triangles.minX[t]; x < triangles.maxX[t]; x += 8) {
+                    const auto px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lanes);
+                    // 8 pixels coverage mask
+                    auto mask = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[0], px), rowC[0]), zero, _CMP_GE_OQ);
+                    mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[1], px), rowC[1]), zero, _CMP_GE_OQ));
+                    mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[2], px), rowC[2]), zero, _CMP_GE_OQ));
+                    if (_mm256_testz_ps(mask, mask)) { continue; }
+                    const auto pixelDepth = _mm256_min_ps(_mm256_add_ps(_mm256_mul_ps(depthA, px), rowDepthC), depthMax);
+                    const auto current = _mm256_loadu_ps(row + x);
+                    _mm256_storeu_ps(row + x, _mm256_blendv_ps(current, _mm256_min_ps(current, pixelDepth), mask));
+                }
+            }
+        }
+#endif
+    }
+
+    bool SoftwareOcclusion::isOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+        auto screenMin = glm::vec2{std::numeric_limits<float>::max()};
+        auto screenMax = glm::vec2{std::numeric_limits<float>::lowest()};
+        auto nearestDepth = 1.0f;
+        for (auto i = 0; i < 8; i++) {
+            const auto corner = glm::vec4{
+                (i & 1) ? boundsMax.x : boundsMin.x,
+                (i & 2) ? boundsMax.y : boundsMin.y,
+                (i & 4) ? boundsMax.z : boundsMin.z,
+                1.0f};
+            const auto clip = viewProjection * corner;
+            // Crossing the near plane
+            if (clip.w <= NEAR_W) { return false; }
+            const auto screen = glm::vec2{
+                (clip.x / clip.w * 0.5f + 0.5f) * WIDTH,
+                (0.5f - clip.y / clip.w * 0.5f) * HEIGHT};
+            screenMin = glm::min(screenMin, screen);
+            screenMax = glm::max(screenMax, screen);
+            nearestDepth = std::min(nearestDepth, clip.z / clip.w);
+        }
+        const auto minX = static_cast<std::int32_t>(std::clamp(std::floor(screenMin.x), 0.0f, static_cast<float>(WIDTH)));
+        const auto maxX = static_cast<std::int32_t>(std::clamp(std::ceil(screenMax.x), 0.0f, static_cast<float>(WIDTH)));
+        const auto minY = static_cast<std::int32_t>(std::clamp(std::floor(screenMin.y), 0.0f, static_cast<float>(HEIGHT)));
+        const auto maxY = static_cast<std::int32_t>(std::clamp(std::ceil(screenMax.y), 0.0f, static_cast<float>(HEIGHT)));
+        if (minX >= maxX || minY >= maxY) { return false; }
+
+        return avx2 ?
+            isRectOccludedAvx2(minX, maxX, minY, maxY, nearestDepth) :
+            isRectOccluded(minX, maxX, minY, maxY, nearestDepth);
+    }
+
+    bool SoftwareOcclusion::isRectOccluded(
+        const std::int32_t minX, const std::int32_t maxX,
+        const std::int32_t minY, const std::int32_t maxY,
+        const float nearestDepth) const {
+        for (auto y = minY; y < maxY; y++) {
+            for (auto x = minX; x < maxX; x++) {
+                if (nearestDepth <= depth[y * WIDTH + x]) { return false; }
+            }
+        }
+        return true;
+    }
+
+    AVX2_TARGET bool SoftwareOcclusion::isRectOccludedAvx2(
+        const std::int32_t minX, const std::int32_t maxX,
+        const std::int32_t minY, const std::int32_t maxY,
+        const float nearestDepth) const {
+#ifdef OCCLUSION_AVX2
+        const auto nearest = _mm256_set1_ps(nearestDepth);
+        const auto lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const auto first = _mm256_set1_epi32(minX - 1);
+        const auto last = _mm256_set1_epi32(maxX);
+        for (auto y = minY; y < maxY; y++) {
+            const auto* row = &depth[y * WIDTH];
+            for (auto x = minX & ~7; x < maxX; x += 8) {
+                const auto px = _mm256_add_epi32(_mm256_set1_epi32(x), lanes);
+                const auto inside = _mm256_castsi256_ps(_mm256_and_si256(
+                    _mm256_cmpgt_epi32(px, first),
+                    _mm256_cmpgt_epi32(last, px)));
+                // Visible where the box is not behind the occluders
+                const auto visible = _mm256_and_ps(inside, _mm256_cmp_ps(nearest, _mm256_loadu_ps(row + x), _CMP_LE_OQ));
+                if (!_mm256_testz_ps(visible, visible)) { return false; }
+            }
+        }
+#endif
+        return true;
+    }
+
+}
\ No newline at end of file
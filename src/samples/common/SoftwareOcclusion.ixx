@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.softwareocclusion;
+
+import std;
+import glm;
+import samples.common.workerpool;
+
+export namespace samples {
+
+    // CPU occlusion culling : a few occluders are rasterized in a low resolution depth buffer,
+    // then the screen rectangles of the instances bounds are tested against it.
+    // Triangles are set up 8 at a time and the pixels are rasterized 8 at a time with AVX2 when the CPU supports it,
+    // the scalar path giving the same results otherwise.
+    class SoftwareOcclusion {
+    public:
+        static constexpr std::uint32_t WIDTH{256};
+        static constexpr std::uint32_t HEIGHT{128};
+        // Rows rasterized by one worker task
+        static constexpr std::uint32_t BAND_HEIGHT{8};
+
+        // Clears the depth buffer and the occluders
+        void begin(const glm::mat4& viewProjection);
+
+        // Adds a triangles list, in world space with the given transform
+        void addOccluder(
+            const std::vector<glm::vec3>& positions,
+            const std::vector<std::uint32_t>& indices,
+            const glm::mat4& transform);
+
+        // Rasterizes the occluders added since begin(), each band of the depth buffer by one worker
+        void rasterize(WorkerPool& workerPool);
+
+        // True if the world space box is entirely behind the occluders
+        bool isOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+        // Nearest depth of the occluders for each pixel, 1.0 where there is none, row-major
+        const auto& getDepth() const { return depth; }
+
+        auto getTriangleCount() const { return static_cast<std::uint32_t>(indices.size() / 3); }
+
+        // Checked once with CPUID
+        static bool isAvx2Supported();
+
+        // The AVX2 path is used by default when supported, disabled to compare it with the scalar one
+        void setAvx2Enabled(bool enabled);
+
+        auto isAvx2Enabled() const { return avx2; }
+
+    private:
+        // Vertices behind this clip space w are rejected, the triangles using them are not rasterized
+        static constexpr float NEAR_W{1e-4f};
+
+        // Edge functions and depth plane of each triangle, for pixel centers
+        struct Triangles {
+            std::vector<float>        edgeA[3], edgeB[3], edgeC[3];
+            std::vector<float>        depthA, depthB, depthC; // conservative : farthest depth of the pixel
+            std::vector<float>        depthMax;
+            std::vector<std::int32_t> minX, maxX, minY, maxY; // pixels bounds, minX aligned on 8
+        };
+
+        glm::mat4                  viewProjection{1.0f};
+        std::vector<float>         depth = std::vector<float>(WIDTH * HEIGHT, 1.0f);
+        // Screen space vertices, x and y in pixels, z in [0, 1]
+        std::vector<float>         vertexX, vertexY, vertexZ, vertexW;
+        std::vector<std::uint32_t> indices;
+        Triangles                  triangles;
+        bool                       avx2{isAvx2Supported()};
+
+        void resizeTriangles(std::size_t count);
+
+        void setupTriangles();
+
+        void setupTrianglesAvx2();
+
+        void rasterizeBand(std::uint32_t band);
+
+        void rasterizeBandAvx2(std::uint32_t band);
+
+        // True if the pixels rectangle is entirely behind the occluders
+        bool isRectOccluded(std::int32_t minX, std::int32_t maxX, std::int32_t minY, std::int32_t maxY, float nearestDepth) const;
+
+        bool isRectOccludedAvx2(std::int32_t minX, std::int32_t maxX, std::int32_t minY, std::int32_t maxY, float nearestDepth) const;
+    };
+
+}
@@ -0,0 +1,62 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.statetracker;
+
+namespace samples {
+
+    void StateTracker::track(const std::shared_ptr<vireo::RenderTarget>& target, const vireo::ResourceState state) {
+        targets[target.get()] = { target, state, state };
+    }
+
+    void StateTracker::transition(const std::shared_ptr<vireo::RenderTarget>& target, const vireo::ResourceState state) {
+        const auto it = targets.find(target.get());
+        if (it == targets.end() || it->second.target.lock() != target) {
+            throw std::runtime_error("Transition of an untracked render target");
+        }
+        auto& tracked = it->second;
+        if (tracked.requested != state) {
+            tracked.requested = state;
+            tracked.requestCount += 1;
+        }
+    }
+
+    void StateTracker::transitionAll(const vireo::ResourceState state) {
+        for (auto& tracked : std::views::values(targets)) {
+            if (tracked.requested != state) {
+                tracked.requested = state;
+                tracked.requestCount += 1;
+            }
+        }
+    }
+
+    void StateTracker::flush(const std::shared_ptr<vireo::CommandList>& cmdList) {
+        using Transition = std::pair<vireo::ResourceState, vireo::ResourceState>;
+        auto batches = std::map<Transition, std::vector<std::shared_ptr<const vireo::RenderTarget>>>{};
+        std::uint32_t requestCount{0};
+        for (auto it = targets.begin(); it != targets.end();) {
+            auto& tracked = it->second;
+            const auto target = tracked.target.lock();
+            if (!target) {
+                it = targets.erase(it);
+                continue;
+            }
+            requestCount += tracked.requestCount;
+            tracked.requestCount = 0;
+            if (tracked.requested != tracked.state) {
+                batches[{tracked.state, tracked.requested}].push_back(target);
+                tracked.state = tracked.requested;
+            }
+            ++it;
+        }
+        for (const auto& [transition, batch] : batches) {
+            cmdList->barrier(batch, transition.first, transition.second);
+        }
+        barrierCount += batches.size();
+        savedCount += requestCount - batches.size();
+    }
+
+}
@@ -0,0 +1,49 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.statetracker;
+
+import std;
+import vireo;
+
+export namespace samples {
+
+    // Tracks the state of render targets and batches their transitions : transition() only records
+    // the requested state, flush() issues one barrier per (before, after) pair for all the pending
+    // transitions and must be called before the next draw or dispatch using them.
+    // A transition undone before the flush is dropped.
+    class StateTracker {
+    public:
+        // Starts tracking a render target, or resets its known state
+        void track(const std::shared_ptr<vireo::RenderTarget>& target, vireo::ResourceState state);
+
+        // Requests a transition of a tracked render target
+        void transition(const std::shared_ptr<vireo::RenderTarget>& target, vireo::ResourceState state);
+
+        // Requests a transition of all the tracked render targets
+        void transitionAll(vireo::ResourceState state);
+
+        // Issues the pending transitions
+        void flush(const std::shared_ptr<vireo::CommandList>& cmdList);
+
+        // Barriers issued by the flushes, and transitions dropped or batched into another barrier
+        auto getBarrierCount() const { return barrierCount; }
+        auto getSavedCount() const { return savedCount; }
+
+    private:
+        struct Target {
+            std::weak_ptr<vireo::RenderTarget> target;
+            vireo::ResourceState               state;     // at the last flush
+            vireo::ResourceState               requested;
+            std::uint32_t                      requestCount{0};
+        };
+
+        std::map<const vireo::RenderTarget*, Target> targets;
+        std::uint64_t                                barrierCount{0};
+        std::uint64_t                                savedCount{0};
+    };
+
+}
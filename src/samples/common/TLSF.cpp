@@ -0,0 +1,148 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.tlsf;
+
+namespace samples {
+
+    void TLSF::reset(const std::uint32_t size) {
+        this->size = size;
+        freeSize = size;
+        blocks.clear();
+        unusedBlocks.clear();
+        flBitmap = 0;
+        slBitmaps.fill(0);
+        freeLists.fill(INVALID);
+        if (size > 0) {
+            insertFree(newBlock(0, size));
+        }
+    }
+
+    TLSF::Allocation TLSF::allocate(std::uint32_t size) {
+        size = std::max(size, 1u);
+        // Rounded up to the next size class : all the blocks of the class found are large enough
+        auto searchSize = size;
+        if (size >= SL_COUNT) {
+            const auto round = (1u << (std::bit_width(size) - 1 - SL_BITS)) - 1;
+            if (size > INVALID - round) { return {}; }
+            searchSize += round;
+        }
+        auto [fl, sl] = mapping(searchSize);
+        auto slMap = slBitmaps[fl] & (~0u << sl);
+        if (slMap == 0) {
+            const auto flMap = fl + 1 < FL_COUNT ? flBitmap & (~0u << (fl + 1)) : 0;
+            if (flMap == 0) { return {}; }
+            fl = std::countr_zero(flMap);
+            slMap = slBitmaps[fl];
+        }
+        sl = std::countr_zero(slMap);
+
+        const auto index = freeLists[fl * SL_COUNT + sl];
+        removeFree(index);
+        if (blocks[index].size > size) {
+            // The remaining part stays free
+            const auto remaining = newBlock(blocks[index].offset + size, blocks[index].size - size);
+            blocks[index].size = size;
+            blocks[remaining].previous = index;
+            blocks[remaining].next = blocks[index].next;
+            if (blocks[index].next != INVALID) {
+                blocks[blocks[index].next].previous = remaining;
+            }
+            blocks[index].next = remaining;
+            insertFree(remaining);
+        }
+        freeSize -= size;
+        return { blocks[index].offset, index };
+    }
+
+    void TLSF::free(const Allocation& allocation) {
+        if (!allocation.isValid()) { return; }
+        auto index = allocation.block;
+        freeSize += blocks[index].size;
+        const auto next = blocks[index].next;
+        if (next != INVALID && blocks[next].free) {
+            removeFree(next);
+            merge(index, next);
+        }
+        const auto previous = blocks[index].previous;
+        if (previous != INVALID && blocks[previous].free) {
+            removeFree(previous);
+            merge(previous, index);
+            index = previous;
+        }
+        insertFree(index);
+    }
+
+    std::pair<std::uint32_t, std::uint32_t> TLSF::mapping(const std::uint32_t size) {
+        // The small sizes have one class per size
+        if (size < SL_COUNT) {
+            return { 0, size };
+        }
+        const auto log2 = static_cast<std::uint32_t>(std::bit_width(size)) - 1;
+        return { log2 - SL_BITS + 1, (size >> (log2 - SL_BITS)) - SL_COUNT };
+    }
+
+    std::uint32_t TLSF::newBlock(const std::uint32_t offset, const std::uint32_t size) {
+        auto index = static_cast<std::uint32_t>(blocks.size());
+        if (unusedBlocks.empty()) {
+            blocks.push_back({});
+        } else {
+            index = unusedBlocks.back();
+            unusedBlocks.pop_back();
+            blocks[index] = {};
+        }
+        blocks[index].offset = offset;
+        blocks[index].size = size;
+        return index;
+    }
+
+    void TLSF::insertFree(const std::uint32_t index) {
+        auto& block = blocks[index];
+        const auto [fl, sl] = mapping(block.size);
+        auto& head = freeLists[fl * SL_COUNT + sl];
+        block.free = true;
+        block.previousFree = INVALID;
+        block.nextFree = head;
+        if (head != INVALID) {
+            blocks[head].previousFree = index;
+        }
+        head = index;
+        flBitmap |= 1u << fl;
+        slBitmaps[fl] |= 1u << sl;
+    }
+
+    void TLSF::removeFree(const std::uint32_t index) {
+        auto& block = blocks[index];
+        const auto [fl, sl] = mapping(block.size);
+        if (block.previousFree != INVALID) {
+            blocks[block.previousFree].nextFree = block.nextFree;
+        } else {
+            freeLists[fl * SL_COUNT + sl] = block.nextFree;
+        }
+        if (block.nextFree != INVALID) {
+            blocks[block.nextFree].previousFree = block.previousFree;
+        }
+        if (freeLists[fl * SL_COUNT + sl] == INVALID) {
+            slBitmaps[fl] &= ~(1u << sl);
+            if (slBitmaps[fl] == 0) {
+                flBitmap &= ~(1u << fl);
+            }
+        }
+        block.free = false;
+        block.previousFree = INVALID;
+        block.nextFree = INVALID;
+    }
+
+    void TLSF::merge(const std::uint32_t index, const std::uint32_t next) {
+        blocks[index].size += blocks[next].size;
+        blocks[index].next = blocks[next].next;
+        if (blocks[next].next != INVALID) {
+            blocks[blocks[next].next].previous = index;
+        }
+        unusedBlocks.push_back(next);
+    }
+
+}
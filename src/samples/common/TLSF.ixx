@@ -0,0 +1,77 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.tlsf;
+
+import std;
+
+export namespace samples {
+
+    // Two-level segregated fit allocator of ranges in a buffer, the memory itself is managed by the user.
+    // The free blocks are kept in lists by size class, found with two bitmaps and merged with their free
+    // neighbours when freed : allocations and frees run in constant time.
+    class TLSF {
+    public:
+        static constexpr std::uint32_t INVALID{std::numeric_limits<std::uint32_t>::max()};
+
+        struct Allocation {
+            std::uint32_t offset{INVALID};
+            std::uint32_t block{INVALID};
+
+            auto isValid() const { return block != INVALID; }
+        };
+
+        explicit TLSF(std::uint32_t size = 0) { reset(size); }
+
+        // Frees all the allocations and manages a range of size units
+        void reset(std::uint32_t size);
+
+        // Returns an invalid allocation if there is no free range large enough
+        Allocation allocate(std::uint32_t size);
+
+        void free(const Allocation& allocation);
+
+        auto getSize() const { return size; }
+        auto getFreeSize() const { return freeSize; }
+
+    private:
+        static constexpr std::uint32_t SL_BITS{4};
+        static constexpr std::uint32_t SL_COUNT{1 << SL_BITS};
+        static constexpr std::uint32_t FL_COUNT{32};
+
+        struct Block {
+            std::uint32_t offset{0};
+            std::uint32_t size{0};
+            // Neighbours in the buffer and in the free list of the size class
+            std::uint32_t previous{INVALID};
+            std::uint32_t next{INVALID};
+            std::uint32_t previousFree{INVALID};
+            std::uint32_t nextFree{INVALID};
+            bool          free{false};
+        };
+
+        std::uint32_t                                   size{0};
+        std::uint32_t                                   freeSize{0};
+        std::vector<Block>                              blocks;
+        std::vector<std::uint32_t>                      unusedBlocks;
+        std::uint32_t                                   flBitmap{0};
+        std::array<std::uint32_t, FL_COUNT>             slBitmaps{};
+        std::array<std::uint32_t, FL_COUNT * SL_COUNT>  freeLists{};
+
+        // First and second level indices of the size class
+        static std::pair<std::uint32_t, std::uint32_t> mapping(std::uint32_t size);
+
+        std::uint32_t newBlock(std::uint32_t offset, std::uint32_t size);
+
+        void insertFree(std::uint32_t index);
+
+        void removeFree(std::uint32_t index);
+
+        // Adds the next block to the block and releases it
+        void merge(std::uint32_t index, std::uint32_t next);
+    };
+
+}
@@ -0,0 +1,306 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module;
+#include <stb_image.h>
+module samples.common.texturestreamer;
+
+namespace samples {
+
+    void TextureStreamer::onInit(
+        const std::shared_ptr<vireo::Vireo>& vireo,
+        const std::shared_ptr<vireo::SubmitQueue>& graphicQueue,
+        AssetLoader& assetLoader,
+        const std::uint32_t framesInFlight) {
+        this->vireo = vireo;
+        this->graphicQueue = graphicQueue;
+        this->assetLoader = &assetLoader;
+        this->framesInFlight = framesInFlight;
+        transferQueue = vireo->createSubmitQueue(vireo::CommandType::TRANSFER, "Streaming");
+        transferCommandAllocator = vireo->createCommandAllocator(vireo::CommandType::TRANSFER);
+        transferCommandList = transferCommandAllocator->createCommandList();
+        acquireCommandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
+        acquireCommandList = acquireCommandAllocator->createCommandList();
+    }
+
+    std::uint32_t TextureStreamer::add(
+        UploadQueue& uploadQueue,
+        const vireo::ImageFormat format,
+        const std::string& filename) {
+        const auto pixelSize = vireo::Image::getPixelSize(format);
+        const auto placeholder = Texture {
+            .format      = format,
+            .name        = filename,
+            .pixelSize   = pixelSize,
+            .mips        = {{1, 1, getPlaceholder(format)}},
+            .residentMip = 0,
+            .minimalMip  = 0,
+        };
+        const auto image = upload(uploadQueue.getCommandList(), uploadQueue.getStagingBuffers(), placeholder, 0);
+        uploadQueue.acquire(image);
+
+        const auto index = static_cast<std::uint32_t>(textures.size());
+        textures.push_back({ .format = format, .name = filename, .pixelSize = pixelSize });
+        images.push_back(image);
+        assetLoader->start(load(index, format, filename));
+        return index;
+    }
+
+    Task<> TextureStreamer::load(const std::uint32_t index, const vireo::ImageFormat format, const std::string filename) {
+        co_await assetLoader->onWorker();
+        const auto pixelSize = vireo::Image::getPixelSize(format);
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load(("res/" + filename).c_str(), &width, &height,&channels, pixelSize);
+        if (!pixels) {
+            throw std::runtime_error("Failed to load texture: " + filename);
+        }
+        auto texture = Texture {
+            .format    = format,
+            .name      = filename,
+            .pixelSize = pixelSize,
+            .mips      = generateMips(pixels, width, height, pixelSize),
+        };
+        stbi_image_free(pixels);
+
+        // The first mip small enough to be uploaded in one go is always resident
+        texture.minimalMip = static_cast<std::uint32_t>(texture.mips.size() - 1);
+        for (auto level = 0u; level < texture.mips.size(); level++) {
+            const auto& mip = texture.mips[level];
+            if (std::max(mip.width, mip.height) <= INITIAL_RESIDENT_SIZE) {
+                texture.minimalMip = level;
+                break;
+            }
+        }
+        texture.residentMip = texture.minimalMip;
+        texture.loaded = true;
+
+        auto image = std::shared_ptr<vireo::Image>{};
+        auto stagingBuffers = std::vector<std::shared_ptr<vireo::Buffer>>{};
+        co_await assetLoader->submit(
+            [&](const std::shared_ptr<vireo::CommandList>& cmdList) {
+                image = upload(cmdList, stagingBuffers, texture, texture.residentMip);
+            },
+            [&](const std::shared_ptr<vireo::CommandList>& cmdList) {
+                const auto mipCount = static_cast<std::uint32_t>(texture.mips.size()) - texture.residentMip;
+                cmdList->barrier(
+                    image,
+                    vireo::ResourceState::COPY_DST,
+                    vireo::ResourceState::SHADER_READ,
+                    0, mipCount);
+            });
+
+        // The placeholder can still be used by the frames in flight
+        retired.push_back({frameCount + framesInFlight + 1, images[index]});
+        textures[index] = std::move(texture);
+        images[index] = image;
+        version += 1;
+    }
+
+    void TextureStreamer::requestScreenSize(const std::uint32_t index, const float pixels) {
+        textures[index].screenSize = std::max(textures[index].screenSize, pixels);
+    }
+
+    void TextureStreamer::onUpdate() {
+        frameCount += 1;
+        while (!retired.empty() && retired.front().releaseFrame <= frameCount) {
+            retired.pop_front();
+        }
+        if (!streaming) {
+            submitUploads();
+        }
+        for (auto& texture : textures) {
+            texture.screenSize = 0.0f;
+        }
+    }
+
+    void TextureStreamer::onDestroy() {
+        transferQueue->waitIdle();
+        retired.clear();
+        uploads.clear();
+        uploadStagingBuffers.clear();
+    }
+
+    std::size_t TextureStreamer::getResidentMemory() const {
+        auto total = std::size_t{0};
+        for (const auto& texture : textures) {
+            total += getSize(texture, texture.residentMip);
+        }
+        return total;
+    }
+
+    void TextureStreamer::submitUploads() {
+        // Most visible textures first, each one getting its wanted resolution if it fits in the budget
+        auto order = std::vector<std::uint32_t>(textures.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::stable_sort(order, [&](const auto a, const auto b) {
+            return textures[a].screenSize > textures[b].screenSize;
+        });
+        auto targets = std::vector<std::uint32_t>(textures.size());
+        auto used = std::size_t{0};
+        for (const auto index : order) {
+            const auto& texture = textures[index];
+            if (!texture.loaded) { continue; }
+            auto mip = getWantedMip(texture);
+            while (mip < texture.minimalMip && used + getSize(texture, mip) > memoryBudget) {
+                mip += 1;
+            }
+            targets[index] = mip;
+            used += getSize(texture, mip);
+        }
+
+        auto batchSize = std::size_t{0};
+        for (const auto index : order) {
+            const auto& texture = textures[index];
+            const auto target = targets[index];
+            if (!texture.loaded || target == texture.residentMip) { continue; }
+            // Evictions go straight to the target, refinements are progressive, one mip per batch
+            const auto firstMip = target > texture.residentMip ? target : texture.residentMip - 1;
+            const auto size = getSize(texture, firstMip);
+            if (batchSize > 0 && batchSize + size > MAX_BATCH_SIZE) { break; }
+            batchSize += size;
+            uploads.push_back({index, firstMip});
+        }
+        if (uploads.empty()) { return; }
+        streaming = true;
+        assetLoader->start(stream());
+    }
+
+    Task<> TextureStreamer::stream() {
+        transferCommandAllocator->reset();
+        transferCommandList->begin();
+        for (auto& upload : uploads) {
+            upload.image = this->upload(transferCommandList, uploadStagingBuffers, textures[upload.index], upload.firstMip);
+        }
+        transferCommandList->end();
+        const auto semaphore = vireo->createSemaphore(vireo::SemaphoreType::TIMELINE, "Streaming timeline");
+        transferQueue->submit(vireo::WaitStage::TRANSFER, semaphore, {transferCommandList});
+
+        // Uploaded images are left in COPY_DST by the transfer queue, the transition to SHADER_READ
+        // is submitted on the graphic queue before the command lists of the frame, after the copies
+        acquireCommandAllocator->reset();
+        acquireCommandList->begin();
+        for (const auto& upload : uploads) {
+            const auto mipCount = static_cast<std::uint32_t>(textures[upload.index].mips.size()) - upload.firstMip;
+            acquireCommandList->barrier(
+                upload.image,
+                vireo::ResourceState::COPY_DST,
+                vireo::ResourceState::SHADER_READ,
+                0, mipCount);
+        }
+        acquireCommandList->end();
+        graphicQueue->submit(
+            semaphore,
+            vireo::WaitStage::TRANSFER,
+            vireo::WaitStage::TRANSFER,
+            semaphore,
+            {acquireCommandList});
+
+        // Previous images can still be used by the frames in flight
+        const auto releaseFrame = frameCount + framesInFlight + 1;
+        for (const auto& upload : uploads) {
+            retired.push_back({releaseFrame, images[upload.index]});
+            images[upload.index] = upload.image;
+            textures[upload.index].residentMip = upload.firstMip;
+        }
+        uploads.clear();
+        version += 1;
+
+        co_await assetLoader->afterFrames(framesInFlight + 1);
+        uploadStagingBuffers.clear();
+        streaming = false;
+    }
+
+    std::shared_ptr<vireo::Image> TextureStreamer::upload(
+        const std::shared_ptr<vireo::CommandList>& cmdList,
+        std::vector<std::shared_ptr<vireo::Buffer>>& stagingBuffers,
+        const Texture& texture,
+        const std::uint32_t firstMip) const {
+        const auto mipCount = static_cast<std::uint32_t>(texture.mips.size()) - firstMip;
+        auto image = vireo->createImage(
+            texture.format,
+            texture.mips[firstMip].width, texture.mips[firstMip].height,
+            mipCount, 1,
+            texture.name);
+        cmdList->barrier(
+            image,
+            vireo::ResourceState::UNDEFINED,
+            vireo::ResourceState::COPY_DST,
+            0, mipCount);
+        for (auto level = 0u; level < mipCount; level++) {
+            const auto& mip = texture.mips[firstMip + level];
+            const auto buffer = vireo->createBuffer(vireo::BufferType::IMAGE_UPLOAD, mip.width * texture.pixelSize, mip.height);
+            buffer->map();
+            buffer->write(mip.pixels.data());
+            cmdList->copy(buffer, image, 0, level, false);
+            stagingBuffers.push_back(buffer);
+        }
+        return image;
+    }
+
+    std::size_t TextureStreamer::getSize(const Texture& texture, const std::uint32_t firstMip) const {
+        auto size = std::size_t{0};
+        for (auto level = firstMip; level < texture.mips.size(); level++) {
+            size += texture.mips[level].pixels.size();
+        }
+        return size;
+    }
+
+    std::uint32_t TextureStreamer::getWantedMip(const Texture& texture) const {
+        if (texture.screenSize <= 0.0f) {
+            return texture.minimalMip;
+        }
+        // One texel per pixel
+        const auto ratio = static_cast<float>(texture.mips[0].width) / texture.screenSize;
+        const auto mip = ratio <= 1.0f ? 0u : static_cast<std::uint32_t>(std::floor(std::log2(ratio)));
+        return std::min(mip, texture.minimalMip);
+    }
+
+    std::vector<std::uint8_t> TextureStreamer::getPlaceholder(const vireo::ImageFormat format) {
+        switch (format) {
+        case vireo::ImageFormat::R8G8B8A8_UNORM:
+            return {128, 128, 255, 255};
+        case vireo::ImageFormat::R8_UNORM:
+            return {255};
+        default:
+            return std::vector<std::uint8_t>(vireo::Image::getPixelSize(format), 128);
+        }
+    }
+
+    std::vector<TextureStreamer::MipLevel> TextureStreamer::generateMips(
+        const std::uint8_t* pixels,
+        const std::uint32_t width,
+        const std::uint32_t height,
+        const std::uint32_t pixelSize) {
+        auto mips = std::vector<MipLevel>{};
+        mips.push_back({width, height, {pixels, pixels + width * height * pixelSize}});
+        // generating mip levels until reaching 4x4 resolution
+        while (mips.back().width > 4 || mips.back().height > 4) {
+            const auto& previous = mips.back();
+            const auto w = (previous.width > 1) ? previous.width / 2 : 1;
+            const auto h = (previous.height > 1) ? previous.height / 2 : 1;
+            auto data = std::vector<std::uint8_t>(w * h * pixelSize);
+            // Generate mip data by averaging 2x2 blocks from the previous level
+            for (auto y = 0u; y < h; ++y) {
+                for (auto x = 0u; x < w; ++x) {
+                    const auto srcX0 = std::min(x * 2, previous.width - 1);
+                    const auto srcY0 = std::min(y * 2, previous.height - 1);
+                    const auto srcX1 = std::min(srcX0 + 1, previous.width - 1);
+                    const auto srcY1 = std::min(srcY0 + 1, previous.height - 1);
+                    for (auto c = 0u; c < pixelSize; ++c) {
+                        const auto sum = previous.pixels[(srcY0 * previous.width + srcX0) * pixelSize + c] +
+                                         previous.pixels[(srcY0 * previous.width + srcX1) * pixelSize + c] +
+                                         previous.pixels[(srcY1 * previous.width + srcX0) * pixelSize + c] +
+                                         previous.pixels[(srcY1 * previous.width + srcX1) * pixelSize + c];
+                        data[(y * w + x) * pixelSize + c] = static_cast<std::uint8_t>(sum / 4);
+                    }
+                }
+            }
+            mips.push_back({w, h, std::move(data)});
+        }
+        return mips;
+    }
+
+}
@@ -0,0 +1,136 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.texturestreamer;
+
+import std;
+import vireo;
+import samples.common.assetloader;
+import samples.common.uploadqueue;
+
+export namespace samples {
+
+    // Progressive texture streaming : only the smallest mips are uploaded at init time, the more detailed
+    // mips are paged in (and out) asynchronously on a transfer queue, driven by the on-screen size
+    // of the models using each texture and bounded by a memory budget. The textures are loaded by coroutines
+    // of the asset loader, a 1x1 placeholder is used until the lowest mips of a texture are uploaded.
+    class TextureStreamer {
+    public:
+        // Mips up to this size are resident from the first frame
+        static constexpr std::uint32_t INITIAL_RESIDENT_SIZE{64};
+        static constexpr std::size_t   DEFAULT_MEMORY_BUDGET{32 * 1024 * 1024};
+        // Upper bound of the data sent to the GPU per streaming batch
+        static constexpr std::size_t   MAX_BATCH_SIZE{8 * 1024 * 1024};
+
+        void onInit(
+            const std::shared_ptr<vireo::Vireo>& vireo,
+            const std::shared_ptr<vireo::SubmitQueue>& graphicQueue,
+            AssetLoader& assetLoader,
+            std::uint32_t framesInFlight);
+
+        void onUpdate();
+
+        void onDestroy();
+
+        // Uploads a placeholder and starts the loading of a texture, returns the texture index
+        std::uint32_t add(
+            UploadQueue& uploadQueue,
+            vireo::ImageFormat format,
+            const std::string& filename);
+
+        // Size, in pixels, of the largest on-screen surface using this texture during the current frame
+        void requestScreenSize(std::uint32_t index, float pixels);
+
+        void setMemoryBudget(const std::size_t budget) { memoryBudget = budget; }
+
+        const auto& getImages() const { return images; }
+
+        // Incremented each time an image is replaced, used by the resource heap to refresh its descriptor sets
+        auto getVersion() const { return version; }
+
+        std::size_t getResidentMemory() const;
+
+    private:
+        struct MipLevel {
+            std::uint32_t             width;
+            std::uint32_t             height;
+            std::vector<std::uint8_t> pixels;
+        };
+
+        struct Texture {
+            vireo::ImageFormat    format;
+            std::string           name;
+            std::uint32_t         pixelSize;
+            std::vector<MipLevel> mips;
+            std::uint32_t         residentMip;
+            std::uint32_t         minimalMip;
+            float                 screenSize{0.0f};
+            // False while the placeholder is used, the texture is not streamed
+            bool                  loaded{false};
+        };
+
+        struct Upload {
+            std::uint32_t                 index;
+            std::uint32_t                 firstMip;
+            std::shared_ptr<vireo::Image> image;
+        };
+
+        struct Retired {
+            std::uint64_t                 releaseFrame;
+            std::shared_ptr<vireo::Image> image;
+        };
+
+        std::shared_ptr<vireo::Vireo>               vireo;
+        std::shared_ptr<vireo::SubmitQueue>         graphicQueue;
+        AssetLoader*                                assetLoader{nullptr};
+        std::shared_ptr<vireo::SubmitQueue>         transferQueue;
+        std::shared_ptr<vireo::CommandAllocator>    transferCommandAllocator;
+        std::shared_ptr<vireo::CommandList>         transferCommandList;
+        std::shared_ptr<vireo::CommandAllocator>    acquireCommandAllocator;
+        std::shared_ptr<vireo::CommandList>         acquireCommandList;
+        std::vector<Texture>                        textures;
+        std::vector<std::shared_ptr<vireo::Image>>  images;
+        std::vector<Upload>                         uploads;
+        std::vector<std::shared_ptr<vireo::Buffer>> uploadStagingBuffers;
+        // One batch at a time, the command lists are reused by the next one
+        bool                                        streaming{false};
+        std::list<Retired>                          retired;
+        std::size_t                                 memoryBudget{DEFAULT_MEMORY_BUDGET};
+        std::uint32_t                               framesInFlight{0};
+        std::uint64_t                               frameCount{0};
+        std::uint32_t                               version{0};
+
+        std::size_t getSize(const Texture& texture, std::uint32_t firstMip) const;
+
+        std::uint32_t getWantedMip(const Texture& texture) const;
+
+        // Decodes the texture on a worker thread then uploads its lowest mips in place of the placeholder
+        Task<> load(std::uint32_t index, vireo::ImageFormat format, std::string filename);
+
+        // Selects the next batch of uploads and starts its streaming
+        void submitUploads();
+
+        // Submits the copies and their acquisition by the graphic queue, which waits for them on the GPU,
+        // then completes once the frames in flight are done with the command lists and the staging buffers
+        Task<> stream();
+
+        std::shared_ptr<vireo::Image> upload(
+            const std::shared_ptr<vireo::CommandList>& cmdList,
+            std::vector<std::shared_ptr<vireo::Buffer>>& stagingBuffers,
+            const Texture& texture,
+            std::uint32_t firstMip) const;
+
+        // Neutral value of the kinds of material textures : gray color, flat normal or no occlusion
+        static std::vector<std::uint8_t> getPlaceholder(vireo::ImageFormat format);
+
+        static std::vector<MipLevel> generateMips(
+            const std::uint8_t* pixels,
+            std::uint32_t width,
+            std::uint32_t height,
+            std::uint32_t pixelSize);
+    };
+
+}
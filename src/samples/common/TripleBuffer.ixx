@@ -0,0 +1,49 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.triplebuffer;
+
+import std;
+
+export namespace samples {
+
+    // Lock-free single producer, single consumer exchange of the latest value of a state.
+    // The producer writes the back slot and publishes it, the consumer reads the front slot, replaced by the
+    // last published slot in acquire() : both sides continue without waiting for each other, the values not
+    // acquired before the next publish() are dropped. The slots are reused : their containers keep their capacity.
+    template <typename T>
+    class TripleBuffer {
+    public:
+        // Slot written by the producer, not read by the consumer until publish()
+        T& getBack() { return slots[back]; }
+
+        // Exchanges the back slot with the pending one, producer only
+        void publish() {
+            back = pending.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+        }
+
+        // Replaces the front slot with the last published one, if any. Consumer only, returns false if nothing
+        // was published since the last call.
+        bool acquire() {
+            if (!(pending.load(std::memory_order_relaxed) & FRESH)) { return false; }
+            front = pending.exchange(front, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        // Slot read by the consumer, unchanged until the next acquire()
+        const T& getFront() const { return slots[front]; }
+
+    private:
+        static constexpr std::uint32_t INDEX{3};
+        static constexpr std::uint32_t FRESH{4};
+
+        std::array<T, 3>           slots{};
+        std::uint32_t              back{0};
+        std::atomic<std::uint32_t> pending{1};
+        std::uint32_t              front{2};
+    };
+
+}
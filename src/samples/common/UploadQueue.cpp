@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.uploadqueue;
+
+namespace samples {
+
+    void UploadQueue::onInit(const std::shared_ptr<vireo::Vireo>& vireo, const std::uint32_t framesInFlight) {
+        this->vireo = vireo;
+        this->framesInFlight = framesInFlight;
+        transferQueue = vireo->createSubmitQueue(vireo::CommandType::TRANSFER, "Uploads");
+        commandAllocator = vireo->createCommandAllocator(vireo::CommandType::TRANSFER);
+        commandList = commandAllocator->createCommandList();
+        semaphore = vireo->createSemaphore(vireo::SemaphoreType::TIMELINE, "Uploads timeline");
+        commandList->begin();
+    }
+
+    void UploadQueue::acquire(const std::shared_ptr<vireo::Image>& image) {
+        images.push_back(image);
+    }
+
+    void UploadQueue::submit() {
+        commandList->end();
+        transferQueue->submit(vireo::WaitStage::TRANSFER, semaphore, {commandList});
+    }
+
+    void UploadQueue::onRender(const std::shared_ptr<vireo::SubmitQueue>& graphicQueue) {
+        frameCount += 1;
+        if (frameCount == 1) {
+            acquireCommandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
+            acquireCommandList = acquireCommandAllocator->createCommandList();
+            acquireCommandList->begin();
+            for (const auto& image : images) {
+                acquireCommandList->barrier(image, vireo::ResourceState::COPY_DST, vireo::ResourceState::SHADER_READ);
+            }
+            acquireCommandList->end();
+            // The barriers, and all the next commands of the graphic queue, run after the copies
+            graphicQueue->submit(
+                semaphore,
+                vireo::WaitStage::TRANSFER,
+                vireo::WaitStage::TRANSFER,
+                semaphore,
+                {acquireCommandList});
+        } else if (frameCount == framesInFlight + 1) {
+            // The fence of the first frame was waited for by the swap chain
+            release();
+        }
+    }
+
+    void UploadQueue::onDestroy() {
+        transferQueue->waitIdle();
+        release();
+    }
+
+    void UploadQueue::release() {
+        stagingBuffers.clear();
+        images.clear();
+        commandList.reset();
+        commandAllocator.reset();
+        acquireCommandList.reset();
+        acquireCommandAllocator.reset();
+    }
+
+}
@@ -0,0 +1,54 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.uploadqueue;
+
+import std;
+import vireo;
+
+export namespace samples {
+
+    // Startup uploads on a dedicated transfer queue, submitted without waiting so they overlap the pipelines creation.
+    // The copied images are left in COPY_DST by the transfer queue : they are acquired by the graphic queue,
+    // transitioned to SHADER_READ after a GPU wait on the timeline semaphore signaled by the copies,
+    // submitted by the first frame before its command lists.
+    class UploadQueue {
+    public:
+        void onInit(const std::shared_ptr<vireo::Vireo>& vireo, std::uint32_t framesInFlight);
+
+        // Records the copies until submit()
+        const auto& getCommandList() const { return commandList; }
+
+        // Kept until the copies are done
+        auto& getStagingBuffers() { return stagingBuffers; }
+
+        // Image copied by the command list and sampled by the frames
+        void acquire(const std::shared_ptr<vireo::Image>& image);
+
+        void submit();
+
+        // Called by each frame before submitting its command lists
+        void onRender(const std::shared_ptr<vireo::SubmitQueue>& graphicQueue);
+
+        void onDestroy();
+
+    private:
+        std::shared_ptr<vireo::Vireo>               vireo;
+        std::shared_ptr<vireo::SubmitQueue>         transferQueue;
+        std::shared_ptr<vireo::CommandAllocator>    commandAllocator;
+        std::shared_ptr<vireo::CommandList>         commandList;
+        std::shared_ptr<vireo::CommandAllocator>    acquireCommandAllocator;
+        std::shared_ptr<vireo::CommandList>         acquireCommandList;
+        std::shared_ptr<vireo::Semaphore>           semaphore;
+        std::vector<std::shared_ptr<vireo::Buffer>> stagingBuffers;
+        std::vector<std::shared_ptr<vireo::Image>>  images;
+        std::uint32_t                               framesInFlight{0};
+        std::uint64_t                               frameCount{0};
+
+        void release();
+    };
+
+}
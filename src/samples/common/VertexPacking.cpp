@@ -0,0 +1,68 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module;
+#include <glm/gtc/packing.hpp>
+module samples.common.vertexpacking;
+
+namespace samples {
+
+    std::vector<PackedVertex> packVertices(
+        const std::vector<Vertex>& vertices,
+        VertexQuantization& quantization,
+        const std::vector<float>& bitangentSigns) {
+        quantization = getVertexQuantization(vertices);
+        auto packed = std::vector<PackedVertex>(vertices.size());
+        for (auto i = std::size_t{0}; i < vertices.size(); i++) {
+            packed[i] = packVertex(vertices[i], quantization, bitangentSigns.empty() ? 1.0f : bitangentSigns[i]);
+        }
+        return packed;
+    }
+
+    PackedVertex packVertex(const Vertex& vertex, const VertexQuantization& quantization, const float bitangentSign) {
+        const auto position = (vertex.position - glm::vec3(quantization.positionOffset)) / glm::vec3(quantization.positionScale);
+
+        // https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/
+        const auto n = vertex.normal / (std::abs(vertex.normal.x) + std::abs(vertex.normal.y) + std::abs(vertex.normal.z));
+        auto octahedral = glm::vec2{n.x, n.y};
+        if (n.z < 0.0f) {
+            octahedral = (1.0f - glm::abs(glm::vec2{n.y, n.x})) * glm::vec2{
+                n.x >= 0.0f ? 1.0f : -1.0f,
+                n.y >= 0.0f ? 1.0f : -1.0f};
+        }
+
+        return {
+            .position = {
+                glm::packUnorm2x16(glm::vec2{position.x, position.y}),
+                glm::packUnorm2x16(glm::vec2{position.z, 0.0f})},
+            .normal  = glm::packSnorm2x16(octahedral),
+            .uv      = glm::packHalf2x16(vertex.uv),
+            .tangent = glm::packSnorm3x10_1x2(glm::vec4{glm::normalize(vertex.tangent), bitangentSign}),
+        };
+    }
+
+    VertexQuantization getVertexQuantization(const std::vector<Vertex>& vertices) {
+        if (vertices.empty()) {
+            return {};
+        }
+        auto min = glm::vec3{std::numeric_limits<float>::max()};
+        auto max = glm::vec3{std::numeric_limits<float>::lowest()};
+        for (const auto& vertex : vertices) {
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
+        }
+        const auto size = max - min;
+        return {
+            .positionOffset = glm::vec4{min, 0.0f},
+            .positionScale  = glm::vec4{
+                size.x > 0.0f ? size.x : 1.0f,
+                size.y > 0.0f ? size.y : 1.0f,
+                size.z > 0.0f ? size.z : 1.0f,
+                0.0f},
+        };
+    }
+
+}
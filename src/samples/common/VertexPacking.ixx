@@ -0,0 +1,26 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.vertexpacking;
+
+import std;
+import glm;
+import samples.common.global;
+
+export namespace samples {
+
+    // Quantizes the positions in the bounds of the mesh and packs the other attributes.
+    // Without bitangent signs the shaders default of cross(normal, tangent) is used.
+    std::vector<PackedVertex> packVertices(
+        const std::vector<Vertex>& vertices,
+        VertexQuantization& quantization,
+        const std::vector<float>& bitangentSigns = {});
+
+    PackedVertex packVertex(const Vertex& vertex, const VertexQuantization& quantization, float bitangentSign = 1.0f);
+
+    VertexQuantization getVertexQuantization(const std::vector<Vertex>& vertices);
+
+}
@@ -0,0 +1,173 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module samples.common.workerpool;
+
+namespace samples {
+
+    namespace {
+
+        // Pool and deque of the worker thread
+        thread_local const WorkerPool* currentPool{nullptr};
+        thread_local std::uint32_t     currentQueue{0};
+
+    }
+
+    WorkerPool::WorkerPool(const std::uint32_t threadCount) :
+        queues{std::make_unique<Queue[]>(threadCount + 1)},
+        queueCount{threadCount + 1} {
+        for (auto i = 0u; i < threadCount; i++) {
+            threads.emplace_back(&WorkerPool::worker, this, i);
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        quit = true;
+        events.fetch_add(1);
+        events.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::parallelFor(
+        const std::size_t count,
+        const std::size_t batchSize,
+        const std::function<void(std::size_t, std::size_t)>& function) {
+        if (count == 0) { return; }
+        const auto batches = (count + batchSize - 1) / batchSize;
+        if (threads.empty() || batches == 1) {
+            function(0, count);
+            return;
+        }
+        auto nextBatch = std::atomic<std::size_t>{0};
+        const auto runBatches = [&] {
+            while (true) {
+                const auto batch = nextBatch.fetch_add(1);
+                if (batch >= batches) { return; }
+                const auto begin = batch * batchSize;
+                function(begin, std::min(begin + batchSize, count));
+            }
+        };
+        // One job per helper, the batches are shared : a late helper finds no batch left
+        auto counter = Counter{};
+        const auto helpers = std::min(batches - 1, threads.size());
+        for (auto i = 0uz; i < helpers; i++) {
+            submit(runBatches, &counter);
+        }
+        runBatches();
+        wait(counter);
+    }
+
+    void WorkerPool::submit(std::function<void()> job, Counter* counter) {
+        add(counter);
+        push({std::move(job), counter});
+    }
+
+    void WorkerPool::submitAfter(Counter& dependency, std::function<void()> job, Counter* counter) {
+        add(counter);
+        {
+            auto lock = std::lock_guard{dependency.mutex};
+            if (!dependency.isDone()) {
+                dependency.continuations.push_back({std::move(job), counter});
+                return;
+            }
+        }
+        push({std::move(job), counter});
+    }
+
+    void WorkerPool::wait(Counter& counter) {
+        const auto queue = getQueue();
+        // Only the jobs of the counter are run, a long unrelated job would delay the caller.
+        // Without workers nobody else runs the jobs the counter may depend on.
+        const auto only = threads.empty() || &counter == &allJobs ? nullptr : &counter;
+        while (!counter.isDone()) {
+            const auto seen = events.load();
+            if (runNext(queue, only)) { continue; }
+            if (counter.isDone()) { break; }
+            events.wait(seen);
+        }
+        // The thread of the last job may still hold the mutex
+        auto lock = std::lock_guard{counter.mutex};
+    }
+
+    void WorkerPool::worker(const std::uint32_t index) {
+        currentPool = this;
+        currentQueue = index;
+        while (!quit) {
+            const auto seen = events.load();
+            if (runNext(index)) { continue; }
+            if (quit) { return; }
+            events.wait(seen);
+        }
+    }
+
+    std::uint32_t WorkerPool::getQueue() const {
+        return currentPool == this ? currentQueue : queueCount - 1;
+    }
+
+    void WorkerPool::push(Job job) {
+        auto& queue = queues[getQueue()];
+        {
+            auto lock = std::lock_guard{queue.mutex};
+            queue.jobs.push_back(std::move(job));
+        }
+        events.fetch_add(1);
+        events.notify_one();
+    }
+
+    bool WorkerPool::runNext(const std::uint32_t queue, const Counter* counter) {
+        auto job = Job{};
+        const auto matches = [counter](const Job& candidate) {
+            return !counter || candidate.counter == counter;
+        };
+        // Newest job of the own deque first, for locality, then the oldest job of the others
+        for (auto i = 0u; i < queueCount && !job.function; i++) {
+            auto& victim = queues[(queue + i) % queueCount];
+            auto lock = std::lock_guard{victim.mutex};
+            if (i == 0) {
+                const auto it = std::find_if(victim.jobs.rbegin(), victim.jobs.rend(), matches);
+                if (it == victim.jobs.rend()) { continue; }
+                job = std::move(*it);
+                victim.jobs.erase(std::next(it).base());
+            } else {
+                const auto it = std::find_if(victim.jobs.begin(), victim.jobs.end(), matches);
+                if (it == victim.jobs.end()) { continue; }
+                job = std::move(*it);
+                victim.jobs.erase(it);
+            }
+        }
+        if (!job.function) { return false; }
+        job.function();
+        if (job.counter) {
+            finish(*job.counter);
+        }
+        finish(allJobs);
+        return true;
+    }
+
+    void WorkerPool::add(Counter* counter) {
+        if (counter) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        allJobs.pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void WorkerPool::finish(Counter& counter) {
+        auto ready = std::vector<Job>{};
+        {
+            auto lock = std::lock_guard{counter.mutex};
+            if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) != 1) { return; }
+            ready.swap(counter.continuations);
+        }
+        for (auto& job : ready) {
+            push(std::move(job));
+        }
+        events.fetch_add(1);
+        events.notify_all();
+    }
+
+}
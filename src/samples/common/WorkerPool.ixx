@@ -0,0 +1,95 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module samples.common.workerpool;
+
+import std;
+
+export namespace samples {
+
+    // Work-stealing job scheduler. Each worker thread owns a deque : it pushes and pops its own jobs at the back
+    // and steals from the front of the other deques when its deque is empty. The jobs submitted by the other
+    // threads go to a shared deque. The threads waiting for jobs run the queued jobs instead of blocking.
+    class WorkerPool {
+        struct Job;
+
+    public:
+        // Jobs of a group not done yet, waited for with wait() or used as a dependency by submitAfter().
+        // A counter must be waited for before being destroyed.
+        class Counter {
+        public:
+            bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+        private:
+            friend class WorkerPool;
+            std::atomic<std::uint32_t> pending{0};
+            std::mutex                 mutex;
+            // Jobs submitted with submitAfter(), queued when the counter reaches zero
+            std::vector<Job>           continuations;
+        };
+
+        explicit WorkerPool(std::uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1);
+        ~WorkerPool();
+
+        // Calls function(begin, end) on batches of [0, count[ and returns when all the batches are done.
+        // The batches are taken one at a time by the calling thread and by the workers stealing the loop.
+        void parallelFor(
+            std::size_t count,
+            std::size_t batchSize,
+            const std::function<void(std::size_t, std::size_t)>& function);
+
+        // Queues a job, counted by counter if not null. The jobs must not throw.
+        void submit(std::function<void()> job, Counter* counter = nullptr);
+
+        // Queues a job once all the jobs of dependency are done, counted by counter if not null
+        void submitAfter(Counter& dependency, std::function<void()> job, Counter* counter = nullptr);
+
+        // Returns when all the jobs of the counter are done, the calling thread runs the queued jobs of the
+        // counter meanwhile. The other jobs are left to the workers, except in a pool without workers.
+        void wait(Counter& counter);
+
+        // Returns when all the submitted jobs are done, the calling thread runs queued jobs meanwhile
+        void wait() { wait(allJobs); }
+
+        auto getThreadCount() const { return static_cast<std::uint32_t>(threads.size() + 1); }
+
+    private:
+        struct Job {
+            std::function<void()> function;
+            Counter*              counter{nullptr};
+        };
+
+        struct Queue {
+            std::mutex      mutex;
+            std::deque<Job> jobs;
+        };
+
+        std::vector<std::thread>   threads;
+        // One deque per worker followed by the shared deque
+        std::unique_ptr<Queue[]>   queues;
+        std::uint32_t              queueCount{0};
+        Counter                    allJobs;
+        // Incremented when a job is queued or a counter is done, waited for by the idle threads
+        std::atomic<std::uint32_t> events{0};
+        std::atomic<bool>          quit{false};
+
+        void worker(std::uint32_t index);
+
+        // Deque of the calling thread
+        std::uint32_t getQueue() const;
+
+        void push(Job job);
+
+        // Runs a job of the deque or a stolen one, only a job of counter if not null.
+        // Returns false if no such job is queued.
+        bool runNext(std::uint32_t queue, const Counter* counter = nullptr);
+
+        void add(Counter* counter);
+
+        void finish(Counter& counter);
+    };
+
+}
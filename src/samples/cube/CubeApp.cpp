@@ -10,39 +10,44 @@ module samples.cube;
 namespace samples {
 
     void CubeApp::onUpdate() {
-        scene.onUpdate(swapChain->getExtent());
-        skybox.onUpdate(scene);
-        postProcessing.onUpdate();
+        scene.onUpdate(extent.load());
     }
 
     void CubeApp::onKeyDown(const std::uint32_t key) {
         const auto keyCode = static_cast<KeyScanCodes>(key);
-        graphicQueue->waitIdle();
         scene.onKeyDown(keyCode);
     }
 
     void CubeApp::onInit() {
+        pipelineCache.onInit(vireo, workerPool, backend);
         graphicQueue = vireo->createSubmitQueue(vireo::CommandType::GRAPHIC);
         swapChain = vireo->createSwapChain(
             RENDER_FORMAT,
             graphicQueue,
             windowHandle,
             vireo::PresentMode::VSYNC);
+        extent = swapChain->getExtent();
+        renderThreadEnabled = true;
 
         samplers.onInit(vireo);
 
-        auto stagingBuffers = std::vector<std::shared_ptr<vireo::Buffer>>();
-        const auto uploadCommandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
-        const auto uploadCommandList = uploadCommandAllocator->createCommandList();
-        uploadCommandList->begin();
-        scene.onInit(vireo, uploadCommandList, stagingBuffers, swapChain->getExtent());
-        depthPrepass.onInit(vireo, scene, false, swapChain->getFramesInFlight());
-        skybox.onInit(vireo, uploadCommandList, RENDER_FORMAT, depthPrepass, samplers, swapChain->getFramesInFlight());
-        uploadCommandList->end();
-        graphicQueue->submit({uploadCommandList});
-
-        colorPass.onInit(vireo, RENDER_FORMAT, scene, depthPrepass, samplers, swapChain->getFramesInFlight());
-        postProcessing.onInit(vireo, RENDER_FORMAT, samplers, swapChain->getFramesInFlight());
+        uploadQueue.onInit(vireo, swapChain->getFramesInFlight());
+        scene.onInit(
+            vireo,
+            workerPool,
+            uploadQueue,
+            graphicQueue,
+            swapChain->getExtent(),
+            swapChain->getFramesInFlight());
+        // The pipelines are created by worker threads while the uploads are recorded and copied by the transfer queue
+        depthPrepass.onInit(vireo, pipelineCache, scene, false, swapChain->getFramesInFlight());
+        colorPass.onInit(vireo, pipelineCache, RENDER_FORMAT, scene, depthPrepass, samplers, swapChain->getFramesInFlight());
+        postProcessing.onInit(vireo, pipelineCache, RENDER_FORMAT, samplers, swapChain->getFramesInFlight());
+        skybox.onInit(vireo, pipelineCache, scene.getGeometry(), uploadQueue, scene.getAssetLoader(), RENDER_FORMAT, depthPrepass, samplers, swapChain->getFramesInFlight());
+        // All the meshes are in the arena
+        scene.getGeometry().flush(uploadQueue.getCommandList());
+        // The first frame waits for the copies on the GPU
+        uploadQueue.submit();
 
         framesData.resize(swapChain->getFramesInFlight());
         for (auto& frame : framesData) {
@@ -51,8 +56,8 @@ namespace samples {
             frame.inFlightFence =vireo->createFence(true);
             frame.semaphore = vireo->createSemaphore(vireo::SemaphoreType::TIMELINE, "Main timeline");
         }
-        graphicQueue->waitIdle();
-        stagingBuffers.clear();
+        pipelineCache.wait();
+        pipelineCache.onStartupDone();
     }
 
     void CubeApp::onRender() {
@@ -60,6 +65,10 @@ namespace samples {
         const auto& frame = framesData[frameIndex];
 
         if (!swapChain->acquire(frame.inFlightFence)) { return; }
+        uploadQueue.onRender(graphicQueue);
+        scene.onRender(frameIndex);
+        skybox.onUpdate(scene);
+        postProcessing.onUpdate();
 
         depthPrepass.onRender(
             frameIndex,
@@ -130,12 +139,16 @@ namespace samples {
             {cmdList});
         swapChain->present();
         swapChain->nextFrameIndex();
+        DescriptorCache::endFrame();
+        CommandState::endFrame();
+        CachedCommandList::endFrame();
         frame.semaphore->incrementValue();
     }
 
     void CubeApp::onResize() {
         swapChain->recreate();
         const auto extent = swapChain->getExtent();
+        this->extent = extent;
         for (auto& frame : framesData) {
             frame.colorBuffer = vireo->createRenderTarget(
                 swapChain,
@@ -145,11 +158,16 @@ namespace samples {
         }
         depthPrepass.onResize(extent);
         postProcessing.onResize(extent);
+        skybox.onResize();
     }
 
     void CubeApp::onDestroy() {
+        // The retired images of the scene can still be used by the frames in flight
         graphicQueue->waitIdle();
         swapChain->waitIdle();
+        scene.onDestroy();
+        uploadQueue.onDestroy();
+        pipelineCache.onDestroy();
     }
 
 }
\ No newline at end of file
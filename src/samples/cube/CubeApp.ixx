@@ -9,12 +9,18 @@ export module samples.cube;
 import std;
 import vireo;
 import samples.app;
+import samples.common.cachedcommandlist;
+import samples.common.commandstate;
+import samples.common.descriptorcache;
 import samples.common.global;
 import samples.common.depthprepass;
 import samples.common.scene;
 import samples.common.skybox;
+import samples.common.pipelinecache;
 import samples.common.postprocessing;
 import samples.common.samplers;
+import samples.common.uploadqueue;
+import samples.common.workerpool;
 import samples.cube.colorpass;
 
 export namespace samples {
@@ -37,14 +43,21 @@ export namespace samples {
             std::shared_ptr<vireo::Semaphore>    semaphore;
         };
 
+        // Shared by the simulation, the assets loading and the pipelines creation. Declared first, destroyed last.
+        // At least one worker for the assets loading
+        WorkerPool                          workerPool{std::max(2u, std::thread::hardware_concurrency()) - 1};
         Scene                               scene;
         DepthPrepass                        depthPrepass;
         Skybox                              skybox;
         ColorPass                           colorPass;
         PostProcessing                      postProcessing;
         Samplers                            samplers;
+        PipelineCache                       pipelineCache;
+        UploadQueue                         uploadQueue;
         std::vector<FrameData>              framesData;
         std::shared_ptr<vireo::SwapChain>   swapChain;
         std::shared_ptr<vireo::SubmitQueue> graphicQueue;
+        // Written by the render thread on resize, read by the simulation
+        std::atomic<vireo::Extent>          extent;
     };
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ namespace samples {
 
     void ColorPass::onInit(
         const std::shared_ptr<vireo::Vireo>& vireo,
+        PipelineCache& pipelineCache,
         const vireo::ImageFormat renderFormat,
         const Scene& scene,
         const DepthPrepass& depthPrepass,
@@ -18,50 +19,55 @@ namespace samples {
         const std::uint32_t framesInFlight) {
         this->vireo = vireo;
 
-        modelsDescriptorLayout = vireo->createDynamicUniformDescriptorLayout();
-        materialsDescriptorLayout = vireo->createDynamicUniformDescriptorLayout();
+        constantsDescriptorLayout = vireo->createDynamicUniformDescriptorLayout();
 
         descriptorLayout = vireo->createDescriptorLayout();
         descriptorLayout->add(BINDING_GLOBAL, vireo::DescriptorType::UNIFORM);
         descriptorLayout->add(BINDING_LIGHT, vireo::DescriptorType::UNIFORM);
-        descriptorLayout->add(BINDING_TEXTURES, vireo::DescriptorType::SAMPLED_IMAGE, scene.getTextures().size());
+        descriptorLayout->add(BINDING_VERTICES, vireo::DescriptorType::STORAGE);
         descriptorLayout->build();
 
         pipelineConfig.colorRenderFormats.push_back(renderFormat);
         pipelineConfig.depthStencilImageFormat = depthPrepass.getFormat();
         pipelineConfig.resources = vireo->createPipelineResources({
-            descriptorLayout, samplers.getDescriptorLayout(), modelsDescriptorLayout, materialsDescriptorLayout });
-        pipelineConfig.vertexInputLayout = vireo->createVertexLayout(sizeof(Vertex), vertexAttributes);
-        pipelineConfig.vertexShader = vireo->createShaderModule("shaders/cube_color_mvp.vert");
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/cube_color_mvp.frag");
-        pipeline = vireo->createGraphicPipeline(pipelineConfig);
+            descriptorLayout,
+            samplers.getDescriptorLayout(),
+            constantsDescriptorLayout,
+            constantsDescriptorLayout,
+            scene.getResourceHeap().getDescriptorLayout() },
+            pushConstantsDesc);
+        const auto shaderName = std::string{scene.usePackedVertices ? "shaders/cube_color_mvp_packed" : "shaders/cube_color_mvp"};
+        // The materials with the same features share their pipeline
+        pipelines.resize(scene.getMaterials().size());
+        for (auto i = 0u; i < scene.getMaterials().size(); i++) {
+            const auto features = getMaterialFeatures(scene.getMaterials()[i]);
+            pipelineCache.declareGraphicPipeline(
+                pipelines[i], pipelineConfig,
+                PipelineCache::getPermutation(shaderName + ".vert", features),
+                PipelineCache::getPermutation(shaderName + ".frag", features));
+        }
 
-        framesData.resize(framesInFlight);
-        for (auto& frame : framesData) {
-            frame.globalUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Global));
-            frame.modelUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Model), scene.getModels().size());
-            frame.materialUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Material), scene.getMaterials().size());
-            frame.lightUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Light), 1);
+        constants.onInit(
+            vireo,
+            std::max(sizeof(Model), sizeof(Material)),
+            static_cast<std::uint32_t>(scene.getMaterials().size() + scene.getModels().size()),
+            framesInFlight,
+            "Constants");
+        for (auto i = 0u; i < scene.getMaterials().size(); i++) {
+            materialBlocks.push_back(constants.reserve());
+        }
 
+        framesData.resize(framesInFlight);
+        for (auto i = 0u; i < framesInFlight; i++) {
+            auto& frame = framesData[i];
             frame.descriptorSet = vireo->createDescriptorSet(descriptorLayout);
-            frame.descriptorSet->update(BINDING_GLOBAL, frame.globalUniform);
-            frame.descriptorSet->update(BINDING_LIGHT, frame.lightUniform);
-            frame.descriptorSet->update(BINDING_TEXTURES, scene.getTextures());
-            frame.modelsDescriptorSet = vireo->createDescriptorSet(modelsDescriptorLayout);
-            frame.modelsDescriptorSet->update(frame.modelUniform, false);
-            frame.materialsDescriptorSet = vireo->createDescriptorSet(materialsDescriptorLayout);
-            frame.materialsDescriptorSet->update(frame.materialUniform, false);
-
-            frame.globalUniform->map();
-            frame.modelUniform->map();
-            frame.materialUniform->map();
-            frame.materialUniform->write(scene.getMaterials().data());
-            frame.materialUniform->unmap();
-            frame.lightUniform->map();
-            auto light = scene.getLight();
-            frame.lightUniform->write(&light);
-            frame.lightUniform->unmap();
-
+            frame.descriptorSet->update(BINDING_GLOBAL, scene.getGlobalBuffer(i));
+            frame.descriptorSet->update(BINDING_LIGHT, scene.getLightBuffer(i));
+            frame.descriptorSet->update(BINDING_VERTICES, scene.getGeometry().getVertexBuffer());
+            frame.modelsDescriptorSet = vireo->createDescriptorSet(constantsDescriptorLayout);
+            frame.modelsDescriptorSet->update(constants.getBuffer(i), false);
+            frame.materialsDescriptorSet = vireo->createDescriptorSet(constantsDescriptorLayout);
+            frame.materialsDescriptorSet->update(constants.getBuffer(i), false);
         }
     }
 
@@ -73,10 +79,9 @@ namespace samples {
        const Samplers& samplers,
        const std::shared_ptr<vireo::CommandList>& cmdList,
        const std::shared_ptr<vireo::RenderTarget>& colorBuffer) {
-        const auto& frame = framesData[frameIndex];
+        auto& frame = framesData[frameIndex];
 
-        frame.globalUniform->write(&scene.getGlobal());
-        frame.modelUniform->write(scene.getModels().data());
+        constants.reset(frameIndex);
 
         renderingConfig.colorRenderTargets[0].renderTarget = colorBuffer;
         renderingConfig.depthStencilRenderTarget = depthPrepass.getDepthBuffer(frameIndex);
@@ -88,25 +93,31 @@ namespace samples {
         cmdList->setScissors(vireo::Rect{
             extent.width,
             extent.height});
-        cmdList->bindPipeline(pipeline);
-        cmdList->bindDescriptor(frame.descriptorSet, SET_GLOBAL);
-        cmdList->bindDescriptor(samplers.getDescriptorSet(), SET_SAMPLERS);
-
-        cmdList->bindDescriptor(
-            frame.materialsDescriptorSet, SET_MATERIALS,
-            frame.materialUniform->getInstanceSizeAligned() * Scene::MATERIAL_ROCKS);
-        cmdList->bindDescriptor(
-            frame.modelsDescriptorSet, SET_MODELS,
-            frame.modelUniform->getInstanceSizeAligned() * Scene::MODEL_OPAQUE);
-        scene.drawCube(cmdList);
-
-        cmdList->bindDescriptor(
-            frame.materialsDescriptorSet, SET_MATERIALS,
-            frame.materialUniform->getInstanceSizeAligned() * Scene::MATERIAL_GRID);
-        cmdList->bindDescriptor(
-            frame.modelsDescriptorSet, SET_MODELS,
-            frame.modelUniform->getInstanceSizeAligned() * Scene::MODEL_TRANSPARENT);
-        scene.drawCube(cmdList);
+        commandState.begin(cmdList);
+
+        for (const auto& [modelIndex, materialIndex] : {
+            std::pair{Scene::MODEL_OPAQUE, Scene::MATERIAL_ROCKS},
+            std::pair{Scene::MODEL_TRANSPARENT, Scene::MATERIAL_GRID}}) {
+            if (!scene.isVisible(modelIndex)) { continue; }
+            // The descriptors and the push constants are only bound again with another pipeline
+            if (commandState.bindPipeline(pipelines[materialIndex])) {
+                cmdList->pushConstants(pipelineConfig.resources, pushConstantsDesc, &scene.getVertexQuantization());
+            }
+            commandState.bindDescriptor(frame.descriptorSet, SET_GLOBAL);
+            commandState.bindDescriptor(samplers.getDescriptorSet(), SET_SAMPLERS);
+            commandState.bindDescriptor(scene.getResourceHeap().getDescriptorSet(frameIndex), SET_RESOURCES);
+            commandState.bindDescriptor(
+                frame.materialsDescriptorSet, SET_MATERIALS,
+                constants.writeStatic(
+                    frameIndex,
+                    materialBlocks[materialIndex],
+                    &scene.getMaterials()[materialIndex],
+                    sizeof(Material)));
+            commandState.bindDescriptor(
+                frame.modelsDescriptorSet, SET_MODELS,
+                constants.allocate(frameIndex, &scene.getModels()[modelIndex], sizeof(Model)));
+            scene.drawCube(commandState);
+        }
 
         cmdList->endRendering();
     }
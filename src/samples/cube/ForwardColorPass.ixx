@@ -4,14 +4,15 @@
 * This software is released under the MIT License.
 * https://opensource.org/licenses/MIT
 */
-module;
-#include <cstddef>
 export module samples.cube.colorpass;
 
 import std;
 import vireo;
+import samples.common.commandstate;
+import samples.common.constantallocator;
 import samples.common.global;
 import samples.common.depthprepass;
+import samples.common.pipelinecache;
 import samples.common.scene;
 import samples.common.samplers;
 
@@ -20,6 +21,7 @@ export namespace samples {
     public:
         void onInit(
            const std::shared_ptr<vireo::Vireo>& vireo,
+           PipelineCache& pipelineCache,
            vireo::ImageFormat renderFormat,
            const Scene& scene,
            const DepthPrepass& depthPrepass,
@@ -38,10 +40,6 @@ export namespace samples {
 
     private:
         struct FrameData {
-            std::shared_ptr<vireo::Buffer>        globalUniform;
-            std::shared_ptr<vireo::Buffer>        modelUniform;
-            std::shared_ptr<vireo::Buffer>        materialUniform;
-            std::shared_ptr<vireo::Buffer>        lightUniform;
             std::shared_ptr<vireo::DescriptorSet> descriptorSet;
             std::shared_ptr<vireo::DescriptorSet> modelsDescriptorSet;
             std::shared_ptr<vireo::DescriptorSet> materialsDescriptorSet;
@@ -51,17 +49,17 @@ export namespace samples {
         static constexpr vireo::DescriptorIndex SET_SAMPLERS{1};
         static constexpr vireo::DescriptorIndex SET_MODELS{2};
         static constexpr vireo::DescriptorIndex SET_MATERIALS{3};
+        static constexpr vireo::DescriptorIndex SET_RESOURCES{4};
 
         static constexpr vireo::DescriptorIndex BINDING_GLOBAL{0};
         static constexpr vireo::DescriptorIndex BINDING_LIGHT{1};
-        static constexpr vireo::DescriptorIndex BINDING_TEXTURES{2};
+        static constexpr vireo::DescriptorIndex BINDING_VERTICES{2};
 
-        const std::vector<vireo::VertexAttributeDesc> vertexAttributes{
-                {"POSITION", vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, position) },
-                {"NORMAL",   vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, normal)},
-                {"UV",       vireo::AttributeFormat::R32G32_FLOAT,    offsetof(Vertex, uv)},
-                {"TANGENT",  vireo::AttributeFormat::R32G32B32_FLOAT,   offsetof(Vertex, tangent)},
+        static constexpr auto pushConstantsDesc = vireo::PushConstantsDesc {
+            .stage = vireo::ShaderStage::VERTEX,
+            .size = sizeof(VertexQuantization),
         };
+
         vireo::GraphicPipelineConfiguration pipelineConfig {
             .colorBlendDesc   = { { .blendEnable = true } },
             .depthTestEnable  = true,
@@ -77,9 +75,13 @@ export namespace samples {
 
         std::vector<FrameData>                   framesData;
         std::shared_ptr<vireo::Vireo>            vireo;
-        std::shared_ptr<vireo::Pipeline>         pipeline;
+        // Shader permutation of each material
+        std::vector<std::shared_ptr<vireo::Pipeline>> pipelines;
         std::shared_ptr<vireo::DescriptorLayout> descriptorLayout;
-        std::shared_ptr<vireo::DescriptorLayout> modelsDescriptorLayout;
-        std::shared_ptr<vireo::DescriptorLayout> materialsDescriptorLayout;
+        std::shared_ptr<vireo::DescriptorLayout> constantsDescriptorLayout;
+        // Models and materials, bound with dynamic offsets
+        ConstantAllocator                        constants;
+        std::vector<std::uint32_t>               materialBlocks;
+        CommandState                             commandState;
     };
 }
\ No newline at end of file
@@ -12,53 +12,64 @@ import samples.common.global;
 namespace samples {
 
     void DeferredApp::onUpdate() {
-        scene.onUpdate(swapChain->getExtent());
-        skybox.onUpdate(scene);
-        postProcessing.onUpdate();
+        scene.onUpdate(extent.load());
     }
 
     void DeferredApp::onKeyDown(const std::uint32_t key) {
         const auto keyCode = static_cast<KeyScanCodes>(key);
-        graphicQueue->waitIdle();
+        if (keyCode == KeyScanCodes::I) {
+            scene.toggleStressMode();
+            return;
+        }
         scene.onKeyDown(keyCode);
     }
 
     void DeferredApp::onInit() {
+        pipelineCache.onInit(vireo, workerPool, backend);
         graphicQueue = vireo->createSubmitQueue(vireo::CommandType::GRAPHIC, "MainQueue");
         swapChain = vireo->createSwapChain(
             RENDER_FORMAT,
             graphicQueue,
             windowHandle,
             vireo::PresentMode::VSYNC);
+        extent = swapChain->getExtent();
+        renderThreadEnabled = true;
 
         samplers.onInit(vireo);
         postProcessing.applyTAA = true;
 
-        auto stagingBuffers = std::vector<std::shared_ptr<vireo::Buffer>>();
-        const auto uploadCommandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
-        const auto uploadCommandList = uploadCommandAllocator->createCommandList();
-        uploadCommandList->begin();
-        scene.onInit(vireo, uploadCommandList, stagingBuffers, swapChain->getExtent());
-        depthPrepass.onInit(vireo, scene, true, swapChain->getFramesInFlight());
-        lightingPass.onInit(vireo, RENDER_FORMAT, scene, depthPrepass, samplers, swapChain->getFramesInFlight());
-        transparencyPass.onInit(vireo, RENDER_FORMAT, scene, depthPrepass, samplers, swapChain->getFramesInFlight());
-        skybox.onInit(vireo, uploadCommandList, RENDER_FORMAT, depthPrepass, samplers, swapChain->getFramesInFlight());
-        uploadCommandList->end();
-        graphicQueue->submit({uploadCommandList});
-
-        gbufferPass.onInit(vireo, scene, depthPrepass, samplers, swapChain->getFramesInFlight());
-        postProcessing.onInit(vireo, RENDER_FORMAT, samplers, swapChain->getFramesInFlight());
+        uploadQueue.onInit(vireo, swapChain->getFramesInFlight());
+        scene.onInit(
+            vireo,
+            workerPool,
+            uploadQueue,
+            graphicQueue,
+            swapChain->getExtent(),
+            swapChain->getFramesInFlight());
+        // The pipelines are created by worker threads while the uploads are recorded and copied by the transfer queue
+        depthPrepass.onInit(vireo, pipelineCache, scene, true, swapChain->getFramesInFlight());
+        gbufferPass.onInit(vireo, pipelineCache, scene, depthPrepass, samplers, swapChain->getFramesInFlight());
+        lightingPass.onInit(vireo, pipelineCache, RENDER_FORMAT, scene, depthPrepass, samplers, swapChain->getFramesInFlight());
+        transparencyPass.onInit(vireo, pipelineCache, RENDER_FORMAT, scene, depthPrepass, samplers, swapChain->getFramesInFlight());
+        postProcessing.onInit(vireo, pipelineCache, RENDER_FORMAT, samplers, swapChain->getFramesInFlight());
+        skybox.onInit(vireo, pipelineCache, scene.getGeometry(), uploadQueue, scene.getAssetLoader(), RENDER_FORMAT, depthPrepass, samplers, swapChain->getFramesInFlight());
+        // All the meshes are in the arena
+        scene.getGeometry().flush(uploadQueue.getCommandList());
+        // The first frame waits for the copies on the GPU
+        uploadQueue.submit();
 
         framesData.resize(swapChain->getFramesInFlight());
         for (auto& frame : framesData) {
             frame.commandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
             frame.commandList = frame.commandAllocator->createCommandList();
+            frame.postCommandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
+            frame.postCommandList = frame.postCommandAllocator->createCommandList();
             frame.inFlightFence =vireo->createFence(true);
             frame.semaphore = vireo->createSemaphore(vireo::SemaphoreType::TIMELINE, "Main timeline");
         }
 
-        graphicQueue->waitIdle();
-        stagingBuffers.clear();
+        pipelineCache.wait();
+        pipelineCache.onStartupDone();
 
         // if constexpr (vireo::isMemoryUsageEnabled()) {
         //     std::size_t totalBuffers{0};
@@ -89,6 +100,10 @@ namespace samples {
         auto& frame = framesData[frameIndex];
 
         if (!swapChain->acquire(frame.inFlightFence)) { return; }
+        uploadQueue.onRender(graphicQueue);
+        scene.onRender(frameIndex);
+        skybox.onUpdate(scene);
+        postProcessing.onUpdate();
 
         // if (frame.lastQueryPool) {
         //     const auto ticks = frame.lastQueryPool->getResults(0, 2);
@@ -123,19 +138,17 @@ namespace samples {
             frame.semaphore,
             graphicQueue);
 
-        frame.commandAllocator->reset();
-        const auto cmdList = frame.commandList;
-        cmdList->begin();
-
-        lightingPass.onRender(
+        // The lighting and the composite are recorded once and submitted again each frame
+        const auto& lightingCmdList = lightingPass.onRender(
             frameIndex,
             swapChain->getExtent(),
-            scene,
             depthPrepass,
-            gbufferPass,
             samplers,
-            cmdList,
             frame.colorBuffer);
+
+        frame.commandAllocator->reset();
+        const auto cmdList = frame.commandList;
+        cmdList->begin();
         frame.lastQueryPool = postProcessing.taaPass(
             frameIndex,
             swapChain->getExtent(),
@@ -150,13 +163,23 @@ namespace samples {
             scene,
             depthPrepass,
             samplers,
-            cmdList,
+            cmdList);
+        cmdList->end();
+
+        const auto& compositeCmdList = transparencyPass.onComposite(
+            frameIndex,
+            swapChain->getExtent(),
+            samplers,
             colorBuffer);
+
+        frame.postCommandAllocator->reset();
+        const auto postCmdList = frame.postCommandList;
+        postCmdList->begin();
         postProcessing.onRender(
             frameIndex,
             swapChain->getExtent(),
             samplers,
-            cmdList,
+            postCmdList,
             colorBuffer);
 
         // cmdList->barrier(
@@ -170,24 +193,24 @@ namespace samples {
         if (colorBuffer == nullptr) {
             colorBuffer = frame.colorBuffer;
         }
-        cmdList->barrier(
+        postCmdList->barrier(
             swapChain,
             vireo::ResourceState::UNDEFINED,
             vireo::ResourceState::COPY_DST);
-        cmdList->barrier(
+        postCmdList->barrier(
             colorBuffer,
             vireo::ResourceState::RENDER_TARGET_COLOR,
             vireo::ResourceState::COPY_SRC);
-        cmdList->copy(colorBuffer, swapChain);
-        cmdList->barrier(
+        postCmdList->copy(colorBuffer, swapChain);
+        postCmdList->barrier(
             colorBuffer,
             vireo::ResourceState::COPY_SRC,
             vireo::ResourceState::RENDER_TARGET_COLOR);
-        cmdList->barrier(
+        postCmdList->barrier(
             swapChain,
             vireo::ResourceState::COPY_DST,
             vireo::ResourceState::PRESENT);
-        cmdList->end();
+        postCmdList->end();
 
         frame.semaphore->decrementValue();
         graphicQueue->submit(
@@ -195,15 +218,19 @@ namespace samples {
             {vireo::WaitStage::FRAGMENT_SHADER, vireo::WaitStage::FRAGMENT_SHADER},
             frame.inFlightFence,
             swapChain,
-            {cmdList});
+            {lightingCmdList, cmdList, compositeCmdList, postCmdList});
         swapChain->present();
         swapChain->nextFrameIndex();
+        DescriptorCache::endFrame();
+        CommandState::endFrame();
+        CachedCommandList::endFrame();
         frame.semaphore->incrementValue();
     }
 
     void DeferredApp::onResize() {
         swapChain->recreate();
         const auto extent = swapChain->getExtent();
+        this->extent = extent;
         const auto cmdAlloc = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
         auto cmdList = cmdAlloc->createCommandList();
         cmdList->begin();
@@ -214,7 +241,9 @@ namespace samples {
         }
         depthPrepass.onResize(extent);
         postProcessing.onResize(extent);
+        skybox.onResize();
         gbufferPass.onResize(extent, cmdList);
+        lightingPass.onResize(gbufferPass);
         transparencyPass.onResize(extent, cmdList);
         cmdList->end();
         graphicQueue->submit({cmdList});
@@ -222,8 +251,12 @@ namespace samples {
     }
 
     void DeferredApp::onDestroy() {
+        // The retired images of the scene can still be used by the frames in flight
         graphicQueue->waitIdle();
         swapChain->waitIdle();
+        scene.onDestroy();
+        uploadQueue.onDestroy();
+        pipelineCache.onDestroy();
     }
 
 }
\ No newline at end of file
@@ -9,12 +9,18 @@ export module samples.deferred;
 import std;
 import vireo;
 import samples.app;
+import samples.common.cachedcommandlist;
+import samples.common.commandstate;
+import samples.common.descriptorcache;
 import samples.common.global;
 import samples.common.depthprepass;
 import samples.common.scene;
 import samples.common.skybox;
+import samples.common.pipelinecache;
 import samples.common.postprocessing;
 import samples.common.samplers;
+import samples.common.uploadqueue;
+import samples.common.workerpool;
 import samples.deferred.gbuffer;
 import samples.deferred.lightingpass;
 import samples.deferred.oitpass;
@@ -35,12 +41,18 @@ export namespace samples {
         // static constexpr auto RENDER_FORMAT = vireo::ImageFormat::B8G8R8A8_UNORM; // X11
 
         struct FrameData : FrameDataCommand {
+            // Submitted after the cached transparency composite
+            std::shared_ptr<vireo::CommandAllocator> postCommandAllocator;
+            std::shared_ptr<vireo::CommandList>      postCommandList;
             std::shared_ptr<vireo::Fence>        inFlightFence;
             std::shared_ptr<vireo::RenderTarget> colorBuffer;
             std::shared_ptr<vireo::Semaphore>    semaphore;
             std::shared_ptr<vireo::QueryPool>    lastQueryPool;
         };
 
+        // Shared by the simulation, the assets loading and the pipelines creation. Declared first, destroyed last.
+        // At least one worker for the assets loading
+        WorkerPool                          workerPool{std::max(2u, std::thread::hardware_concurrency()) - 1};
         Scene                               scene;
         DepthPrepass                        depthPrepass;
         Skybox                              skybox;
@@ -49,8 +61,12 @@ export namespace samples {
         LightingPass                        lightingPass;
         TransparencyPass                    transparencyPass;
         Samplers                            samplers;
+        PipelineCache                       pipelineCache;
+        UploadQueue                         uploadQueue;
         std::vector<FrameData>              framesData;
         std::shared_ptr<vireo::SwapChain>   swapChain;
         std::shared_ptr<vireo::SubmitQueue> graphicQueue;
+        // Written by the render thread on resize, read by the simulation
+        std::atomic<vireo::Extent>          extent;
     };
 }
\ No newline at end of file
@@ -10,6 +10,7 @@ namespace samples {
 
     void GBufferPass::onInit(
         const std::shared_ptr<vireo::Vireo>& vireo,
+        PipelineCache& pipelineCache,
         const Scene& scene,
         const DepthPrepass& depthPrepass,
         const Samplers& samplers,
@@ -18,38 +19,45 @@ namespace samples {
 
         descriptorLayout = vireo->createDescriptorLayout();
         descriptorLayout->add(BINDING_GLOBAL, vireo::DescriptorType::UNIFORM);
-        descriptorLayout->add(BINDING_MODEL, vireo::DescriptorType::UNIFORM);
-        descriptorLayout->add(BINDING_MATERIAL, vireo::DescriptorType::UNIFORM);
-        descriptorLayout->add(BINDING_TEXTURES, vireo::DescriptorType::SAMPLED_IMAGE, scene.getTextures().size());
+        descriptorLayout->add(BINDING_MODEL, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_INSTANCES, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_DRAWS, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_VERTICES, vireo::DescriptorType::STORAGE);
         descriptorLayout->build();
 
         pipelineConfig.depthStencilImageFormat = depthPrepass.getFormat();
         pipelineConfig.backStencilOpState = pipelineConfig.frontStencilOpState;
         pipelineConfig.resources = vireo->createPipelineResources(
-            { descriptorLayout, samplers.getDescriptorLayout() },
+            { descriptorLayout, samplers.getDescriptorLayout(), scene.getResourceHeap().getDescriptorLayout() },
             pushConstantsDesc);
-        pipelineConfig.vertexInputLayout = vireo->createVertexLayout(sizeof(Vertex), vertexAttributes);
-        pipelineConfig.vertexShader = vireo->createShaderModule("shaders/deferred.vert");
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/deferred_gbuffer.frag");
-        pipeline = vireo->createGraphicPipeline(pipelineConfig);
+        auto vertexShader = std::string{"shaders/deferred.vert"};
+        auto culledVertexShader = std::string{"shaders/deferred_culled.vert"};
+        if (scene.usePackedVertices) {
+            vertexShader = "shaders/deferred_packed.vert";
+            culledVertexShader = "shaders/deferred_culled_packed.vert";
+        }
+        // The fragment shader permutation of the material of each bucket
+        const auto features = scene.getBucketFeatures(Scene::BUCKET_OPAQUE);
+        const auto instancesFeatures = scene.getBucketFeatures(Scene::BUCKET_INSTANCES);
+        mergeInstances = features == instancesFeatures;
+        pipelineCache.declareGraphicPipeline(
+            pipeline, pipelineConfig,
+            vertexShader, PipelineCache::getPermutation("shaders/deferred_gbuffer.frag", features));
+        pipelineCache.declareGraphicPipeline(
+            instancesPipeline, pipelineConfig,
+            vertexShader, PipelineCache::getPermutation("shaders/deferred_gbuffer.frag", instancesFeatures));
+        pipelineCache.declareGraphicPipeline(
+            culledPipeline, pipelineConfig,
+            culledVertexShader, PipelineCache::getPermutation("shaders/deferred_gbuffer.frag", instancesFeatures));
 
         framesData.resize(framesInFlight);
-        for (auto& frame : framesData) {
+        for (auto i = 0u; i < framesInFlight; i++) {
+            auto& frame = framesData[i];
             frame.commandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
             frame.commandList = frame.commandAllocator->createCommandList();
-            frame.globalUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Global));
-            frame.globalUniform->map();
-            frame.modelUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Model) * scene.getModels().size());
-            frame.modelUniform->map();
-            frame.materialUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Material) * scene.getMaterials().size());
-            frame.materialUniform->map();
-            frame.materialUniform->write(scene.getMaterials().data());
-            frame.materialUniform->unmap();
             frame.descriptorSet = vireo->createDescriptorSet(descriptorLayout, "GBuffer");
-            frame.descriptorSet->update(BINDING_GLOBAL, frame.globalUniform);
-            frame.descriptorSet->update(BINDING_MODEL, frame.modelUniform, false);
-            frame.descriptorSet->update(BINDING_MATERIAL, frame.materialUniform, false);
-            frame.descriptorSet->update(BINDING_TEXTURES, scene.getTextures());
+            frame.descriptorSet->update(BINDING_GLOBAL, scene.getGlobalBuffer(i));
+            frame.descriptorSet->update(BINDING_VERTICES, scene.getGeometry().getVertexBuffer());
         }
     }
 
@@ -61,10 +69,22 @@ namespace samples {
         const Samplers& samplers,
         const std::shared_ptr<vireo::Semaphore>& semaphore,
         const std::shared_ptr<vireo::SubmitQueue>& graphicQueue) {
-        const auto& frame = framesData[frameIndex];
+        auto& frame = framesData[frameIndex];
 
-        frame.globalUniform->write(&scene.getGlobal());
-        frame.modelUniform->write(scene.getModels().data());
+        if (frame.modelsBuffer != scene.getModelsBuffer(frameIndex)) {
+            frame.modelsBuffer = scene.getModelsBuffer(frameIndex);
+            frame.descriptorSet->update(BINDING_MODEL, frame.modelsBuffer);
+        }
+        if (frame.drawsBuffer != scene.getDrawsBuffer(frameIndex)) {
+            frame.drawsBuffer = scene.getDrawsBuffer(frameIndex);
+            frame.descriptorSet->update(BINDING_DRAWS, frame.drawsBuffer);
+        }
+        const auto& occlusionCulling = depthPrepass.getOcclusionCulling();
+        const auto occlusion = scene.getInstanceCount() > 0 && !scene.isSoftwareOcclusionEnabled();
+        if (occlusion && frame.instancesBuffer != occlusionCulling.getListsBuffer(frameIndex)) {
+            frame.instancesBuffer = occlusionCulling.getListsBuffer(frameIndex);
+            frame.descriptorSet->update(BINDING_INSTANCES, frame.instancesBuffer);
+        }
 
         renderingConfig.colorRenderTargets[BUFFER_POSITION].renderTarget = frame.positionBuffer;
         renderingConfig.colorRenderTargets[BUFFER_NORMAL].renderTarget = frame.normalBuffer;
@@ -96,14 +116,44 @@ namespace samples {
         cmdList->setScissors(vireo::Rect{
             extent.width,
             extent.height});
-        cmdList->bindPipeline(pipeline);
+        commandState.begin(cmdList);
+        commandState.bindPipeline(pipeline);
         cmdList->setStencilReference(1);
-        cmdList->bindDescriptors({frame.descriptorSet, samplers.getDescriptorSet()});
-
-        pushConstants.modelIndex = Scene::MODEL_OPAQUE;
-        pushConstants.materialIndex = Scene::MATERIAL_ROCKS;
+        const auto& resourceHeap = scene.getResourceHeap().getDescriptorSet(frameIndex);
+        commandState.bindDescriptors({frame.descriptorSet, samplers.getDescriptorSet(), resourceHeap});
+
+        const auto range = scene.getDrawRange(
+            Scene::BUCKET_OPAQUE,
+            occlusion || !mergeInstances ? Scene::BUCKET_OPAQUE : Scene::BUCKET_INSTANCES);
+        pushConstants.firstDraw = range.first;
+        pushConstants.instanceListOffset = 0;
+        pushConstants.quantization = scene.getVertexQuantization();
         cmdList->pushConstants(pipelineConfig.resources, pushConstantsDesc, &pushConstants);
-        scene.drawCube(cmdList);
+        scene.drawCubes(commandState, range);
+
+        const auto instancesRange = scene.getDrawRange(Scene::BUCKET_INSTANCES, Scene::BUCKET_INSTANCES);
+        if (!occlusion && !mergeInstances && instancesRange.count > 0) {
+            commandState.bindPipeline(instancesPipeline);
+            cmdList->setStencilReference(1);
+            commandState.bindDescriptors({frame.descriptorSet, samplers.getDescriptorSet(), resourceHeap});
+            pushConstants.firstDraw = instancesRange.first;
+            cmdList->pushConstants(pipelineConfig.resources, pushConstantsDesc, &pushConstants);
+            scene.drawCubes(commandState, instancesRange);
+        }
+
+        if (occlusion) {
+            // Instances that passed the occlusion culling of the depth prepass
+            commandState.bindPipeline(culledPipeline);
+            cmdList->setStencilReference(1);
+            commandState.bindDescriptors({frame.descriptorSet, samplers.getDescriptorSet(), resourceHeap});
+            pushConstants.firstDraw = instancesRange.first;
+            pushConstants.instanceListOffset = occlusionCulling.getListOffset(OcclusionCulling::LIST_FINAL, frameIndex);
+            cmdList->pushConstants(pipelineConfig.resources, pushConstantsDesc, &pushConstants);
+            scene.drawInstancesIndirect(
+                commandState,
+                occlusionCulling.getCommandsBuffer(frameIndex),
+                OcclusionCulling::getCommandOffset(OcclusionCulling::LIST_FINAL));
+        }
 
         cmdList->endRendering();
         // cmdList->writeTimestamp(*pool, 1);
@@ -4,14 +4,15 @@
 * This software is released under the MIT License.
 * https://opensource.org/licenses/MIT
 */
-module;
-#include <cstddef>
 export module samples.deferred.gbuffer;
 
 import std;
 import vireo;
+import samples.common.commandstate;
 import samples.common.global;
 import samples.common.depthprepass;
+import samples.common.occlusionculling;
+import samples.common.pipelinecache;
 import samples.common.scene;
 import samples.common.samplers;
 
@@ -20,6 +21,7 @@ export namespace samples {
     public:
         void onInit(
             const std::shared_ptr<vireo::Vireo>& vireo,
+            PipelineCache& pipelineCache,
             const Scene& scene,
             const DepthPrepass& depthPrepass,
             const Samplers& samplers,
@@ -45,9 +47,9 @@ export namespace samples {
 
     private:
         struct FrameData : FrameDataCommand {
-            std::shared_ptr<vireo::Buffer>        globalUniform;
-            std::shared_ptr<vireo::Buffer>        modelUniform;
-            std::shared_ptr<vireo::Buffer>        materialUniform;
+            std::shared_ptr<vireo::Buffer>        modelsBuffer;
+            std::shared_ptr<vireo::Buffer>        instancesBuffer;
+            std::shared_ptr<vireo::Buffer>        drawsBuffer;
             std::shared_ptr<vireo::DescriptorSet> descriptorSet;
             std::shared_ptr<vireo::RenderTarget>  positionBuffer;
             std::shared_ptr<vireo::RenderTarget>  normalBuffer;
@@ -57,14 +59,16 @@ export namespace samples {
         };
 
         struct PushConstants {
-            std::uint32_t modelIndex;
-            std::uint32_t materialIndex;
+            std::uint32_t                  firstDraw;
+            std::uint32_t                  instanceListOffset;
+            alignas(16) VertexQuantization quantization;
         };
 
         static constexpr vireo::DescriptorIndex BINDING_GLOBAL{0};
         static constexpr vireo::DescriptorIndex BINDING_MODEL{1};
-        static constexpr vireo::DescriptorIndex BINDING_MATERIAL{2};
-        static constexpr vireo::DescriptorIndex BINDING_TEXTURES{3};
+        static constexpr vireo::DescriptorIndex BINDING_INSTANCES{2};
+        static constexpr vireo::DescriptorIndex BINDING_DRAWS{3};
+        static constexpr vireo::DescriptorIndex BINDING_VERTICES{4};
 
         static constexpr int BUFFER_POSITION{0};
         static constexpr int BUFFER_NORMAL{1};
@@ -76,12 +80,6 @@ export namespace samples {
             .stage = vireo::ShaderStage::ALL,
             .size = sizeof(PushConstants),
         };
-        const std::vector<vireo::VertexAttributeDesc> vertexAttributes {
-            {"POSITION", vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, position)},
-            {"NORMAL",   vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, normal)},
-            {"UV",       vireo::AttributeFormat::R32G32_FLOAT,    offsetof(Vertex, uv)},
-            {"TANGENT",  vireo::AttributeFormat::R32G32B32_FLOAT,  offsetof(Vertex, tangent)},
-        };
         vireo::GraphicPipelineConfiguration pipelineConfig {
             .colorRenderFormats  = {
                 vireo::ImageFormat::R16G16B16A16_SFLOAT, // Position
@@ -120,6 +118,11 @@ export namespace samples {
         std::vector<FrameData>                   framesData;
         std::shared_ptr<vireo::Vireo>            vireo;
         std::shared_ptr<vireo::Pipeline>         pipeline;
+        std::shared_ptr<vireo::Pipeline>         instancesPipeline;
+        std::shared_ptr<vireo::Pipeline>         culledPipeline;
+        // The opaque model and the instances use the same permutation, drawn with one call
+        bool                                     mergeInstances{true};
         std::shared_ptr<vireo::DescriptorLayout> descriptorLayout;
+        CommandState                             commandState;
     };
 }
\ No newline at end of file
@@ -10,6 +10,7 @@ namespace samples {
 
     void LightingPass::onInit(
         const std::shared_ptr<vireo::Vireo>& vireo,
+        PipelineCache& pipelineCache,
         const vireo::ImageFormat renderFormat,
         const Scene& scene,
         const DepthPrepass& depthPrepass,
@@ -31,66 +32,56 @@ namespace samples {
         pipelineConfig.backStencilOpState = pipelineConfig.frontStencilOpState;
         pipelineConfig.resources = vireo->createPipelineResources(
             { descriptorLayout, samplers.getDescriptorLayout() });
-        pipelineConfig.vertexShader = vireo->createShaderModule("shaders/quad.vert");
-        pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/deferred_lighting.frag");
-        pipeline = vireo->createGraphicPipeline(pipelineConfig);
+        pipelineCache.declareGraphicPipeline(pipeline, pipelineConfig, "shaders/quad.vert", "shaders/deferred_lighting.frag");
 
         framesData.resize(framesInFlight);
-        for (auto& frame : framesData) {
-            frame.globalUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Global));
-            frame.globalUniform->map();
-            frame.lightUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Light));
-            frame.lightUniform->map();
-            auto light = scene.getLight();
-            frame.lightUniform->write(&light);
-            frame.lightUniform->unmap();
+        for (auto i = 0u; i < framesInFlight; i++) {
+            auto& frame = framesData[i];
+            frame.commandList.onInit(vireo);
             frame.descriptorSet = vireo->createDescriptorSet(descriptorLayout);
-            frame.descriptorSet->update(BINDING_GLOBAL, frame.globalUniform);
-            frame.descriptorSet->update(BINDING_LIGHT, frame.lightUniform);
+            frame.descriptorSet->update(BINDING_GLOBAL, scene.getGlobalBuffer(i));
+            frame.descriptorSet->update(BINDING_LIGHT, scene.getLightBuffer(i));
         }
     }
 
-    std::shared_ptr<vireo::QueryPool> LightingPass::onRender(
+    void LightingPass::onResize(const GBufferPass& gBufferPass) {
+        for (auto i = 0u; i < framesData.size(); i++) {
+            const auto& descriptorSet = framesData[i].descriptorSet;
+            descriptorSet->update(BINDING_POSITION_BUFFER, gBufferPass.getPositionBuffer(i)->getImage());
+            descriptorSet->update(BINDING_NORMAL_BUFFER, gBufferPass.getNormalBuffer(i)->getImage());
+            descriptorSet->update(BINDING_ALBEDO_BUFFER, gBufferPass.getAlbedoBuffer(i)->getImage());
+            descriptorSet->update(BINDING_MATERIAL_BUFFER, gBufferPass.getMaterialBuffer(i)->getImage());
+            framesData[i].commandList.invalidate();
+        }
+    }
+
+    const std::shared_ptr<vireo::CommandList>& LightingPass::onRender(
         const std::uint32_t frameIndex,
         const vireo::Extent& extent,
-        const Scene& scene,
         const DepthPrepass& depthPrepass,
-        const GBufferPass& gBufferPass,
         const Samplers& samplers,
-        const std::shared_ptr<vireo::CommandList>& cmdList,
         const std::shared_ptr<vireo::RenderTarget>& colorBuffer) {
-        const auto& frame = framesData[frameIndex];
-
-        frame.globalUniform->write(&scene.getGlobal());
-
-        frame.descriptorSet->update(BINDING_POSITION_BUFFER, gBufferPass.getPositionBuffer(frameIndex)->getImage());
-        frame.descriptorSet->update(BINDING_NORMAL_BUFFER, gBufferPass.getNormalBuffer(frameIndex)->getImage());
-        frame.descriptorSet->update(BINDING_ALBEDO_BUFFER, gBufferPass.getAlbedoBuffer(frameIndex)->getImage());
-        frame.descriptorSet->update(BINDING_MATERIAL_BUFFER, gBufferPass.getMaterialBuffer(frameIndex)->getImage());
+        auto& frame = framesData[frameIndex];
 
         renderingConfig.colorRenderTargets[0].renderTarget = colorBuffer;
         renderingConfig.depthStencilRenderTarget = depthPrepass.getDepthBuffer(frameIndex);
 
-        // auto pool = vireo->createQueryPool(2, "Lighting timing");
-        // cmdList->writeTimestamp(*pool, 0);
-
-        cmdList->beginRendering(renderingConfig);
-        cmdList->setViewport(vireo::Viewport{
-            static_cast<float>(extent.width),
-            static_cast<float>(extent.height)});
-        cmdList->setScissors(vireo::Rect{
-            extent.width,
-            extent.height});
-        cmdList->bindPipeline(pipeline);
-        cmdList->setStencilReference(1);
-        cmdList->bindDescriptors({frame.descriptorSet, samplers.getDescriptorSet()});
-        cmdList->draw(3);
-        cmdList->endRendering();
-
-        // cmdList->writeTimestamp(*pool, 1);
-        // cmdList->resolveQueryPool(*pool, 0, 2);
-        // return pool;
-        return nullptr;
+        // The render targets are only recreated by onResize()
+        const auto key = CachedCommandList::makeKey(extent.width, extent.height);
+        return frame.commandList.update(key, [&](const std::shared_ptr<vireo::CommandList>& cmdList) {
+            cmdList->beginRendering(renderingConfig);
+            cmdList->setViewport(vireo::Viewport{
+                static_cast<float>(extent.width),
+                static_cast<float>(extent.height)});
+            cmdList->setScissors(vireo::Rect{
+                extent.width,
+                extent.height});
+            cmdList->bindPipeline(pipeline);
+            cmdList->setStencilReference(1);
+            cmdList->bindDescriptors({frame.descriptorSet, samplers.getDescriptorSet()});
+            cmdList->draw(3);
+            cmdList->endRendering();
+        });
     }
 
-}
\ No newline at end of file
+}
@@ -8,8 +8,10 @@ export module samples.deferred.lightingpass;
 
 import std;
 import vireo;
+import samples.common.cachedcommandlist;
 import samples.common.global;
 import samples.common.depthprepass;
+import samples.common.pipelinecache;
 import samples.common.scene;
 import samples.common.samplers;
 import samples.deferred.gbuffer;
@@ -19,25 +21,25 @@ export namespace samples {
     public:
         void onInit(
            const std::shared_ptr<vireo::Vireo>& vireo,
+           PipelineCache& pipelineCache,
            vireo::ImageFormat renderFormat,
            const Scene& scene,
            const DepthPrepass& depthPrepass,
            const Samplers& samplers,
            std::uint32_t framesInFlight);
-        std::shared_ptr<vireo::QueryPool> onRender(
+        // Binds the gbuffers, must be called after GBufferPass::onResize()
+        void onResize(const GBufferPass& gBufferPass);
+        // Returns the command list of the frame, recorded again only when the render targets change
+        const std::shared_ptr<vireo::CommandList>& onRender(
             std::uint32_t frameIndex,
             const vireo::Extent& extent,
-            const Scene& scene,
             const DepthPrepass& depthPrepass,
-            const GBufferPass& gBufferPass,
             const Samplers& samplers,
-            const std::shared_ptr<vireo::CommandList>& cmdList,
             const std::shared_ptr<vireo::RenderTarget>& colorBuffer);
 
     private:
         struct FrameData {
-            std::shared_ptr<vireo::Buffer>        globalUniform;
-            std::shared_ptr<vireo::Buffer>        lightUniform;
+            CachedCommandList                     commandList;
             std::shared_ptr<vireo::DescriptorSet> descriptorSet;
         };
 
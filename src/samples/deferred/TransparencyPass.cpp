@@ -10,6 +10,7 @@ namespace samples {
 
     void TransparencyPass::onInit(
         const std::shared_ptr<vireo::Vireo>& vireo,
+        PipelineCache& pipelineCache,
         const vireo::ImageFormat renderFormat,
         const Scene& scene,
         const DepthPrepass& depthPrepass,
@@ -19,20 +20,23 @@ namespace samples {
 
         oitDescriptorLayout = vireo->createDescriptorLayout();
         oitDescriptorLayout->add(BINDING_GLOBAL, vireo::DescriptorType::UNIFORM);
-        oitDescriptorLayout->add(BINDING_MODEL, vireo::DescriptorType::UNIFORM);
+        oitDescriptorLayout->add(BINDING_MODEL, vireo::DescriptorType::STORAGE);
         oitDescriptorLayout->add(BINDING_LIGHT, vireo::DescriptorType::UNIFORM);
-        oitDescriptorLayout->add(BINDING_MATERIAL, vireo::DescriptorType::UNIFORM);
-        oitDescriptorLayout->add(BINDING_TEXTURES, vireo::DescriptorType::SAMPLED_IMAGE, scene.getTextures().size());
+        oitDescriptorLayout->add(BINDING_DRAWS, vireo::DescriptorType::STORAGE);
+        oitDescriptorLayout->add(BINDING_VERTICES, vireo::DescriptorType::STORAGE);
         oitDescriptorLayout->build();
 
         oitPipelineConfig.depthStencilImageFormat = depthPrepass.getFormat();
         oitPipelineConfig.resources = vireo->createPipelineResources(
-            { oitDescriptorLayout, samplers.getDescriptorLayout() },
+            { oitDescriptorLayout, samplers.getDescriptorLayout(), scene.getResourceHeap().getDescriptorLayout() },
             pushConstantsDesc);
-        oitPipelineConfig.vertexInputLayout = vireo->createVertexLayout(sizeof(Vertex), vertexAttributes);
-        oitPipelineConfig.vertexShader = vireo->createShaderModule("shaders/deferred.vert");
-        oitPipelineConfig.fragmentShader = vireo->createShaderModule("shaders/deferred_oit.frag");
-        oitPipeline = vireo->createGraphicPipeline(oitPipelineConfig);
+        // The fragment shader permutation of the transparent material
+        const auto fragmentShader = PipelineCache::getPermutation(
+            "shaders/deferred_oit.frag",
+            scene.getBucketFeatures(Scene::BUCKET_TRANSPARENT));
+        pipelineCache.declareGraphicPipeline(
+            oitPipeline, oitPipelineConfig,
+            scene.usePackedVertices ? "shaders/deferred_packed.vert" : "shaders/deferred.vert", fragmentShader);
 
         compositeDescriptorLayout = vireo->createDescriptorLayout();
         compositeDescriptorLayout->add(BINDING_ACCUM_BUFFER, vireo::DescriptorType::SAMPLED_IMAGE);
@@ -42,32 +46,19 @@ namespace samples {
         compositePipelineConfig.colorRenderFormats.push_back(renderFormat);
         compositePipelineConfig.resources = vireo->createPipelineResources(
             { compositeDescriptorLayout, samplers.getDescriptorLayout() });
-        compositePipelineConfig.vertexShader = vireo->createShaderModule("shaders/quad.vert");
-        compositePipelineConfig.fragmentShader = vireo->createShaderModule("shaders/deferred_oit_composite.frag");
-        compositePipeline = vireo->createGraphicPipeline(compositePipelineConfig);
+        pipelineCache.declareGraphicPipeline(
+            compositePipeline, compositePipelineConfig,
+            "shaders/quad.vert", "shaders/deferred_oit_composite.frag");
 
         framesData.resize(framesInFlight);
-        for (auto& frame : framesData) {
-            frame.globalUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Global));
-            frame.globalUniform->map();
-            frame.modelUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Model) * scene.getModels().size());
-            frame.modelUniform->map();
-            frame.materialUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Material) * scene.getMaterials().size());
-            frame.materialUniform->map();
-            frame.materialUniform->write(scene.getMaterials().data());
-            frame.materialUniform->unmap();
-            frame.lightUniform = vireo->createBuffer(vireo::BufferType::UNIFORM,sizeof(Light));
-            frame.lightUniform->map();
-            auto light = scene.getLight();
-            frame.lightUniform->write(&light);
-            frame.lightUniform->unmap();
+        for (auto i = 0u; i < framesInFlight; i++) {
+            auto& frame = framesData[i];
             frame.oitDescriptorSet = vireo->createDescriptorSet(oitDescriptorLayout);
-            frame.oitDescriptorSet->update(BINDING_GLOBAL, frame.globalUniform);
-            frame.oitDescriptorSet->update(BINDING_MODEL, frame.modelUniform);
-            frame.oitDescriptorSet->update(BINDING_LIGHT, frame.lightUniform);
-            frame.oitDescriptorSet->update(BINDING_MATERIAL, frame.materialUniform);
-            frame.oitDescriptorSet->update(BINDING_TEXTURES, scene.getTextures());
+            frame.oitDescriptorSet->update(BINDING_GLOBAL, scene.getGlobalBuffer(i));
+            frame.oitDescriptorSet->update(BINDING_LIGHT, scene.getLightBuffer(i));
+            frame.oitDescriptorSet->update(BINDING_VERTICES, scene.getGeometry().getVertexBuffer());
             frame.compositeDescriptorSet = vireo->createDescriptorSet(compositeDescriptorLayout);
+            frame.compositeCommandList.onInit(vireo);
         }
     }
 
@@ -77,12 +68,17 @@ namespace samples {
         const Scene& scene,
         const DepthPrepass& depthPrepass,
         const Samplers& samplers,
-        const std::shared_ptr<vireo::CommandList>& cmdList,
-        const std::shared_ptr<vireo::RenderTarget>& colorBuffer) {
-        const auto& frame = framesData[frameIndex];
+        const std::shared_ptr<vireo::CommandList>& cmdList) {
+        auto& frame = framesData[frameIndex];
 
-        frame.globalUniform->write(&scene.getGlobal());
-        frame.modelUniform->write(scene.getModels().data());
+        if (frame.modelsBuffer != scene.getModelsBuffer(frameIndex)) {
+            frame.modelsBuffer = scene.getModelsBuffer(frameIndex);
+            frame.oitDescriptorSet->update(BINDING_MODEL, frame.modelsBuffer);
+        }
+        if (frame.drawsBuffer != scene.getDrawsBuffer(frameIndex)) {
+            frame.drawsBuffer = scene.getDrawsBuffer(frameIndex);
+            frame.oitDescriptorSet->update(BINDING_DRAWS, frame.drawsBuffer);
+        }
 
         oitRenderingConfig.colorRenderTargets[BINDING_ACCUM_BUFFER].renderTarget = frame.accumBuffer;
         oitRenderingConfig.colorRenderTargets[BINDING_REVEALAGE_BUFFER].renderTarget = frame.revealageBuffer;
@@ -100,35 +96,52 @@ namespace samples {
         cmdList->setScissors(vireo::Rect{
             extent.width,
             extent.height});
-        cmdList->bindPipeline(oitPipeline);
-        cmdList->bindDescriptors({frame.oitDescriptorSet, samplers.getDescriptorSet()});
-        pushConstants.modelIndex = Scene::MODEL_TRANSPARENT;
-        pushConstants.materialIndex = Scene::MATERIAL_GRID;
+        commandState.begin(cmdList);
+        commandState.bindPipeline(oitPipeline);
+        commandState.bindDescriptors({
+            frame.oitDescriptorSet,
+            samplers.getDescriptorSet(),
+            scene.getResourceHeap().getDescriptorSet(frameIndex)});
+        const auto range = scene.getDrawRange(Scene::BUCKET_TRANSPARENT, Scene::BUCKET_TRANSPARENT);
+        pushConstants.firstDraw = range.first;
+        pushConstants.quantization = scene.getVertexQuantization();
         cmdList->pushConstants(oitPipelineConfig.resources, pushConstantsDesc, &pushConstants);
-        scene.drawCube(cmdList);
+        scene.drawCubes(commandState, range);
 
         cmdList->endRendering();
         cmdList->barrier(
             {frame.accumBuffer, frame.revealageBuffer},
             vireo::ResourceState::RENDER_TARGET_COLOR,
             vireo::ResourceState::SHADER_READ);
+    }
 
-        frame.compositeDescriptorSet->update(BINDING_ACCUM_BUFFER, frame.accumBuffer->getImage());
-        frame.compositeDescriptorSet->update(BINDING_REVEALAGE_BUFFER, frame.revealageBuffer->getImage());
-
+    const std::shared_ptr<vireo::CommandList>& TransparencyPass::onComposite(
+        const std::uint32_t frameIndex,
+        const vireo::Extent& extent,
+        const Samplers& samplers,
+        const std::shared_ptr<vireo::RenderTarget>& colorBuffer) {
+        auto& frame = framesData[frameIndex];
         compositeRenderingConfig.colorRenderTargets[0].renderTarget = colorBuffer;
 
-        cmdList->beginRendering(compositeRenderingConfig);
-        cmdList->setViewport(vireo::Viewport{
-            static_cast<float>(extent.width),
-            static_cast<float>(extent.height)});
-        cmdList->setScissors(vireo::Rect{
-            extent.width,
-            extent.height});
-        cmdList->bindPipeline(compositePipeline);
-        cmdList->bindDescriptors({frame.compositeDescriptorSet, samplers.getDescriptorSet()});
-        cmdList->draw(3);
-        cmdList->endRendering();
+        // The target changes with the TAA history buffers, which are not swapped in step with the frames
+        if (frame.compositeTarget != colorBuffer) {
+            frame.compositeCommandList.invalidate();
+            frame.compositeTarget = colorBuffer;
+        }
+        const auto key = CachedCommandList::makeKey(extent.width, extent.height);
+        return frame.compositeCommandList.update(key, [&](const std::shared_ptr<vireo::CommandList>& cmdList) {
+            cmdList->beginRendering(compositeRenderingConfig);
+            cmdList->setViewport(vireo::Viewport{
+                static_cast<float>(extent.width),
+                static_cast<float>(extent.height)});
+            cmdList->setScissors(vireo::Rect{
+                extent.width,
+                extent.height});
+            cmdList->bindPipeline(compositePipeline);
+            cmdList->bindDescriptors({frame.compositeDescriptorSet, samplers.getDescriptorSet()});
+            cmdList->draw(3);
+            cmdList->endRendering();
+        });
     }
 
     void TransparencyPass::onResize(const vireo::Extent& extent, const std::shared_ptr<vireo::CommandList>& cmdList) {
@@ -147,6 +160,9 @@ namespace samples {
                 {frame.accumBuffer, frame.revealageBuffer},
                 vireo::ResourceState::UNDEFINED,
                 vireo::ResourceState::SHADER_READ);
+            frame.compositeDescriptorSet->update(BINDING_ACCUM_BUFFER, frame.accumBuffer->getImage());
+            frame.compositeDescriptorSet->update(BINDING_REVEALAGE_BUFFER, frame.revealageBuffer->getImage());
+            frame.compositeCommandList.invalidate();
         }
     }
 
@@ -4,14 +4,15 @@
 * This software is released under the MIT License.
 * https://opensource.org/licenses/MIT
 */
-module;
-#include <cstddef>
 export module samples.deferred.oitpass;
 
 import std;
 import vireo;
+import samples.common.cachedcommandlist;
+import samples.common.commandstate;
 import samples.common.global;
 import samples.common.depthprepass;
+import samples.common.pipelinecache;
 import samples.common.scene;
 import samples.common.samplers;
 import samples.deferred.gbuffer;
@@ -21,6 +22,7 @@ export namespace samples {
     public:
         void onInit(
            const std::shared_ptr<vireo::Vireo>& vireo,
+           PipelineCache& pipelineCache,
            vireo::ImageFormat renderFormat,
            const Scene& scene,
            const DepthPrepass& depthPrepass,
@@ -33,31 +35,38 @@ export namespace samples {
             const Scene& scene,
             const DepthPrepass& depthPrepass,
             const Samplers& samplers,
-            const std::shared_ptr<vireo::CommandList>& cmdList,
+            const std::shared_ptr<vireo::CommandList>& cmdList);
+        // Returns the command list compositing the transparent surfaces, submitted after the one given to
+        // onRender() and recorded again only when the render targets or colorBuffer change
+        const std::shared_ptr<vireo::CommandList>& onComposite(
+            std::uint32_t frameIndex,
+            const vireo::Extent& extent,
+            const Samplers& samplers,
             const std::shared_ptr<vireo::RenderTarget>& colorBuffer);
 
     private:
         struct FrameData {
-            std::shared_ptr<vireo::Buffer>        globalUniform;
-            std::shared_ptr<vireo::Buffer>        modelUniform;
-            std::shared_ptr<vireo::Buffer>        lightUniform;
-            std::shared_ptr<vireo::Buffer>        materialUniform;
+            std::shared_ptr<vireo::Buffer>        modelsBuffer;
+            std::shared_ptr<vireo::Buffer>        drawsBuffer;
             std::shared_ptr<vireo::DescriptorSet> oitDescriptorSet;
             std::shared_ptr<vireo::DescriptorSet> compositeDescriptorSet;
+            CachedCommandList                     compositeCommandList;
+            // Render target of the recorded composite, kept alive so that a new target can't reuse its address
+            std::shared_ptr<vireo::RenderTarget>  compositeTarget;
             std::shared_ptr<vireo::RenderTarget>  accumBuffer;
             std::shared_ptr<vireo::RenderTarget>  revealageBuffer;
         };
 
         struct PushConstants {
-            std::uint32_t modelIndex;
-            std::uint32_t materialIndex;
+            std::uint32_t                  firstDraw;
+            alignas(16) VertexQuantization quantization;
         };
 
         static constexpr vireo::DescriptorIndex BINDING_GLOBAL{0};
         static constexpr vireo::DescriptorIndex BINDING_MODEL{1};
         static constexpr vireo::DescriptorIndex BINDING_LIGHT{2};
-        static constexpr vireo::DescriptorIndex BINDING_MATERIAL{3};
-        static constexpr vireo::DescriptorIndex BINDING_TEXTURES{4};
+        static constexpr vireo::DescriptorIndex BINDING_DRAWS{3};
+        static constexpr vireo::DescriptorIndex BINDING_VERTICES{4};
 
         static constexpr vireo::DescriptorIndex BINDING_ACCUM_BUFFER{0};
         static constexpr vireo::DescriptorIndex BINDING_REVEALAGE_BUFFER{1};
@@ -66,12 +75,6 @@ export namespace samples {
             .stage = vireo::ShaderStage::ALL,
             .size = sizeof(PushConstants),
         };
-        const std::vector<vireo::VertexAttributeDesc> vertexAttributes {
-                {"POSITION", vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, position) },
-                {"NORMAL",   vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, normal)},
-                {"UV",       vireo::AttributeFormat::R32G32_FLOAT,    offsetof(Vertex, uv)},
-                {"TANGENT",  vireo::AttributeFormat::R32G32B32_FLOAT,   offsetof(Vertex, tangent)},
-            };
 
         vireo::GraphicPipelineConfiguration oitPipelineConfig {
             .colorRenderFormats  = {
@@ -144,5 +147,6 @@ export namespace samples {
         std::shared_ptr<vireo::Pipeline>         compositePipeline;
         std::shared_ptr<vireo::DescriptorLayout> oitDescriptorLayout;
         std::shared_ptr<vireo::DescriptorLayout> compositeDescriptorLayout;
+        CommandState                             commandState;
     };
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 * https://opensource.org/licenses/MIT
 */
 module;
+#include <glm/gtc/matrix_transform.hpp>
 module samples.indirect;
 
 namespace samples {
@@ -18,9 +19,74 @@ namespace samples {
             vertex.pos.y *= ratio;
         }
 
+        // A square grid of triangles, the three triangles alternating
+        const auto meshCount = static_cast<std::uint32_t>(gridVertices.size() / triangleIndices.size());
+        const auto side = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<float>(INSTANCE_COUNT))));
+        auto instances = std::vector<Instance>(INSTANCE_COUNT);
+        for (auto i = 0u; i < INSTANCE_COUNT; i++) {
+            instances[i].position = {
+                static_cast<float>(i % side) - 0.5f * side,
+                static_cast<float>(i / side) - 0.5f * side,
+                0.0f};
+            instances[i].mesh = i % meshCount;
+        }
+        // Each triangle gets a range of the visible list large enough for all its instances
+        auto visibleOffset = 0u;
+        for (auto mesh = 0u; mesh < meshCount; mesh++) {
+            meshes.push_back({
+                .indexCount = static_cast<std::uint32_t>(triangleIndices.size()),
+                .firstIndex = 0,
+                .vertexOffset = static_cast<std::int32_t>(mesh * triangleIndices.size()),
+                .visibleOffset = visibleOffset,
+            });
+            visibleOffset += (INSTANCE_COUNT + meshCount - 1 - mesh) / meshCount;
+        }
+        params.instanceCount = INSTANCE_COUNT;
+        params.boundingRadius = 0.36f;
+
         vertexBuffer = vireo->createBuffer(vireo::BufferType::VERTEX, sizeof(Vertex), triangleVertices.size());
         indexBuffer = vireo->createBuffer(vireo::BufferType::INDEX, sizeof(std::uint32_t), triangleIndices.size());
         drawCommandsBuffer = vireo->createBuffer(vireo::BufferType::INDIRECT, sizeof(vireo::DrawIndexedIndirectCommand), drawCommands.size());
+        gridVertexBuffer = vireo->createBuffer(vireo::BufferType::VERTEX, sizeof(GridVertex), gridVertices.size());
+        instancesBuffer = vireo->createBuffer(vireo::BufferType::STORAGE, sizeof(Instance), instances.size(), "Instances");
+        meshesBuffer = vireo->createBuffer(vireo::BufferType::STORAGE, sizeof(Mesh), meshes.size(), "Meshes");
+
+        descriptorLayout = vireo->createDescriptorLayout();
+        descriptorLayout->add(BINDING_PARAMS, vireo::DescriptorType::UNIFORM);
+        descriptorLayout->add(BINDING_INSTANCES, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_MESHES, vireo::DescriptorType::STORAGE);
+        descriptorLayout->add(BINDING_VISIBLE, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->add(BINDING_COUNTERS, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->add(BINDING_COMMANDS, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->add(BINDING_DRAW_COUNT, vireo::DescriptorType::READWRITE_STORAGE);
+        descriptorLayout->build();
+
+        // The counters must be cleared before the first frame, the commands pass clears them for the next ones
+        const auto zeros = std::vector<std::uint32_t>(meshes.size(), 0);
+        framesData.resize(swapChain->getFramesInFlight());
+        for (auto& frame : framesData) {
+            frame.commandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
+            frame.commandList = frame.commandAllocator->createCommandList();
+            frame.inFlightFence = vireo->createFence(true);
+            frame.paramsBuffer = vireo->createBuffer(vireo::BufferType::UNIFORM, sizeof(Params));
+            frame.paramsBuffer->map();
+            frame.visibleBuffer = vireo->createBuffer(
+                vireo::BufferType::READWRITE_STORAGE, sizeof(std::uint32_t), INSTANCE_COUNT, "Visible instances");
+            frame.countersBuffer = vireo->createBuffer(
+                vireo::BufferType::READWRITE_STORAGE, sizeof(std::uint32_t), meshes.size(), "Instance counters");
+            frame.drawCommandsBuffer = vireo->createBuffer(
+                vireo::BufferType::INDIRECT, sizeof(vireo::DrawIndexedIndirectCommand), meshes.size(), "Draw commands");
+            frame.drawCountBuffer = vireo->createBuffer(
+                vireo::BufferType::INDIRECT, sizeof(std::uint32_t), 1, "Draw count");
+            frame.descriptorSet = vireo->createDescriptorSet(descriptorLayout);
+            frame.descriptorSet->update(BINDING_PARAMS, frame.paramsBuffer);
+            frame.descriptorSet->update(BINDING_INSTANCES, instancesBuffer);
+            frame.descriptorSet->update(BINDING_MESHES, meshesBuffer);
+            frame.descriptorSet->update(BINDING_VISIBLE, frame.visibleBuffer);
+            frame.descriptorSet->update(BINDING_COUNTERS, frame.countersBuffer);
+            frame.descriptorSet->update(BINDING_COMMANDS, frame.drawCommandsBuffer);
+            frame.descriptorSet->update(BINDING_DRAW_COUNT, frame.drawCountBuffer);
+        }
 
         const auto uploadCommandAllocator = vireo->createCommandAllocator(vireo::CommandType::TRANSFER);
         const auto uploadCommandList = uploadCommandAllocator->createCommandList();
@@ -29,7 +95,13 @@ namespace samples {
             {vertexBuffer, triangleVertices.data()},
             {indexBuffer, triangleIndices.data()},
             {drawCommandsBuffer, drawCommands.data()},
+            {gridVertexBuffer, gridVertices.data()},
+            {instancesBuffer, instances.data()},
+            {meshesBuffer, meshes.data()},
         });
+        for (const auto& frame : framesData) {
+            uploadCommandList->upload(frame.countersBuffer, zeros.data());
+        }
         uploadCommandList->end();
         const auto transferQueue = vireo->createSubmitQueue(vireo::CommandType::TRANSFER);
         transferQueue->submit({uploadCommandList});
@@ -40,14 +112,66 @@ namespace samples {
         pipelineConfig.fragmentShader = vireo->createShaderModule("shaders/triangle_color.frag");
         defaultPipeline = vireo->createGraphicPipeline(pipelineConfig);
 
-        framesData.resize(swapChain->getFramesInFlight());
-        for (std::uint32_t i = 0; i < framesData.size(); i++) {
-            framesData[i].commandAllocator = vireo->createCommandAllocator(vireo::CommandType::GRAPHIC);
-            framesData[i].commandList = framesData[i].commandAllocator->createCommandList();
-            framesData[i].inFlightFence =vireo->createFence(true);
-        }
+        const auto resources = vireo->createPipelineResources({ descriptorLayout });
+        cullPipeline = vireo->createComputePipeline(
+            resources,
+            vireo->createShaderModule("shaders/indirect_cull.comp"));
+        commandsPipeline = vireo->createComputePipeline(
+            resources,
+            vireo->createShaderModule("shaders/indirect_commands.comp"));
+
+        gridPipelineConfig.resources = resources;
+        gridPipelineConfig.vertexInputLayout = vireo->createVertexLayout(sizeof(GridVertex), gridVertexAttributes);
+        gridPipelineConfig.vertexShader = vireo->createShaderModule("shaders/indirect_instances.vert");
+        gridPipelineConfig.fragmentShader = vireo->createShaderModule("shaders/indirect_instances.frag");
+        gridPipeline = vireo->createGraphicPipeline(gridPipelineConfig);
 
         transferQueue->waitIdle();
+
+        // Put the per-frame buffers in the state they have at the end of a frame
+        std::vector<std::shared_ptr<const vireo::CommandList>> commandLists;
+        for (const auto& frame : framesData) {
+            frame.commandList->begin();
+            frame.commandList->barrier(frame.visibleBuffer, vireo::ResourceState::UNDEFINED, vireo::ResourceState::SHADER_READ);
+            frame.commandList->barrier(frame.countersBuffer, vireo::ResourceState::UNDEFINED, vireo::ResourceState::COMPUTE_WRITE);
+            frame.commandList->barrier(frame.drawCommandsBuffer, vireo::ResourceState::UNDEFINED, vireo::ResourceState::INDIRECT_DRAW);
+            frame.commandList->barrier(frame.drawCountBuffer, vireo::ResourceState::UNDEFINED, vireo::ResourceState::INDIRECT_DRAW);
+            frame.commandList->end();
+            commandLists.push_back(frame.commandList);
+        }
+        graphicQueue->submit(commandLists);
+        graphicQueue->waitIdle();
+
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    void IndirectApp::onKeyDown(const std::uint32_t key) {
+        if (static_cast<KeyScanCodes>(key) == KeyScanCodes::SPACE) {
+            gridMode = !gridMode;
+        }
+    }
+
+    void IndirectApp::onUpdate() {
+        if (!gridMode) { return; }
+        // Fly over the grid
+        const auto time = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+        const auto target = glm::vec3{std::cos(time * 0.1f), std::sin(time * 0.1f), 0.0f} * 200.0f;
+        const auto view = glm::lookAt(target + glm::vec3{0.0f, -10.0f, 20.0f}, target, glm::vec3{0.0f, 1.0f, 0.0f});
+        const auto projection = glm::perspective(glm::radians(60.0f), swapChain->getAspectRatio(), 0.1f, 100.0f);
+        params.viewProjection = projection * view;
+
+        // Normalized planes for the bounding spheres distances, the near plane is conservative for a [0, 1] depth range
+        const auto& m = params.viewProjection;
+        const auto row = [&](const int i) { return glm::vec4{m[0][i], m[1][i], m[2][i], m[3][i]}; };
+        params.planes[0] = row(3) + row(0);
+        params.planes[1] = row(3) - row(0);
+        params.planes[2] = row(3) + row(1);
+        params.planes[3] = row(3) - row(1);
+        params.planes[4] = row(3) + row(2);
+        params.planes[5] = row(3) - row(2);
+        for (auto& plane : params.planes) {
+            plane /= glm::length(glm::vec3{plane});
+        }
     }
 
     void IndirectApp::onRender() {
@@ -57,8 +181,11 @@ namespace samples {
         frame.commandAllocator->reset();
         const auto& cmdList = frame.commandList;
         cmdList->begin();
-        cmdList->barrier(swapChain, vireo::ResourceState::UNDEFINED, vireo::ResourceState::RENDER_TARGET_COLOR);
+        if (gridMode) {
+            recordCulling(frame, cmdList);
+        }
 
+        cmdList->barrier(swapChain, vireo::ResourceState::UNDEFINED, vireo::ResourceState::RENDER_TARGET_COLOR);
         cmdList->beginRendering(renderingConfig);
         cmdList->setViewport(vireo::Viewport{
             static_cast<float>(swapChain->getExtent().width),
@@ -66,10 +193,22 @@ namespace samples {
         cmdList->setScissors(vireo::Rect{
             swapChain->getExtent().width,
             swapChain->getExtent().height});
-        cmdList->bindPipeline(defaultPipeline);
-        cmdList->bindVertexBuffer(vertexBuffer);
-        cmdList->bindIndexBuffer(indexBuffer);
-        cmdList->drawIndexedIndirect(drawCommandsBuffer, 0, drawCommands.size(), sizeof(vireo::DrawIndexedIndirectCommand));
+        if (gridMode) {
+            cmdList->bindPipeline(gridPipeline);
+            cmdList->bindDescriptors({frame.descriptorSet});
+            cmdList->bindVertexBuffer(gridVertexBuffer);
+            cmdList->bindIndexBuffer(indexBuffer);
+            cmdList->drawIndexedIndirectCount(
+                frame.drawCommandsBuffer, 0,
+                frame.drawCountBuffer, 0,
+                meshes.size(),
+                sizeof(vireo::DrawIndexedIndirectCommand));
+        } else {
+            cmdList->bindPipeline(defaultPipeline);
+            cmdList->bindVertexBuffer(vertexBuffer);
+            cmdList->bindIndexBuffer(indexBuffer);
+            cmdList->drawIndexedIndirect(drawCommandsBuffer, 0, drawCommands.size(), sizeof(vireo::DrawIndexedIndirectCommand));
+        }
         cmdList->endRendering();
 
         cmdList->barrier(swapChain, vireo::ResourceState::RENDER_TARGET_COLOR, vireo::ResourceState::PRESENT);
@@ -80,6 +219,26 @@ namespace samples {
         swapChain->nextFrameIndex();
     }
 
+    void IndirectApp::recordCulling(const FrameData& frame, const std::shared_ptr<vireo::CommandList>& cmdList) {
+        // Written after acquire() : the GPU is done with the previous frame using this buffer
+        frame.paramsBuffer->write(&params);
+
+        // Cull the instances, then turn the visible instances counts into draw commands
+        cmdList->barrier(frame.visibleBuffer, vireo::ResourceState::SHADER_READ, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->barrier(frame.drawCommandsBuffer, vireo::ResourceState::INDIRECT_DRAW, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->barrier(frame.drawCountBuffer, vireo::ResourceState::INDIRECT_DRAW, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->bindPipeline(cullPipeline);
+        cmdList->bindDescriptors({frame.descriptorSet});
+        cmdList->dispatch((INSTANCE_COUNT + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+        cmdList->barrier(frame.countersBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::COMPUTE_WRITE);
+        cmdList->bindPipeline(commandsPipeline);
+        cmdList->bindDescriptors({frame.descriptorSet});
+        cmdList->dispatch(1, 1, 1);
+        cmdList->barrier(frame.visibleBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::SHADER_READ);
+        cmdList->barrier(frame.drawCommandsBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::INDIRECT_DRAW);
+        cmdList->barrier(frame.drawCountBuffer, vireo::ResourceState::COMPUTE_WRITE, vireo::ResourceState::INDIRECT_DRAW);
+    }
+
     void IndirectApp::onResize() {
         swapChain->recreate();
     }
@@ -87,6 +246,9 @@ namespace samples {
     void IndirectApp::onDestroy() {
         graphicQueue->waitIdle();
         swapChain->waitIdle();
+        for (const auto& frame : framesData) {
+            frame.paramsBuffer->unmap();
+        }
     }
 
-}
\ No newline at end of file
+}
@@ -12,26 +12,76 @@ import glm;
 import std;
 import vireo;
 import samples.app;
+import samples.common.global;
 
 export namespace samples {
 
+    // Three triangles drawn with indirect commands written by the CPU. The `SPACE` key switches to the GPU driven
+    // rendering of a grid of 1M triangles : a compute pass culls the instances against the view frustum and
+    // writes the draw commands, the CPU only updates the camera.
     class IndirectApp : public Application {
     public:
         void onInit() override;
+        void onUpdate() override;
         void onRender() override;
         void onResize() override;
         void onDestroy() override;
+        void onKeyDown(std::uint32_t key) override;
 
     private:
+        static constexpr std::uint32_t INSTANCE_COUNT{1000000};
+        static constexpr std::uint32_t CULL_GROUP_SIZE{64};
+
+        const vireo::DescriptorIndex BINDING_PARAMS{0};
+        const vireo::DescriptorIndex BINDING_INSTANCES{1};
+        const vireo::DescriptorIndex BINDING_MESHES{2};
+        const vireo::DescriptorIndex BINDING_VISIBLE{3};
+        const vireo::DescriptorIndex BINDING_COUNTERS{4};
+        const vireo::DescriptorIndex BINDING_COMMANDS{5};
+        const vireo::DescriptorIndex BINDING_DRAW_COUNT{6};
+
         struct Vertex {
             glm::vec3 pos;
             glm::vec3 color;
         };
 
+        struct GridVertex {
+            glm::vec3     pos;
+            glm::vec3     color;
+            std::uint32_t mesh;
+        };
+
+        // One of the triangles at a position of the grid
+        struct Instance {
+            glm::vec3     position;
+            std::uint32_t mesh;
+        };
+
+        // Draw parameters of a triangle and where its visible instances are written
+        struct Mesh {
+            std::uint32_t indexCount;
+            std::uint32_t firstIndex;
+            std::int32_t  vertexOffset;
+            std::uint32_t visibleOffset;
+        };
+
+        struct Params {
+            glm::mat4     viewProjection;
+            glm::vec4     planes[6];
+            std::uint32_t instanceCount;
+            float         boundingRadius;
+        };
+
         struct FrameData {
             std::shared_ptr<vireo::CommandAllocator> commandAllocator;
             std::shared_ptr<vireo::CommandList>      commandList;
             std::shared_ptr<vireo::Fence>            inFlightFence;
+            std::shared_ptr<vireo::Buffer>           paramsBuffer;
+            std::shared_ptr<vireo::Buffer>           visibleBuffer;
+            std::shared_ptr<vireo::Buffer>           countersBuffer;
+            std::shared_ptr<vireo::Buffer>           drawCommandsBuffer;
+            std::shared_ptr<vireo::Buffer>           drawCountBuffer;
+            std::shared_ptr<vireo::DescriptorSet>    descriptorSet;
         };
 
         std::vector<Vertex> triangleVertices {
@@ -48,25 +98,50 @@ export namespace samples {
             { { -0.25f + 0.5f, -0.25f, 0.0f },{ 0.0f, 1.0f, 0.0f } },
         };
 
-        const std::vector<std::uint32_t> triangleIndices {
-            0, 1, 2,
-        };
-
         const std::vector<vireo::DrawIndexedIndirectCommand> drawCommands {
             { 3, 1, 0, 0, 0 },
             { 3, 1, 0, 3, 0 },
             { 3, 1, 0, 6, 0 },
         };
 
+        // The same triangles, centered, for the grid
+        std::vector<GridVertex> gridVertices {
+            { { 0.0f, 0.25f, 0.0f },   { 0.0f, 1.0f, 0.0f }, 0 },
+            { { 0.25f, -0.25f, 0.0f },{ 0.0f, 0.0f, 1.0f }, 0 },
+            { { -0.25f, -0.25f, 0.0f },{ 1.0f, 0.0f, 0.0f }, 0 },
+
+            { { 0.0f, 0.25f, 0.0f }, { 1.0f, 0.0f, 0.0f}, 1 },
+            { { 0.25f, -0.25f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 1 },
+            { { -0.25f, -0.25f, 0.0f }, { 0.0f, 0.0f, 1.0f }, 1 },
+
+            { { 0.0f, 0.25f, 0.0f },   { 0.0f, 0.0f, 1.0f }, 2 },
+            { { 0.25f, -0.25f, 0.0f },{ 1.0f, 0.0f, 0.0f }, 2 },
+            { { -0.25f, -0.25f, 0.0f },{ 0.0f, 1.0f, 0.0f }, 2 },
+        };
+
+        const std::vector<std::uint32_t> triangleIndices {
+            0, 1, 2,
+        };
+
         const std::vector<vireo::VertexAttributeDesc> vertexAttributes{
             {"POSITION", vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, pos)},
             {"COLOR",    vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(Vertex, color)}
         };
 
+        const std::vector<vireo::VertexAttributeDesc> gridVertexAttributes{
+            {"POSITION", vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(GridVertex, pos)},
+            {"COLOR",    vireo::AttributeFormat::R32G32B32_FLOAT, offsetof(GridVertex, color)},
+            {"MESH",     vireo::AttributeFormat::R32_UINT,        offsetof(GridVertex, mesh)}
+        };
+
         vireo::GraphicPipelineConfiguration pipelineConfig {
             .colorRenderFormats = {vireo::ImageFormat::R8G8B8A8_SRGB},
             .colorBlendDesc     = {{}}
         };
+        vireo::GraphicPipelineConfiguration gridPipelineConfig {
+            .colorRenderFormats = {vireo::ImageFormat::R8G8B8A8_SRGB},
+            .colorBlendDesc     = {{}}
+        };
         vireo::RenderingConfiguration renderingConfig {
             .colorRenderTargets = {{
                 .clear      = true,
@@ -74,12 +149,26 @@ export namespace samples {
             }}
         };
 
-        std::vector<FrameData>              framesData;
-        std::shared_ptr<vireo::Buffer>      vertexBuffer;
-        std::shared_ptr<vireo::Buffer>      indexBuffer;
-        std::shared_ptr<vireo::Buffer>      drawCommandsBuffer;
-        std::shared_ptr<vireo::Pipeline>    defaultPipeline;
-        std::shared_ptr<vireo::SwapChain>   swapChain;
-        std::shared_ptr<vireo::SubmitQueue> graphicQueue;
+        Params                                   params{};
+        std::vector<Mesh>                        meshes;
+        std::vector<FrameData>                   framesData;
+        std::shared_ptr<vireo::Buffer>           vertexBuffer;
+        std::shared_ptr<vireo::Buffer>           indexBuffer;
+        std::shared_ptr<vireo::Buffer>           drawCommandsBuffer;
+        std::shared_ptr<vireo::Buffer>           gridVertexBuffer;
+        std::shared_ptr<vireo::Buffer>           instancesBuffer;
+        std::shared_ptr<vireo::Buffer>           meshesBuffer;
+        std::shared_ptr<vireo::DescriptorLayout> descriptorLayout;
+        std::shared_ptr<vireo::Pipeline>         cullPipeline;
+        std::shared_ptr<vireo::Pipeline>         commandsPipeline;
+        std::shared_ptr<vireo::Pipeline>         defaultPipeline;
+        std::shared_ptr<vireo::Pipeline>         gridPipeline;
+        std::shared_ptr<vireo::SwapChain>        swapChain;
+        std::shared_ptr<vireo::SubmitQueue>      graphicQueue;
+        std::chrono::steady_clock::time_point    startTime;
+        bool                                     gridMode{false};
+
+        // Writes the camera of the grid and records the culling and the draw commands generation
+        void recordCulling(const FrameData& frame, const std::shared_ptr<vireo::CommandList>& cmdList);
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,224 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+import std;
+import glm;
+import samples.common.softwareocclusion;
+import samples.common.workerpool;
+
+// Checks the scalar and the AVX2 paths of samples::SoftwareOcclusion against an analytic scene, against the
+// reference depth buffers of the test scenes, and against each other when the CPU supports AVX2.
+// The scenes are given in normalized device coordinates with identity matrices : the vertices do not depend on
+// the matrices computations and the depth buffers only on the rasterizer.
+// Usage : software_occlusion_test <references directory> [--generate]
+namespace {
+
+    using samples::SoftwareOcclusion;
+
+    constexpr auto PIXELS{SoftwareOcclusion::WIDTH * SoftwareOcclusion::HEIGHT};
+    // Pixels on the triangles edges can flip between compilers, the depth of the others must match
+    constexpr auto DEPTH_TOLERANCE{1e-5f};
+    constexpr auto MAX_DIFFERENT_PIXELS{PIXELS / 1000};
+
+    struct Scene {
+        std::string                name;
+        std::vector<glm::vec3>     positions;
+        std::vector<std::uint32_t> indices;
+    };
+
+    // Not std::uniform_real_distribution : its results depend on the standard library
+    class Random {
+    public:
+        float next(const float min, const float max) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return min + (max - min) * static_cast<float>(state >> 40) / static_cast<float>(1 << 24);
+        }
+
+    private:
+        std::uint64_t state{42};
+    };
+
+    void addTriangle(Scene& scene, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+        const auto first = static_cast<std::uint32_t>(scene.positions.size());
+        scene.positions.insert(scene.positions.end(), {v0, v1, v2});
+        scene.indices.insert(scene.indices.end(), {first, first + 1, first + 2});
+    }
+
+    // Large overlapping sloped triangles of both windings, some crossing the borders, and a degenerated one
+    Scene makeOverlapScene() {
+        auto scene = Scene{.name = "overlap"};
+        addTriangle(scene, {-0.9f, -0.8f, 0.2f}, {0.7f, -0.6f, 0.6f}, {-0.2f, 0.9f, 0.4f});
+        addTriangle(scene, {-0.5f, 0.8f, 0.3f}, {0.9f, 0.7f, 0.1f}, {0.3f, -0.9f, 0.5f});
+        addTriangle(scene, {-1.4f, 0.2f, 0.7f}, {-0.3f, -1.3f, 0.05f}, {0.1f, 0.6f, 0.9f});
+        addTriangle(scene, {0.4f, 0.3f, 0.02f}, {1.5f, 1.2f, 0.02f}, {1.3f, -0.4f, 0.02f});
+        addTriangle(scene, {-0.1f, -0.1f, 0.01f}, {0.2f, 0.2f, 0.01f}, {0.5f, 0.5f, 0.01f});
+        return scene;
+    }
+
+    // Many small triangles of random windings and depths
+    Scene makeRandomScene() {
+        auto scene = Scene{.name = "random"};
+        auto random = Random{};
+        for (auto i = 0; i < 500; i++) {
+            const auto center = glm::vec3{random.next(-1.1f, 1.1f), random.next(-1.1f, 1.1f), 0.0f};
+            const auto size = random.next(0.01f, 0.2f);
+            auto vertices = std::array<glm::vec3, 3>{};
+            for (auto& vertex : vertices) {
+                vertex = center + glm::vec3{random.next(-size, size), random.next(-size, size), 0.0f};
+                vertex.z = random.next(0.0f, 1.0f);
+            }
+            addTriangle(scene, vertices[0], vertices[1], vertices[2]);
+        }
+        return scene;
+    }
+
+    void rasterize(SoftwareOcclusion& occlusion, const Scene& scene, samples::WorkerPool& workerPool) {
+        occlusion.begin(glm::mat4{1.0f});
+        occlusion.addOccluder(scene.positions, scene.indices, glm::mat4{1.0f});
+        occlusion.rasterize(workerPool);
+    }
+
+    // Screen aligned quad at a constant depth, its edges on pixels boundaries : the expected depth buffer and
+    // occlusion results are known without running the rasterizer
+    bool checkQuad(const std::string& what, SoftwareOcclusion& occlusion, samples::WorkerPool& workerPool) {
+        static constexpr auto QUAD_DEPTH{0.5f};
+        // [-0.5, 0.25] x [-0.25, 0.5] in normalized device coordinates, not symmetric to catch a flipped axis.
+        // The y axis points down in the depth buffer.
+        static constexpr auto MIN_X{SoftwareOcclusion::WIDTH / 4};
+        static constexpr auto MAX_X{SoftwareOcclusion::WIDTH * 5 / 8};
+        static constexpr auto MIN_Y{SoftwareOcclusion::HEIGHT / 4};
+        static constexpr auto MAX_Y{SoftwareOcclusion::HEIGHT * 5 / 8};
+        auto scene = Scene{.name = "quad"};
+        addTriangle(scene, {-0.5f, -0.25f, QUAD_DEPTH}, {0.25f, -0.25f, QUAD_DEPTH}, {0.25f, 0.5f, QUAD_DEPTH});
+        addTriangle(scene, {-0.5f, -0.25f, QUAD_DEPTH}, {0.25f, 0.5f, QUAD_DEPTH}, {-0.5f, 0.5f, QUAD_DEPTH});
+        rasterize(occlusion, scene, workerPool);
+
+        auto different = 0u;
+        for (auto y = 0u; y < SoftwareOcclusion::HEIGHT; y++) {
+            for (auto x = 0u; x < SoftwareOcclusion::WIDTH; x++) {
+                const auto inside = x >= MIN_X && x < MAX_X && y >= MIN_Y && y < MAX_Y;
+                const auto expected = inside ? QUAD_DEPTH : 1.0f;
+                different += occlusion.getDepth()[y * SoftwareOcclusion::WIDTH + x] != expected ? 1 : 0;
+            }
+        }
+        // Boxes behind the quad, in front of it, and behind it but overflowing its edge
+        const auto behind = occlusion.isOccluded({-0.25f, 0.0f, 0.6f}, {0.0f, 0.25f, 0.7f});
+        const auto front = occlusion.isOccluded({-0.25f, 0.0f, 0.3f}, {0.0f, 0.25f, 0.4f});
+        const auto overflowing = occlusion.isOccluded({0.1f, 0.0f, 0.6f}, {0.4f, 0.25f, 0.7f});
+        const auto passed = different == 0 && behind && !front && !overflowing;
+        std::cout << (passed ? "  ok   " : "  FAIL ") << what << " : " << different << " wrong pixels, boxes "
+                  << (behind ? "" : "not ") << "occluded behind, "
+                  << (front ? "" : "not ") << "occluded in front, "
+                  << (overflowing ? "" : "not ") << "occluded overflowing" << std::endl;
+        return passed;
+    }
+
+    bool compare(const std::string& what, const std::vector<float>& depth, const std::vector<float>& expected) {
+        auto different = 0u;
+        auto largest = 0.0f;
+        for (auto i = 0u; i < PIXELS; i++) {
+            const auto difference = std::abs(depth[i] - expected[i]);
+            if (difference > DEPTH_TOLERANCE) {
+                different += 1;
+                largest = std::max(largest, difference);
+            }
+        }
+        const auto passed = different <= MAX_DIFFERENT_PIXELS;
+        std::cout << (passed ? "  ok   " : "  FAIL ") << what << " : " << different << " different pixels";
+        if (different > 0) {
+            std::cout << ", largest difference " << largest;
+        }
+        std::cout << std::endl;
+        return passed;
+    }
+
+    // Boxes on a grid covering the screen and the depth range
+    bool compareOcclusion(const SoftwareOcclusion& scalar, const SoftwareOcclusion& avx2) {
+        auto different = 0u;
+        auto occluded = 0u;
+        for (auto z = 0; z < 4; z++) {
+            for (auto y = 0; y < 16; y++) {
+                for (auto x = 0; x < 16; x++) {
+                    const auto boundsMin = glm::vec3{-1.0f + x * 0.125f, -1.0f + y * 0.125f, 0.1f + z * 0.25f};
+                    const auto boundsMax = boundsMin + glm::vec3{0.1f, 0.1f, 0.05f};
+                    const auto expected = scalar.isOccluded(boundsMin, boundsMax);
+                    occluded += expected ? 1 : 0;
+                    different += expected != avx2.isOccluded(boundsMin, boundsMax) ? 1 : 0;
+                }
+            }
+        }
+        std::cout << (different == 0 ? "  ok   " : "  FAIL ") << "occlusion tests : " << different
+                  << " different results, " << occluded << " occluded boxes" << std::endl;
+        return different == 0;
+    }
+
+    std::vector<float> readReference(const std::filesystem::path& path) {
+        auto file = std::ifstream{path, std::ios::binary};
+        auto depth = std::vector<float>(PIXELS);
+        if (!file.read(reinterpret_cast<char*>(depth.data()), PIXELS * sizeof(float))) {
+            throw std::runtime_error("Cannot read the reference depth buffer " + path.string());
+        }
+        return depth;
+    }
+
+    void writeReference(const std::filesystem::path& path, const std::vector<float>& depth) {
+        auto file = std::ofstream{path, std::ios::binary};
+        if (!file.write(reinterpret_cast<const char*>(depth.data()), PIXELS * sizeof(float))) {
+            throw std::runtime_error("Cannot write the reference depth buffer " + path.string());
+        }
+    }
+
+}
+
+int main(const int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage : software_occlusion_test <references directory> [--generate]" << std::endl;
+        return 2;
+    }
+    const auto directory = std::filesystem::path{argv[1]};
+    const auto generate = argc > 2 && std::string{argv[2]} == "--generate";
+    auto workerPool = samples::WorkerPool{};
+    auto passed = true;
+    try {
+        std::cout << "AVX2 " << (SoftwareOcclusion::isAvx2Supported() ? "supported" : "not supported") << std::endl;
+        std::cout << "quad" << std::endl;
+        auto scalarQuad = SoftwareOcclusion{};
+        scalarQuad.setAvx2Enabled(false);
+        passed = checkQuad("scalar / analytic", scalarQuad, workerPool) && passed;
+        if (SoftwareOcclusion::isAvx2Supported()) {
+            auto avx2Quad = SoftwareOcclusion{};
+            avx2Quad.setAvx2Enabled(true);
+            passed = checkQuad("AVX2 / analytic", avx2Quad, workerPool) && passed;
+        }
+        for (const auto& scene : {makeOverlapScene(), makeRandomScene()}) {
+            std::cout << scene.name << std::endl;
+            const auto path = directory / ("software_occlusion_" + scene.name + ".depth");
+            auto scalar = SoftwareOcclusion{};
+            scalar.setAvx2Enabled(false);
+            rasterize(scalar, scene, workerPool);
+            if (generate) {
+                // Written from the scalar path
+                writeReference(path, scalar.getDepth());
+                std::cout << "  reference written to " << path.string() << std::endl;
+                continue;
+            }
+            const auto reference = readReference(path);
+            passed = compare("scalar / reference", scalar.getDepth(), reference) && passed;
+            if (SoftwareOcclusion::isAvx2Supported()) {
+                auto avx2 = SoftwareOcclusion{};
+                avx2.setAvx2Enabled(true);
+                rasterize(avx2, scene, workerPool);
+                passed = compare("AVX2 / reference", avx2.getDepth(), reference) && passed;
+                passed = compare("AVX2 / scalar", avx2.getDepth(), scalar.getDepth()) && passed;
+                passed = compareOcclusion(scalar, avx2) && passed;
+            }
+        }
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
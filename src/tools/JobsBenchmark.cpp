@@ -0,0 +1,154 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+#include <glm/gtc/matrix_transform.hpp>
+import std;
+import glm;
+import samples.common.bvh;
+import samples.common.drawlist;
+import samples.common.instances;
+import samples.common.workerpool;
+
+// Scaling of the samples::WorkerPool jobs from one to all the cores, on synthetic workloads and on the
+// CPU part of the scene updates of the stress mode (transforms, BVH refit, frustum culling and draws sort).
+// Usage : jobs_benchmark [max threads]
+namespace {
+
+    using samples::WorkerPool;
+
+    constexpr auto RUNS{15};
+
+    // Median time of the runs, after a warm-up run
+    double measure(const std::function<void()>& run) {
+        run();
+        auto times = std::vector<double>{};
+        for (auto i = 0; i < RUNS; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::ranges::nth_element(times, times.begin() + RUNS / 2);
+        return times[RUNS / 2];
+    }
+
+    float work(const std::size_t index, const std::uint32_t iterations) {
+        auto value = static_cast<float>(index);
+        for (auto i = 0u; i < iterations; i++) {
+            value = std::sqrt(value * 1.0001f + std::sin(value));
+        }
+        return value;
+    }
+
+    // Data-parallel loop in small batches
+    class ParallelForWorkload {
+    public:
+        static constexpr auto name{"parallel for, 4M elements"};
+
+        void run(WorkerPool& pool) {
+            pool.parallelFor(results.size(), 4096, [this](const std::size_t begin, const std::size_t end) {
+                for (auto i = begin; i < end; i++) {
+                    results[i] = work(i, 8);
+                }
+            });
+        }
+
+    private:
+        std::vector<float> results = std::vector<float>(4 * 1024 * 1024);
+    };
+
+    // Four stages of independent jobs, each stage depending on the previous one
+    class JobGraphWorkload {
+    public:
+        static constexpr auto name{"job graph, 4 x 1024 jobs"};
+
+        void run(WorkerPool& pool) {
+            static constexpr auto STAGES{4};
+            static constexpr auto JOBS{1024};
+            auto counters = std::array<WorkerPool::Counter, STAGES>{};
+            for (auto stage = 0; stage < STAGES; stage++) {
+                for (auto job = 0; job < JOBS; job++) {
+                    auto function = [this, job] { results[job] += work(job, 2000); };
+                    if (stage == 0) {
+                        pool.submit(function, &counters[stage]);
+                    } else {
+                        pool.submitAfter(counters[stage - 1], function, &counters[stage]);
+                    }
+                }
+            }
+            // The counters must be waited for before being destroyed
+            for (auto& counter : counters) {
+                pool.wait(counter);
+            }
+        }
+
+    private:
+        std::vector<float> results = std::vector<float>(1024);
+    };
+
+    // Stress mode of the samples::Scene : clusters of a spinning root cube with three orbiting children
+    class SceneUpdateWorkload {
+    public:
+        static constexpr auto name{"scene update, 100k instances"};
+
+        SceneUpdateWorkload() {
+            // Four instances per cluster
+            instances.addClusters(100000 / 4);
+            auto workerPool = WorkerPool{0};
+            instances.update(0.0f, workerPool);
+            bvh.build(instances.getWorldBoundsMin(), instances.getWorldBoundsMax());
+            view = glm::lookAt(glm::vec3{0.0f, 0.0f, 2.0f}, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+            viewProjection = glm::perspective(glm::radians(75.0f), 16.0f / 9.0f, 0.05f, 50.0f) * view;
+        }
+
+        void run(WorkerPool& pool) {
+            instances.update(1.0f / 60.0f, pool);
+            bvh.refit(instances.getWorldBoundsMin(), instances.getWorldBoundsMax(), instances.getChangedInstances());
+            bvh.cull(viewProjection, visible);
+            drawList.clear();
+            const auto& worldMatrices = instances.getWorldMatrices();
+            for (const auto index : visible) {
+                drawList.add(samples::DrawList::makeKey(1, 0, 0, 0, -(view * worldMatrices[index][3]).z), index);
+            }
+            drawList.sort(pool);
+        }
+
+    private:
+        samples::InstanceStore     instances;
+        samples::BVH               bvh;
+        samples::DrawList          drawList;
+        std::vector<std::uint32_t> visible;
+        glm::mat4                  view;
+        glm::mat4                  viewProjection;
+    };
+
+    template <typename Workload>
+    void benchmark(const std::uint32_t maxThreads) {
+        std::cout << Workload::name << std::endl;
+        auto workload = Workload{};
+        auto reference = 0.0;
+        for (auto threads = 1u; threads <= maxThreads; threads++) {
+            // The calling thread is one of the threads
+            auto pool = WorkerPool{threads - 1};
+            const auto time = measure([&] { workload.run(pool); });
+            if (threads == 1) {
+                reference = time;
+            }
+            std::cout << "  " << threads << " threads : " << time << " ms, speedup " << reference / time << std::endl;
+        }
+    }
+
+}
+
+int main(const int argc, char** argv) {
+    auto maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1) {
+        maxThreads = std::max(1, std::atoi(argv[1]));
+    }
+    benchmark<ParallelForWorkload>(maxThreads);
+    benchmark<JobGraphWorkload>(maxThreads);
+    benchmark<SceneUpdateWorkload>(maxThreads);
+    return 0;
+}
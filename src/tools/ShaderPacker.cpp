@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+import std;
+import samples.common.shaderarchive;
+
+// Packs the compiled shaders of one backend into an archive read by samples::ShaderArchive
+// Usage : shader_packer <archive> <binary>...
+int main(const int argc, char** argv) {
+    using samples::ShaderArchive;
+    if (argc < 2) {
+        std::cerr << "Usage : shader_packer <archive> <binary>..." << std::endl;
+        return 1;
+    }
+
+    struct Shader {
+        std::string            name;
+        std::vector<std::byte> code;
+    };
+    auto shaders = std::vector<Shader>{};
+    for (auto i = 2; i < argc; i++) {
+        const auto path = std::filesystem::path{argv[i]};
+        auto file = std::ifstream{path, std::ios::binary};
+        if (!file) {
+            std::cerr << "Cannot read " << path << std::endl;
+            return 1;
+        }
+        auto shader = Shader{};
+        // "quad.vert.spv" is stored as "quad.vert"
+        shader.name = path.stem().string();
+        shader.code.resize(std::filesystem::file_size(path));
+        file.read(reinterpret_cast<char*>(shader.code.data()), static_cast<std::streamsize>(shader.code.size()));
+        shaders.push_back(std::move(shader));
+    }
+    std::ranges::sort(shaders, {}, &Shader::name);
+
+    auto names = std::string{};
+    for (const auto& shader : shaders) {
+        names += shader.name;
+    }
+    const auto align = [](const std::uint64_t offset) {
+        return (offset + ShaderArchive::ALIGNMENT - 1) & ~(ShaderArchive::ALIGNMENT - 1);
+    };
+
+    // Identical binaries share the same offset
+    auto entries = std::vector<ShaderArchive::Entry>{};
+    auto blobs = std::vector<const Shader*>{};
+    auto nameOffset = std::uint32_t{0};
+    auto offset = align(sizeof(ShaderArchive::Header) + shaders.size() * sizeof(ShaderArchive::Entry) + names.size());
+    for (const auto& shader : shaders) {
+        auto entry = ShaderArchive::Entry{
+            nameOffset,
+            static_cast<std::uint32_t>(shader.name.size()),
+            offset,
+            shader.code.size(),
+        };
+        nameOffset += entry.nameSize;
+        const auto same = std::ranges::find_if(blobs, [&](const Shader* blob) { return blob->code == shader.code; });
+        if (same != blobs.end()) {
+            entry.offset = entries[std::distance(blobs.begin(), same)].offset;
+            blobs.push_back(*same);
+        } else {
+            blobs.push_back(&shader);
+            offset = align(offset + shader.code.size());
+        }
+        entries.push_back(entry);
+    }
+
+    auto file = std::ofstream{argv[1], std::ios::binary | std::ios::trunc};
+    if (!file) {
+        std::cerr << "Cannot write " << argv[1] << std::endl;
+        return 1;
+    }
+    const auto header = ShaderArchive::Header{
+        ShaderArchive::MAGIC,
+        ShaderArchive::VERSION,
+        static_cast<std::uint32_t>(entries.size()),
+        static_cast<std::uint32_t>(names.size()),
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ShaderArchive::Entry)));
+    file.write(names.data(), static_cast<std::streamsize>(names.size()));
+    for (auto i = 0uz; i < entries.size(); i++) {
+        const auto& entry = entries[i];
+        if (static_cast<std::uint64_t>(file.tellp()) > entry.offset) {
+            // Shared binary, already written
+            continue;
+        }
+        const auto padding = std::vector<char>(entry.offset - static_cast<std::uint64_t>(file.tellp()), 0);
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.write(reinterpret_cast<const char*>(blobs[i]->code.data()), static_cast<std::streamsize>(entry.size));
+    }
+    return file ? 0 : 1;
+}